@@ -0,0 +1,47 @@
+"""
+Measure the cost of importing micpy and of the first device operation.
+
+Every sample runs in a fresh interpreter, so the offload runtime starts
+from scratch each time.
+
+    python benchmarks/import_time.py [-n RUNS]
+"""
+from __future__ import print_function
+
+import argparse
+import subprocess
+import sys
+
+_snippet = r"""
+import time
+t0 = time.time()
+import micpy
+import micpy.random
+t1 = time.time()
+a = micpy.zeros(16)
+t2 = time.time()
+print(t1 - t0, t2 - t1)
+"""
+
+
+def run_once():
+    out = subprocess.check_output([sys.executable, '-c', _snippet])
+    imp, first = out.decode().split()
+    return float(imp), float(first)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    parser.add_argument('-n', '--runs', type=int, default=5)
+    args = parser.parse_args()
+
+    samples = [run_once() for _ in range(args.runs)]
+    imports = sorted(s[0] for s in samples)
+    firsts = sorted(s[1] for s in samples)
+    mid = len(samples) // 2
+    print("import micpy     : min %.3fs median %.3fs" % (imports[0], imports[mid]))
+    print("first device op  : min %.3fs median %.3fs" % (firsts[0], firsts[mid]))
+
+
+if __name__ == '__main__':
+    main()
@@ -9,13 +9,43 @@ if __MICPY_SETUP__:
     import sys
     sys.stderr.write('Running from micpy source directory.\n')
 else:
+    import os as _os
+    import sys as _sys
+
+    # Load the offload image on a device only when something is first
+    # offloaded to it, instead of on every device at startup.
+    _os.environ.setdefault('OFFLOAD_INIT', 'on_offload')
+
     from .multiarray import *
     from .umath import *
-    from .numeric import (full, full_like, asarray,
+    from .numeric import (full, full_like, identity, items, asarray,
                           rollaxis, moveaxis, argmax, argmin)
     from .shape_base import (expand_dims)
+    from .device import (Device, device_scalars, device_threads, prefetch)
+    from .mirror import (MirroredArray, mirror)
+    from .vector import DeviceVector
+    from .npyio import (load, save)
+    from .dispatch import (FallbackWarning, set_fallback_warning)
+    from . import autotune
+    from . import comm
     from numpy import (int, int_, int8, int16, int32, int64,
                        uint, uint8, uint16, uint32, uint64,
                        float, float_, float16, float32, float64,
                        complex, complex_, complex64, complex128,
                        byte, short, long, longlong, intp, double, longdouble)
+
+    autotune.load()
+
+    # ndevices is resolved on access so that importing micpy does not
+    # start the offload runtime. Module __getattr__ needs Python 3.7;
+    # older versions still count the devices, and so start the runtime,
+    # at import.
+    if _sys.version_info >= (3, 7):
+        def __getattr__(name):
+            if name == 'ndevices':
+                return get_ndevices()
+            raise AttributeError("module %r has no attribute %r"
+                                 % (__name__, name))
+    else:
+        ndevices = get_ndevices()
+    del _os, _sys
@@ -0,0 +1,198 @@
+"""
+Autotuning of the ufunc inner loops.
+
+The OpenMP loops of the ufuncs read their team size, schedule chunk and
+serial cutoff from a table kept in the umath module. `autotune` measures
+the best parameters per (ufunc, dtype, size bucket, device), `save` writes
+the table to a JSON cache file and `load` restores it. The cache is loaded
+when micpy is imported.
+
+The cache file is ``$MICPY_TUNING_CACHE`` if set, otherwise
+``~/.micpy/loop_tuning.json``.
+"""
+import os
+import json
+import time
+import warnings
+
+import numpy as np
+from . import multiarray
+from . import umath
+
+__all__ = ['autotune', 'load', 'save', 'clear', 'cache_path']
+
+_default_ufuncs = ('add', 'subtract', 'multiply', 'divide', 'sqrt', 'exp')
+_default_dtypes = ('float32', 'float64')
+_default_sizes = (1 << 10, 1 << 14, 1 << 18, 1 << 22)
+_default_threads = (0, 16, 60, 120, 240)
+_default_chunks = (64, 256, 1024, 4096)
+
+
+def cache_path():
+    """Return the path of the loop tuning cache file."""
+    path = os.environ.get('MICPY_TUNING_CACHE')
+    if path:
+        return path
+    return os.path.join(os.path.expanduser('~'), '.micpy',
+                        'loop_tuning.json')
+
+
+def _bucket(n):
+    return max(int(n).bit_length() - 1, 0)
+
+
+def load(path=None):
+    """
+    Load a loop tuning cache file into the umath tuning table.
+
+    Missing files are ignored, invalid files and entries are skipped
+    with a RuntimeWarning.
+
+    Returns
+    -------
+    n : int
+        Number of entries loaded.
+    """
+    if path is None:
+        path = cache_path()
+    if not os.path.exists(path):
+        return 0
+
+    try:
+        with open(path) as f:
+            entries = json.load(f)['entries']
+    except (IOError, OSError, ValueError, KeyError) as e:
+        warnings.warn("ignoring invalid loop tuning cache %s: %s" % (path, e),
+                      RuntimeWarning, stacklevel=2)
+        return 0
+
+    if not isinstance(entries, list):
+        warnings.warn("ignoring invalid loop tuning cache %s: entries is "
+                      "not a list" % path, RuntimeWarning, stacklevel=2)
+        return 0
+
+    # one bad entry must not keep micpy from importing
+    n = 0
+    for e in entries:
+        try:
+            umath._set_loop_tuning(e['ufunc'], e['dtype'], e['bucket'],
+                                   e['device'], e['nthreads'], e['chunk'],
+                                   e['cutoff'])
+        except (KeyError, ValueError, TypeError) as err:
+            warnings.warn("ignoring loop tuning cache entry %r of %s: %s"
+                          % (e, path, err), RuntimeWarning, stacklevel=2)
+            continue
+        n += 1
+    return n
+
+
+def save(path=None):
+    """Write the current umath tuning table to a cache file."""
+    if path is None:
+        path = cache_path()
+    dirname = os.path.dirname(path)
+    if dirname and not os.path.isdir(dirname):
+        os.makedirs(dirname)
+
+    entries = [dict(ufunc=name, dtype=dtype.str, bucket=bucket,
+                    device=device, nthreads=nthreads, chunk=chunk,
+                    cutoff=cutoff)
+               for name, dtype, bucket, device, nthreads, chunk, cutoff
+               in umath._get_loop_tuning()]
+    with open(path, 'w') as f:
+        json.dump({'version': 1, 'entries': entries}, f, indent=1)
+    return path
+
+
+def clear():
+    """Reset all ufunc loops to the default parameters."""
+    umath._clear_loop_tuning()
+
+
+def _time_call(func, args, repeat):
+    best = float('inf')
+    for _ in range(repeat):
+        t = time.time()
+        func(*args)
+        best = min(best, time.time() - t)
+    return best
+
+
+def autotune(ufuncs=_default_ufuncs, dtypes=_default_dtypes,
+             sizes=_default_sizes, devices=None,
+             threads=_default_threads, chunks=_default_chunks,
+             repeat=5, save_cache=True, path=None):
+    """
+    Measure the best inner loop parameters for a set of ufuncs.
+
+    For every ufunc, dtype, size and device all combinations of `threads`
+    and `chunks` are timed, together with a serial run. The fastest one
+    is stored for the size bucket ``floor(log2(size))``.
+
+    Parameters
+    ----------
+    ufuncs : sequence of str
+        Names of the micpy ufuncs to tune.
+    dtypes : sequence of dtype
+        Loop data types to tune.
+    sizes : sequence of int
+        Number of elements of the benchmark arrays.
+    devices : sequence of int, optional
+        Devices to tune, all devices by default.
+    threads : sequence of int
+        Candidate team sizes, 0 being the runtime default.
+    chunks : sequence of int
+        Candidate schedule chunk sizes in bytes.
+    repeat : int
+        Number of timed runs per candidate, the best one is used.
+    save_cache : bool
+        Write the result to the cache file.
+    path : str, optional
+        Cache file, see `cache_path`.
+
+    Returns
+    -------
+    result : list of dict
+        The chosen parameters with their timing.
+    """
+    if devices is None:
+        devices = range(multiarray.get_ndevices())
+
+    result = []
+    for device in devices:
+        for dtype in dtypes:
+            dtype = np.dtype(dtype)
+            for name in ufuncs:
+                func = getattr(umath, name)
+                for size in sizes:
+                    bucket = _bucket(size)
+                    ins = [multiarray.ones(size, dtype=dtype, device=device)
+                           for _ in range(func.nin)]
+                    out = multiarray.empty(size, dtype=dtype, device=device)
+                    args = tuple(ins) + (out,)
+
+                    # serial run: the cutoff covers the whole bucket
+                    serial = dict(nthreads=0, chunk=256,
+                                  cutoff=(2 << bucket) - 1)
+                    candidates = [serial] + [
+                            dict(nthreads=t, chunk=c, cutoff=0)
+                            for t in threads for c in chunks]
+
+                    best, best_time = None, float('inf')
+                    for cand in candidates:
+                        umath._set_loop_tuning(name, dtype, bucket, device,
+                                               **cand)
+                        func(*args)     # warm up
+                        t = _time_call(func, args, repeat)
+                        if t < best_time:
+                            best, best_time = cand, t
+
+                    umath._set_loop_tuning(name, dtype, bucket, device,
+                                           **best)
+                    result.append(dict(best, ufunc=name, dtype=dtype.str,
+                                       bucket=bucket, device=device,
+                                       time=best_time))
+
+    if save_cache:
+        save(path)
+    return result
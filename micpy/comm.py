@@ -0,0 +1,284 @@
+"""
+Collective operations over arrays living on different devices.
+
+The collectives take one array per device, all of the same shape and
+dtype. Data moves between devices with peer copies (see
+`ndarray.copy_to_device`) and reductions run on the devices with the
+micpy ufuncs, so nothing goes through NumPy on the host.
+
+`allreduce` and `allgather` use the ring algorithm: the arrays are cut
+into one segment per device and, at every step, each device sends one
+segment to the next device of the ring. The copies of a step run
+concurrently, each one being itself chunked and double-buffered.
+`broadcast` uses a binomial tree.
+
+Examples
+--------
+Average the gradients computed on every device:
+
+>>> grads = [g0, g1]            # on devices 0 and 1
+>>> mp.comm.allreduce(grads, op='mean', inplace=True)
+"""
+import threading
+
+from . import multiarray
+from . import umath
+
+__all__ = ['allreduce', 'broadcast', 'scatter', 'gather', 'allgather']
+
+_reduce_ops = {
+    'sum': umath.add,
+    'mean': umath.add,
+    'prod': umath.multiply,
+    'max': umath.maximum,
+    'min': umath.minimum,
+}
+
+
+def _parallel(func, items):
+    """Call func on every item, each in its own thread."""
+    items = list(items)
+    if len(items) == 1:
+        func(*items[0])
+        return
+    errors = []
+
+    def run(args):
+        try:
+            func(*args)
+        except BaseException as e:
+            errors.append(e)
+
+    threads = [threading.Thread(target=run, args=(args,)) for args in items]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    if errors:
+        raise errors[0]
+
+
+def _check_arrays(arrays):
+    arrays = list(arrays)
+    if not arrays:
+        raise ValueError("need at least one array")
+    first = arrays[0]
+    devices = set()
+    for a in arrays:
+        if not isinstance(a, multiarray.ndarray):
+            raise TypeError("collectives take micpy arrays")
+        if a.shape != first.shape or a.dtype != first.dtype:
+            raise ValueError("arrays must have the same shape and dtype")
+        if not a.flags.c_contiguous:
+            raise ValueError("arrays must be C contiguous")
+        if a.device in devices:
+            raise ValueError("arrays must be on distinct devices")
+        devices.add(a.device)
+    return arrays
+
+
+def _segments(size, n):
+    """Bounds of n nearly equal segments of range(size)."""
+    step, extra = divmod(size, n)
+    bounds = [0]
+    for i in range(n):
+        bounds.append(bounds[-1] + step + (1 if i < extra else 0))
+    return [(bounds[i], bounds[i + 1]) for i in range(n)]
+
+
+def _flat_segment(a, segment):
+    return multiarray._flat_chunk(a, segment[0], segment[1])
+
+
+def allreduce(arrays, op='sum', inplace=False):
+    """
+    Reduce arrays element-wise and leave the result on every device.
+
+    Parameters
+    ----------
+    arrays : sequence of ndarray
+        One array per device, same shape and dtype. They must be C
+        contiguous when `inplace` is set.
+    op : {'sum', 'mean', 'prod', 'max', 'min'}
+        Reduction, computed on the devices. 'mean' divides in place, so
+        it needs a floating point or complex dtype.
+    inplace : bool
+        Write the result into `arrays` instead of new arrays.
+
+    Returns
+    -------
+    result : list of ndarray
+        The reduced array, once on every device.
+    """
+    try:
+        ufunc = _reduce_ops[op]
+    except KeyError:
+        raise ValueError("op must be one of %s" % sorted(_reduce_ops))
+
+    if not inplace:
+        arrays = [a.copy() for a in arrays]
+    arrays = _check_arrays(arrays)
+    if op == 'mean' and arrays[0].dtype.kind not in 'fc':
+        # checked before the ring runs, the division could not cast back
+        raise TypeError("op='mean' needs a floating point or complex "
+                        "dtype, not %s" % arrays[0].dtype)
+    n = len(arrays)
+    if n > 1:
+        segs = _segments(arrays[0].size, n)
+        # receive buffers, one segment long
+        tmp = [multiarray.empty(segs[0][1] - segs[0][0],
+                                dtype=a.dtype, device=a.device)
+               for a in arrays]
+
+        def reduce_step(i, s):
+            # device i+1 reduces segment (i - s) % n sent by device i
+            seg = segs[(i - s) % n]
+            dst = arrays[(i + 1) % n]
+            buf = multiarray._flat_chunk(tmp[(i + 1) % n], 0,
+                                         seg[1] - seg[0])
+            multiarray.copyto(buf, _flat_segment(arrays[i], seg))
+            own = _flat_segment(dst, seg)
+            ufunc(own, buf, own)
+
+        def gather_step(i, s):
+            # device i sends its complete segment (i + 1 - s) % n
+            seg = segs[(i + 1 - s) % n]
+            multiarray.copyto(_flat_segment(arrays[(i + 1) % n], seg),
+                              _flat_segment(arrays[i], seg))
+
+        # reduce-scatter: device i ends with segment (i + 1) % n reduced
+        for s in range(n - 1):
+            _parallel(reduce_step, [(i, s) for i in range(n)])
+        # all-gather of the reduced segments
+        for s in range(n - 1):
+            _parallel(gather_step, [(i, s) for i in range(n)])
+
+    if op == 'mean':
+        for a in arrays:
+            umath.true_divide(a, n, a)
+    return arrays
+
+
+def broadcast(array, devices):
+    """
+    Copy array to every device of `devices`.
+
+    Devices that received the data send it on, doubling the number of
+    copies in flight at each round.
+
+    Returns
+    -------
+    result : list of ndarray
+        One array per device of `devices`, `array` itself for its own
+        device.
+    """
+    devices = list(devices)
+    have = {array.device: array}
+    todo = [d for d in devices if d not in have]
+    while todo:
+        sources = list(have.values())
+        pairs = list(zip(sources, todo[:len(sources)]))
+        todo = todo[len(sources):]
+        results = {}
+
+        def send(src, device):
+            results[device] = src.copy_to_device(device)
+
+        _parallel(send, pairs)
+        have.update(results)
+    return [have[d] for d in devices]
+
+
+def scatter(array, devices):
+    """
+    Split array along its first axis into one part per device.
+
+    Returns
+    -------
+    result : list of ndarray
+        The parts, on the devices of `devices` in order.
+    """
+    devices = list(devices)
+    if array.ndim == 0:
+        raise ValueError("cannot scatter a 0-d array")
+    if not array.flags.c_contiguous:
+        array = array.copy()
+    rows = _segments(array.shape[0], len(devices))
+    row_size = array.size // array.shape[0] if array.shape[0] else 0
+    results = [None] * len(devices)
+
+    def send(k, device):
+        lo, hi = rows[k]
+        part = multiarray._flat_chunk(array, lo * row_size, hi * row_size)
+        part = part.reshape((hi - lo,) + array.shape[1:])
+        results[k] = part.copy_to_device(device)
+
+    _parallel(send, list(enumerate(devices)))
+    return results
+
+
+def gather(arrays, device):
+    """
+    Concatenate arrays along their first axis on one device.
+
+    The arrays must have the same dtype and the same shape apart from the
+    first axis.
+    """
+    arrays = list(arrays)
+    first = arrays[0]
+    if first.ndim == 0:
+        raise ValueError("cannot gather 0-d arrays")
+    for a in arrays:
+        if a.dtype != first.dtype or a.shape[1:] != first.shape[1:]:
+            raise ValueError("arrays must have the same dtype and the "
+                             "same shape apart from the first axis")
+    nrows = sum(a.shape[0] for a in arrays)
+    out = multiarray.empty((nrows,) + first.shape[1:], dtype=first.dtype,
+                           device=device)
+    offsets, pos = [], 0
+    for a in arrays:
+        offsets.append(pos)
+        pos += a.size
+
+    def recv(a, offset):
+        part = multiarray._flat_chunk(out, offset, offset + a.size)
+        multiarray.copyto(part.reshape(a.shape), a)
+
+    _parallel(recv, zip(arrays, offsets))
+    return out
+
+
+def allgather(arrays):
+    """
+    Concatenate arrays along their first axis, on every device.
+
+    Returns
+    -------
+    result : list of ndarray
+        The concatenation, once on the device of each input array.
+    """
+    arrays = _check_arrays([a if a.flags.c_contiguous else a.copy()
+                            for a in arrays])
+    n = len(arrays)
+    part = arrays[0].size
+    shape = (arrays[0].shape[0] * n,) + arrays[0].shape[1:] \
+        if arrays[0].ndim else (n,)
+    outs = [multiarray.empty(shape, dtype=a.dtype, device=a.device)
+            for a in arrays]
+
+    def own(i):
+        seg = multiarray._flat_chunk(outs[i], i * part, (i + 1) * part)
+        multiarray.copyto(seg.reshape(arrays[i].shape), arrays[i])
+
+    def step(i, s):
+        # device i sends part (i - s) % n to the next device
+        k = (i - s) % n
+        src = multiarray._flat_chunk(outs[i], k * part, (k + 1) * part)
+        dst = multiarray._flat_chunk(outs[(i + 1) % n], k * part,
+                                     (k + 1) * part)
+        multiarray.copyto(dst, src)
+
+    _parallel(own, [(i,) for i in range(n)])
+    for s in range(n - 1):
+        _parallel(step, [(i, s) for i in range(n)])
+    return outs
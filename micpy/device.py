@@ -0,0 +1,286 @@
+"""
+Device related helpers.
+"""
+import threading
+from contextlib import contextmanager
+
+from . import multiarray
+
+__all__ = ['Device', 'PeerCopy', 'Prefetch', 'device_scalars',
+           'device_threads', 'prefetch']
+
+
+class Device(object):
+    """
+    Context manager making a device the current device of the calling
+    thread.
+
+    The current device is thread-local: it is the default device of
+    `empty`, `zeros`, `to_mic`, the random generators and the other
+    functions taking a `device` argument, for the thread that set it
+    only. The previous current device is restored on exit, so blocks
+    can be nested.
+
+    Parameters
+    ----------
+    device : int
+        Device number, in ``range(get_ndevices())``.
+
+    Examples
+    --------
+    >>> def work(i):
+    ...     with mp.Device(i):
+    ...         a = mp.zeros(1000)    # on device i
+    >>> threads = [threading.Thread(target=work, args=(i,))
+    ...            for i in range(mp.get_ndevices())]
+    """
+
+    def __init__(self, device):
+        device = int(device)
+        if not 0 <= device < multiarray.get_ndevices():
+            raise ValueError("device must be in range [0,%d)"
+                             % multiarray.get_ndevices())
+        self.id = device
+        # one stack of saved devices per thread, as the current device
+        # is per thread and a Device may be shared between threads
+        self._local = threading.local()
+
+    def _previous(self):
+        try:
+            return self._local.previous
+        except AttributeError:
+            self._local.previous = []
+            return self._local.previous
+
+    def __enter__(self):
+        self._previous().append(multiarray.device())
+        multiarray.set_device(self.id)
+        return self
+
+    def __exit__(self, *exc):
+        multiarray.set_device(self._previous().pop())
+
+    def __int__(self):
+        return self.id
+
+    __index__ = __int__
+
+    def __eq__(self, other):
+        return isinstance(other, Device) and other.id == self.id
+
+    def __ne__(self, other):
+        return not self == other
+
+    def __hash__(self):
+        return hash(self.id)
+
+    def __repr__(self):
+        return "<micpy.Device %d>" % self.id
+
+
+@contextmanager
+def device_threads(device, n, affinity=None, core_offset=0):
+    """
+    Context manager form of `set_device_threads`.
+
+    The thread team and affinity of `device` are changed on enter and
+    restored on exit. For a device that was not configured before, exit
+    brings back the team size of the runtime and unpins the threads.
+
+    The team size stays set for the later launches because the offload
+    runtime keeps the OpenMP settings of its threads from one target
+    region to the next; the thread placement holds in any case.
+
+    Parameters
+    ----------
+    device : int
+        Device number.
+    n : int
+        Number of threads, 0 means all hardware threads of the device
+        from `core_offset` on.
+    affinity : {'compact', 'scatter', 'balanced', None}, optional
+        Thread placement over the cores of the device.
+    core_offset : int, optional
+        First core to place threads on, to share a device between jobs.
+
+    Examples
+    --------
+    >>> with mp.device_threads(0, 60, affinity='scatter'):
+    ...     c = a + b
+    """
+    previous = multiarray.get_device_threads(device)
+    multiarray.set_device_threads(device, n, affinity, core_offset)
+    try:
+        yield
+    finally:
+        if previous is None:
+            multiarray.reset_device_threads(device)
+        else:
+            old_n, old_affinity, old_offset = previous
+            if old_affinity == 'none':
+                old_affinity = None
+            multiarray.set_device_threads(device, old_n, old_affinity,
+                                          old_offset)
+
+
+@contextmanager
+def device_scalars(enabled=True):
+    """
+    Context manager keeping 0-d results on the device.
+
+    Reductions such as `sum` or `max`, and `dot` of vectors, return a
+    Python scalar, which costs a device to host copy each time. Inside
+    the block they return 0-d device arrays instead, which can feed the
+    next device operation directly. The value is read only when Python
+    needs it, through ``float()``, ``int()``, ``bool()`` or as an index.
+
+    The setting is per thread, like the current device.
+
+    Examples
+    --------
+    >>> with mp.device_scalars():
+    ...     norm = mp.sqrt((a * a).sum())    # stays on the device
+    ...     a /= norm
+    >>> float(norm)                          # read back here
+    """
+    previous = multiarray.set_device_scalars(enabled)
+    try:
+        yield
+    finally:
+        multiarray.set_device_scalars(previous)
+
+
+class _Background(object):
+    """
+    Handle of a transfer running in a background thread. The transfers
+    release the GIL, so the calling thread keeps running Python code, and
+    may start other transfers, while they run.
+
+    With no `func`, the handle is created finished, with `result`.
+    """
+
+    def __init__(self, func=None, args=(), result=None):
+        self._result = result
+        self._error = None
+        self._thread = None
+        if func is not None:
+            self._thread = threading.Thread(target=self._run,
+                                            args=(func, args))
+            self._thread.daemon = True
+            self._thread.start()
+
+    def _run(self, func, args):
+        try:
+            self._result = func(*args)
+        except BaseException as e:
+            self._error = e
+
+    def done(self):
+        """Return True if the transfer has finished."""
+        return self._thread is None or not self._thread.is_alive()
+
+    def wait(self, timeout=None):
+        """
+        Wait for the transfer and return its array.
+
+        Raises the error of the transfer if it failed.
+        """
+        if self._thread is not None:
+            self._thread.join(timeout)
+            if self._thread.is_alive():
+                raise RuntimeError("%s still running" % self._what())
+        if self._error is not None:
+            raise self._error
+        return self._result
+
+
+class PeerCopy(_Background):
+    """
+    Handle of a copy to another device running in the background, as
+    returned by ``ndarray.copy_to_device(device, async_=True)``.
+    """
+
+    def __init__(self, src, device):
+        self.device = device
+        self.stats = None
+        _Background.__init__(self, self._copy, (src,))
+
+    def _copy(self, src):
+        result = src.copy_to_device(self.device)
+        # the statistics are kept per thread
+        self.stats = multiarray.peer_copy_stats()
+        return result
+
+    def _what(self):
+        return "copy to device %d" % self.device
+
+    @property
+    def bandwidth(self):
+        """Achieved bandwidth of the copy in bytes per second."""
+        self.wait()
+        return self.stats['bandwidth'] if self.stats else 0.0
+
+
+def _copy_async(src, device):
+    return PeerCopy(src, device)
+
+
+class Prefetch(_Background):
+    """
+    Handle of a prefetch running in the background, as returned by
+    ``prefetch(array, async_=True)``. `wait` returns the array.
+    """
+
+    def __init__(self, array):
+        if array.resident:
+            _Background.__init__(self, result=array)
+        else:
+            _Background.__init__(self, self._fetch, (array,))
+
+    @staticmethod
+    def _fetch(array):
+        multiarray._fetch(array)
+        return array
+
+    def _what(self):
+        return "prefetch"
+
+
+def prefetch(array, device=None, async_=True):
+    """
+    Get an array ready on a device ahead of its use.
+
+    An array the residency manager moved to the host (see
+    `set_residency`) is brought back to its device, and becomes the most
+    recently used array of that device. A resident array is left alone.
+    With a `device` other than the one of the array, it is copied there,
+    like ``array.copy_to_device(device)``.
+
+    Parameters
+    ----------
+    array : ndarray
+        Array to prefetch.
+    device : int, optional
+        Device to prefetch to, the device of the array by default.
+    async_ : bool, optional
+        Run the transfer in the background and return a handle at once.
+
+    Returns
+    -------
+    out : ndarray, Prefetch or PeerCopy
+        The array on `device`, or the handle of the transfer when `async_`
+        is set; ``out.wait()`` returns the array.
+
+    Examples
+    --------
+    >>> nxt = mp.prefetch(weights[i + 1])    # while step i computes
+    >>> step(x, weights[i])
+    >>> w = nxt.wait()
+    """
+    if device is not None and int(device) != array.device:
+        return array.copy_to_device(int(device), async_=async_)
+    if async_:
+        return Prefetch(array)
+    if not array.resident:
+        multiarray._fetch(array)
+    return array
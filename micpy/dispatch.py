@@ -0,0 +1,176 @@
+"""
+NumPy protocol dispatch for device arrays.
+
+`ndarray.__array_ufunc__` and `ndarray.__array_function__` forward here,
+so that NumPy calls such as ``np.add(a, 1)`` or ``np.mean(a)`` on device
+arrays run the micpy implementation on the device.
+
+A NumPy function or ufunc micpy does not implement falls back to NumPy:
+the device arrays among its arguments are copied to the host, NumPy
+computes the result, and the result is copied back to the device of the
+first device argument. Each fallback emits a `FallbackWarning` when
+enabled with `set_fallback_warning` or the ``MICPY_WARN_FALLBACK``
+environment variable.
+"""
+import os
+import warnings
+
+import numpy as np
+
+from . import multiarray
+from . import umath
+
+__all__ = ['FallbackWarning', 'set_fallback_warning']
+
+
+class FallbackWarning(RuntimeWarning):
+    """A NumPy function ran on the host for lack of a device version."""
+    pass
+
+
+_warn_fallback = os.environ.get('MICPY_WARN_FALLBACK', '0') not in ('', '0')
+
+
+def set_fallback_warning(enabled=True):
+    """
+    Warn, or stop warning, when a NumPy call on device arrays falls back
+    to the host.
+
+    Returns
+    -------
+    previous : bool
+        The previous setting.
+    """
+    global _warn_fallback
+    previous, _warn_fallback = _warn_fallback, bool(enabled)
+    return previous
+
+
+# NumPy functions implemented by the micpy function of the same name
+_function_names = (
+    'copyto', 'ones_like', 'zeros_like', 'empty_like', 'full_like',
+    'dot', 'vdot', 'rollaxis', 'moveaxis', 'argmax', 'argmin',
+    'expand_dims',
+)
+
+# NumPy functions implemented by the ndarray method of the same name.
+# np.resize is not one of them: it repeats the data to fill the new
+# shape, where ndarray.resize pads with zeros.
+_method_names = (
+    'all', 'any', 'max', 'amax', 'min', 'amin', 'mean', 'prod', 'product',
+    'ptp', 'ravel', 'reshape', 'std', 'sum', 'transpose', 'var',
+)
+_method_aliases = {'amax': 'max', 'amin': 'min', 'product': 'prod'}
+
+_implementations = None
+
+
+def _get_implementations():
+    global _implementations
+    if _implementations is None:
+        import micpy
+        impl = {}
+        for name in _function_names:
+            if hasattr(np, name) and hasattr(micpy, name):
+                impl[getattr(np, name)] = getattr(micpy, name)
+        for name in _method_names:
+            if hasattr(np, name):
+                impl[getattr(np, name)] = _method_alias(
+                                            _method_aliases.get(name, name))
+        _implementations = impl
+    return _implementations
+
+
+def _method_alias(name):
+    def call_method(a, *args, **kwargs):
+        return getattr(a, name)(*args, **kwargs)
+    call_method.__name__ = name
+    return call_method
+
+
+def _device_of(args):
+    for arg in args:
+        if isinstance(arg, multiarray.ndarray):
+            return arg.device
+        if isinstance(arg, (list, tuple)):
+            device = _device_of(arg)
+            if device is not None:
+                return device
+    return None
+
+
+def _to_host(obj):
+    if isinstance(obj, multiarray.ndarray):
+        return obj.to_cpu()
+    if isinstance(obj, tuple):
+        return tuple(_to_host(o) for o in obj)
+    if isinstance(obj, list):
+        return [_to_host(o) for o in obj]
+    return obj
+
+
+def _to_device(obj, device):
+    if isinstance(obj, np.ndarray):
+        return multiarray.to_mic(obj, device=device)
+    if isinstance(obj, tuple):
+        return tuple(_to_device(o, device) for o in obj)
+    if isinstance(obj, list):
+        return [_to_device(o, device) for o in obj]
+    return obj
+
+
+def _fallback(name, func, args, kwargs):
+    """Run func on host copies of args, and move the result back."""
+    if _warn_fallback:
+        warnings.warn("%s has no device implementation, running it on "
+                      "the host" % name, FallbackWarning, stacklevel=3)
+
+    device = _device_of(args)
+    out = kwargs.pop('out', None)
+    if out is not None:
+        host_out = kwargs['out'] = _to_host(out)
+
+    kwargs = dict((k, _to_host(v)) for k, v in kwargs.items())
+    result = func(*_to_host(args), **kwargs)
+
+    if out is None:
+        return _to_device(result, device)
+
+    # copy the host outputs into the device ones
+    outs = out if isinstance(out, tuple) else (out,)
+    host_outs = host_out if isinstance(host_out, tuple) else (host_out,)
+    for o, h in zip(outs, host_outs):
+        if isinstance(o, multiarray.ndarray):
+            multiarray.copyto(o, h)
+    return out
+
+
+def array_ufunc(self, ufunc, method, *inputs, **kwargs):
+    """Implementation of ndarray.__array_ufunc__."""
+    out = kwargs.get('out')
+    if isinstance(out, tuple) and len(out) == 1:
+        kwargs['out'] = out[0]
+
+    mufunc = getattr(umath, ufunc.__name__, None)
+    if mufunc is not None:
+        meth = mufunc if method == '__call__' else \
+               getattr(mufunc, method, None)
+        if meth is not None:
+            return meth(*inputs, **kwargs)
+
+    name = "%s.%s" % (ufunc.__name__, method)
+    func = ufunc if method == '__call__' else getattr(ufunc, method)
+    return _fallback(name, func, inputs, kwargs)
+
+
+def array_function(self, func, types, args, kwargs):
+    """Implementation of ndarray.__array_function__."""
+    for t in types:
+        if not issubclass(t, (multiarray.ndarray, np.ndarray)):
+            return NotImplemented
+
+    impl = _get_implementations().get(func)
+    if impl is not None:
+        return impl(*args, **kwargs)
+
+    return _fallback(func.__name__, func, args, dict(kwargs))
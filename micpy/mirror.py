@@ -0,0 +1,230 @@
+"""
+Arrays mirrored in host memory and on a device.
+
+A `MirroredArray` keeps a NumPy array and a device array of the same
+shape, and knows which side holds the latest data. Asking for one side
+copies over what is stale there, and nothing when it is up to date, so
+code going back and forth between NumPy on the host and micpy on the
+device only moves the data that changed.
+
+The buffer can be cut into chunks tracked separately: after a write to
+part of one side (see `mark_host_dirty` and `mark_device_dirty`), only
+the chunks covering that part are copied.
+
+Examples
+--------
+>>> m = mp.mirror(np.zeros((1000, 1000)))
+>>> d = m.device_view()              # copied to the device
+>>> mp.add(d, 1, out=d)
+>>> m.host_view(write=False).sum()   # copied back
+1000000.0
+>>> m.host_view(write=False).max()   # no copy
+1.0
+"""
+import numpy as np
+
+from . import multiarray
+
+__all__ = ['MirroredArray', 'mirror']
+
+
+class MirroredArray(object):
+    """
+    Array with a host and a device copy, synchronized lazily.
+
+    Parameters
+    ----------
+    host : array_like
+        Host data. A C contiguous NumPy array is used as the host copy
+        as is, without copying it.
+    device : int, optional
+        Device of the device copy, the current device by default.
+    chunk_bytes : int, optional
+        Size of the chunks tracked separately. By default the whole
+        array is one chunk.
+    device_array : ndarray, optional
+        Use this device array as the device copy, with the device side
+        up to date instead of the host one. Used by `mirror`.
+    """
+
+    def __init__(self, host, device=None, chunk_bytes=None,
+                 device_array=None):
+        if device_array is not None:
+            device = device_array.device
+        elif device is None:
+            device = multiarray.device()
+        self._host = np.ascontiguousarray(host)
+        host_valid = device_array is None
+        if device_array is None:
+            device_array = multiarray.empty(self._host.shape,
+                                            dtype=self._host.dtype,
+                                            device=device)
+        self._device = device_array
+        self.device = device
+
+        size = self._host.size
+        if chunk_bytes is None:
+            self._chunk = max(size, 1)
+        else:
+            self._chunk = max(int(chunk_bytes) // self._host.itemsize, 1)
+        nchunks = max(-(-size // self._chunk), 1)
+
+        self._host_valid = [host_valid] * nchunks
+        self._device_valid = [not host_valid] * nchunks
+        self.bytes_to_device = 0
+        self.bytes_to_host = 0
+
+    def _runs(self, valid):
+        """Element bounds of the runs of stale chunks of a side."""
+        runs, start = [], None
+        for k, ok in enumerate(valid + [True]):
+            if not ok and start is None:
+                start = k
+            elif ok and start is not None:
+                runs.append((start * self._chunk,
+                             min(k * self._chunk, self._host.size)))
+                start = None
+        return runs
+
+    def _chunks(self, start, stop):
+        if stop is None:
+            stop = self._host.size
+        if not 0 <= start <= stop <= self._host.size:
+            raise ValueError("range [%d, %d) out of bounds for size %d"
+                             % (start, stop, self._host.size))
+        if start == stop:
+            return range(0)
+        return range(start // self._chunk, (stop - 1) // self._chunk + 1)
+
+    def _sync_device(self):
+        flat = self._host.reshape(-1)
+        for lo, hi in self._runs(self._device_valid):
+            multiarray.copyto(multiarray._flat_chunk(self._device, lo, hi),
+                              flat[lo:hi])
+            self.bytes_to_device += (hi - lo) * self._host.itemsize
+        self._device_valid = [True] * len(self._device_valid)
+
+    def _sync_host(self):
+        flat = self._host.reshape(-1)
+        for lo, hi in self._runs(self._host_valid):
+            multiarray._copyto_host(flat[lo:hi],
+                                    multiarray._flat_chunk(self._device,
+                                                           lo, hi))
+            self.bytes_to_host += (hi - lo) * self._host.itemsize
+        self._host_valid = [True] * len(self._host_valid)
+
+    def host_view(self, write=True):
+        """
+        Return the host copy, brought up to date.
+
+        With `write` set, the device copy is marked stale, as the caller
+        may change the returned array. Pass ``write=False`` for reads, or
+        mark the part written with `mark_host_dirty`.
+        """
+        self._sync_host()
+        if write:
+            self._device_valid = [False] * len(self._device_valid)
+        return self._host
+
+    def device_view(self, write=True):
+        """
+        Return the device copy, brought up to date.
+
+        With `write` set, the host copy is marked stale, as the caller
+        may change the returned array. Pass ``write=False`` for reads, or
+        mark the part written with `mark_device_dirty`.
+        """
+        self._sync_device()
+        if write:
+            self._host_valid = [False] * len(self._host_valid)
+        return self._device
+
+    def mark_host_dirty(self, start=0, stop=None):
+        """
+        Record a write to the flat elements [start, stop) of the host
+        copy, made through a view taken with ``write=False``.
+        """
+        for k in self._chunks(start, stop):
+            if not self._host_valid[k]:
+                raise ValueError("chunk %d of the host copy is stale" % k)
+            self._device_valid[k] = False
+
+    def mark_device_dirty(self, start=0, stop=None):
+        """
+        Record a write to the flat elements [start, stop) of the device
+        copy, made through a view taken with ``write=False``.
+        """
+        for k in self._chunks(start, stop):
+            if not self._device_valid[k]:
+                raise ValueError("chunk %d of the device copy is stale" % k)
+            self._host_valid[k] = False
+
+    def sync(self):
+        """Bring both copies up to date."""
+        self._sync_host()
+        self._sync_device()
+
+    @property
+    def host_valid(self):
+        """Whether the host copy is up to date."""
+        return all(self._host_valid)
+
+    @property
+    def device_valid(self):
+        """Whether the device copy is up to date."""
+        return all(self._device_valid)
+
+    @property
+    def shape(self):
+        return self._host.shape
+
+    @property
+    def dtype(self):
+        return self._host.dtype
+
+    @property
+    def size(self):
+        return self._host.size
+
+    @property
+    def nbytes(self):
+        return self._host.nbytes
+
+    def __len__(self):
+        return len(self._host)
+
+    def __array__(self, dtype=None):
+        host = self.host_view(write=False)
+        return host if dtype is None else host.astype(dtype)
+
+    def __repr__(self):
+        return "MirroredArray(shape=%s, dtype=%s, device=%d)" % (
+            self.shape, self.dtype, self.device)
+
+
+def mirror(obj, device=None, chunk_bytes=None):
+    """
+    Mirror an array between host and device memory.
+
+    Parameters
+    ----------
+    obj : array_like or ndarray
+        Initial data. A device array becomes the device copy, with the
+        host copy stale; anything else becomes the host copy.
+    device : int, optional
+        Device of the device copy, for host data. The current device by
+        default.
+    chunk_bytes : int, optional
+        Size of the chunks tracked separately, the whole array by
+        default.
+
+    Returns
+    -------
+    out : MirroredArray
+    """
+    if isinstance(obj, multiarray.ndarray):
+        if not obj.flags.c_contiguous:
+            obj = obj.copy()
+        host = np.empty(obj.shape, dtype=obj.dtype)
+        return MirroredArray(host, chunk_bytes=chunk_bytes, device_array=obj)
+    return MirroredArray(obj, device=device, chunk_bytes=chunk_bytes)
@@ -13,6 +13,9 @@
 #define _MICARRAYMODULE
 #include "common.h"
 #include "alloc.h"
+#include "numa.h"
+#include "residency.h"
+#include "ptrmap.h"
 #include <assert.h>
 
 #define NBUCKETS 1024 /* number of buckets for data*/
@@ -110,7 +113,7 @@ mpy_alloc_cache_zero(npy_uintp sz, int device)
     if (sz < NBUCKETS) {
         p = _mpy_alloc_cache(device, sz, 1, NBUCKETS, datacache, &PyDataMemMic_NEW);
         if (p) {
-            #pragma omp target device(device) map(to:p,sz)
+            #pragma omp target device(mpy_omp_launch(device)) map(to:p,sz)
             memset(p, 0, sz);
         }
         return p;
@@ -153,6 +156,18 @@ mpy_free_cache_dim(void * p, npy_uintp sz)
                     &PyArray_free);
 }
 
+/*
+ * Allocates device memory, without making room for it.
+ */
+NPY_NO_EXPORT void *
+mpy_device_alloc(size_t size, int device)
+{
+    if (mpy_numa_enabled()) {
+        return mpy_numa_alloc(size, device);
+    }
+    return target_alloc(size, device);
+}
+
 /*NUMPY_API
  * Allocates memory for array data.
  */
@@ -161,7 +176,12 @@ PyDataMemMic_NEW(size_t size, int device)
 {
     void *result;
 
-    result = omp_target_alloc(size, device);
+    result = mpy_device_alloc(size, device);
+
+    /* evict idle arrays to the host until it fits */
+    while (result == NULL && size > 0 && mpy_residency_evict(device) == 0) {
+        result = mpy_device_alloc(size, device);
+    }
 
     return result;
 }
@@ -174,9 +194,29 @@ PyDataMemMic_NEW_ZEROED(size_t size, size_t elsize, int device)
 {
     void *result;
 
-    #pragma omp target device(device) map(from:result)
+    if (mpy_numa_enabled()) {
+        /* zeroed by the team of the node so that first touch is local */
+        result = mpy_numa_alloc(size * elsize, device);
+        if (result != NULL) {
+            char *p = result;
+            npy_intp i, n = size * elsize;
+
+            #pragma omp parallel for schedule(static)
+            for (i = 0; i < n; i++) {
+                p[i] = 0;
+            }
+        }
+        return result;
+    }
+
+    #pragma omp target device(mpy_omp_launch(device)) map(from:result)
     result = calloc(size, elsize);
 
+    while (result == NULL && size > 0 && mpy_residency_evict(device) == 0) {
+        #pragma omp target device(mpy_omp_launch(device)) map(from:result)
+        result = calloc(size, elsize);
+    }
+
     return result;
 }
 
@@ -186,22 +226,120 @@ PyDataMemMic_NEW_ZEROED(size_t size, size_t elsize, int device)
 NPY_NO_EXPORT void
 PyDataMemMic_FREE(void *ptr, int device)
 {
-    omp_target_free(ptr, device);
+    if (mpy_numa_enabled()) {
+        free(ptr);
+        return;
+    }
+    target_free(ptr, device);
 }
 
-/*NUMPY_API
- * Reallocate/resize memory for array data on given divice.
+/* blocks of this many bytes are copied or zeroed by one thread */
+#define MPY_DEVICE_BLOCK (64 * 1024)
+
+/*
+ * Copy sz bytes between two blocks of the same device, with the threads
+ * of the device.
+ */
+NPY_NO_EXPORT void
+mpy_device_copy(void *dst, const void *src, size_t sz, int device)
+{
+    char *d = dst;
+    const char *s = src;
+    npy_intp nblocks = (sz + MPY_DEVICE_BLOCK - 1) / MPY_DEVICE_BLOCK;
+
+    if (sz == 0) {
+        return;
+    }
+    #pragma omp target device(mpy_omp_launch(device)) \
+                       map(to: d, s, sz, nblocks)
+    {
+        npy_intp i;
+
+        #pragma omp parallel for schedule(static)
+        for (i = 0; i < nblocks; i++) {
+            size_t lo = i * MPY_DEVICE_BLOCK;
+            size_t len = sz - lo < MPY_DEVICE_BLOCK ? sz - lo
+                                                    : MPY_DEVICE_BLOCK;
+            memcpy(d + lo, s + lo, len);
+        }
+    }
+}
+
+/* Zero sz bytes of device memory, with the threads of the device */
+NPY_NO_EXPORT void
+mpy_device_zero(void *dst, size_t sz, int device)
+{
+    char *d = dst;
+    npy_intp nblocks = (sz + MPY_DEVICE_BLOCK - 1) / MPY_DEVICE_BLOCK;
+
+    if (sz == 0) {
+        return;
+    }
+    #pragma omp target device(mpy_omp_launch(device)) map(to: d, sz, nblocks)
+    {
+        npy_intp i;
+
+        #pragma omp parallel for schedule(static)
+        for (i = 0; i < nblocks; i++) {
+            size_t lo = i * MPY_DEVICE_BLOCK;
+            size_t len = sz - lo < MPY_DEVICE_BLOCK ? sz - lo
+                                                    : MPY_DEVICE_BLOCK;
+            memset(d + lo, 0, len);
+        }
+    }
+}
+
+/*
+ * Move array data of oldsize bytes to a new block of size bytes on the
+ * same device. The first min(oldsize, size) bytes are copied on the
+ * device and the old block is released; the rest of the new block is
+ * left uninitialized. Returns NULL, with ptr untouched, if the new
+ * block cannot be allocated.
+ *
+ * Both blocks come from and go back to the data cache, so ptr must have
+ * been allocated with mpy_alloc_cache (or PyDataMemMic_NEW) for at
+ * least oldsize bytes.
  */
 NPY_NO_EXPORT void *
-PyDataMemMic_RENEW(void *ptr, size_t size, int device)
+PyDataMemMic_RENEW(void *ptr, size_t oldsize, size_t size, int device)
 {
     void *result;
 
-    Py_BEGIN_ALLOW_THREADS
-    #pragma omp target device(device) map(from:result)
-    result = realloc(ptr, size);
+    result = mpy_alloc_cache(size, device);
+    if (result == NULL) {
+        return NULL;
+    }
+    if (ptr != NULL) {
+        Py_BEGIN_ALLOW_THREADS
+        mpy_device_copy(result, ptr, oldsize < size ? oldsize : size, device);
+        Py_END_ALLOW_THREADS
+        mpy_free_cache(ptr, oldsize, device);
+    }
+    return result;
+}
 
-    Py_END_ALLOW_THREADS
+/*
+ * Bytes allocated for the data of the arrays resize left room to grow
+ * in, keyed by array. Only used with the GIL held.
+ */
+static MpyPtrMap capacities = MPY_PTRMAP_INIT;
 
-    return result;
+NPY_NO_EXPORT npy_intp
+mpy_array_capacity(PyMicArrayObject *arr)
+{
+    void *capacity = mpy_ptrmap_get(&capacities, arr);
+
+    return capacity != NULL ? (npy_intp)capacity : PyMicArray_NBYTES(arr);
+}
+
+NPY_NO_EXPORT void
+mpy_array_set_capacity(PyMicArrayObject *arr, npy_intp capacity)
+{
+    if (capacity <= 0) {
+        mpy_ptrmap_pop(&capacities, arr);
+    }
+    /* without an entry the room is only not reused */
+    else if (mpy_ptrmap_set(&capacities, arr, (void *)capacity) < 0) {
+        mpy_ptrmap_pop(&capacities, arr);
+    }
 }
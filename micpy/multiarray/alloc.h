@@ -18,6 +18,9 @@ mpy_alloc_cache_dim(npy_uintp sz);
 NPY_NO_EXPORT void
 mpy_free_cache_dim(void * p, npy_uintp sd);
 
+NPY_NO_EXPORT void *
+mpy_device_alloc(size_t sz, int device);
+
 NPY_NO_EXPORT void *
 PyDataMemMic_NEW(size_t sz, int device);
 
@@ -25,7 +28,13 @@ NPY_NO_EXPORT void *
 PyDataMemMic_NEW_ZEROED(size_t sz, size_t elsize, int device);
 
 NPY_NO_EXPORT void *
-PyDataMemMic_RENEW(void * p, size_t sz, int device);
+PyDataMemMic_RENEW(void * p, size_t oldsz, size_t sz, int device);
+
+NPY_NO_EXPORT void
+mpy_device_copy(void *dst, const void *src, size_t sz, int device);
+
+NPY_NO_EXPORT void
+mpy_device_zero(void *dst, size_t sz, int device);
 
 NPY_NO_EXPORT void
 PyDataMemMic_FREE(void * p, int device);
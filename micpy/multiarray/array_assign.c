@@ -19,6 +19,8 @@
 #include "dtype_transfer.h"
 #include "common.h"
 #include "shape.h"
+#include "staging.h"
+#include "residency.h"
 
 #include "array_assign.h"
 
@@ -345,8 +347,8 @@ raw_array_wheremasked_assign_scalar(int device, int ndim, npy_intp *shape,
  *
  * Returns 0 on success, -1 on failure.
  */
-NPY_NO_EXPORT int
-PyMicArray_AssignRawScalar(PyMicArrayObject *dst,
+static int
+_assign_raw_scalar(PyMicArrayObject *dst,
                         PyArray_Descr *src_dtype, char *src_data,
                         int src_device,
                         PyMicArrayObject *wheremask,
@@ -482,6 +484,26 @@ fail:
     return -1;
 }
 
+NPY_NO_EXPORT int
+PyMicArray_AssignRawScalar(PyMicArrayObject *dst,
+                        PyArray_Descr *src_dtype, char *src_data,
+                        int src_device,
+                        PyMicArrayObject *wheremask,
+                        NPY_CASTING casting)
+{
+    PyMicArrayObject *pinned[2] = {dst, wheremask};
+    int ret;
+
+    /* the data are used with the GIL released, see residency.h */
+    if (mpy_residency_pin_all(pinned, 2) < 0) {
+        return -1;
+    }
+    ret = _assign_raw_scalar(dst, src_dtype, src_data, src_device, wheremask,
+                             casting);
+    mpy_residency_unpin_all(pinned, 2);
+    return ret;
+}
+
 /*
  * ================
  * | Arrays Part  |
@@ -529,6 +551,35 @@ raw_array_assign_array(int device, int ndim, npy_intp *shape,
         return -1;
     }
 
+    /*
+     * Order changing copies, such as a C ordered copy of a transposed
+     * view: the innermost axis of one side is the second axis of the
+     * other. Row by row, one of the two would be walked with a stride
+     * of a whole row, so the copy is done by tiles instead. An outer
+     * axis with matching strides on both sides is a batch of them.
+     */
+    if (aligned && (ndim == 2 || ndim == 3) &&
+            PyArray_EquivTypes(src_dtype, dst_dtype) &&
+            dst_strides_it[0] == src_itemsize &&
+            src_strides_it[1] == src_itemsize &&
+            shape_it[0] >= MPY_TRANSPOSE_TILE &&
+            shape_it[1] >= MPY_TRANSPOSE_TILE) {
+        int ret;
+
+        NPY_BEGIN_THREADS;
+        ret = PyMicArray_TransposeCopy(device, src_itemsize,
+                        ndim == 3 ? shape_it[2] : 1,
+                        shape_it[0], shape_it[1],
+                        dst_data, dst_strides_it[1],
+                        ndim == 3 ? dst_strides_it[2] : 0,
+                        src_data, src_strides_it[0],
+                        ndim == 3 ? src_strides_it[2] : 0);
+        NPY_END_THREADS;
+        if (ret == 0) {
+            return 0;
+        }
+    }
+
     /*
      * Overlap check for the 1D case. Higher dimensional arrays and
      * opposite strides cause a temporary copy before getting here.
@@ -627,10 +678,9 @@ raw_array_assign_device_array(int ndim, npy_intp *shape,
 
     NPY_RAW_ITER_START(idim, ndim, coord, shape_it) {
         /* Process the innermost dimension */
-        if (omp_target_memcpy(dst_data, src_data,
-                            itemsize * shape_it[0],
-                            0, 0,
-                            dst_device, src_device) < 0) {
+        if (target_memcpy(dst_data, src_data,
+                          itemsize * shape_it[0],
+                          dst_device, src_device) < 0) {
             return -1;
         }
     } NPY_RAW_ITER_TWO_NEXT(idim, ndim, coord, shape_it,
@@ -720,8 +770,8 @@ static int broadcast_array_strides(PyArrayObject *dst, PyArrayObject *src, npy_i
  *
  * Returns 0 on success, -1 on failure.
  */
-NPY_NO_EXPORT int
-PyMicArray_AssignArray(PyMicArrayObject *dst, PyMicArrayObject *src,
+static int
+_assign_array(PyMicArrayObject *dst, PyMicArrayObject *src,
                     PyMicArrayObject *wheremask,
                     NPY_CASTING casting)
 {
@@ -820,7 +870,8 @@ PyMicArray_AssignArray(PyMicArrayObject *dst, PyMicArrayObject *src,
             goto fail;
         }
 
-        if (PyMicArray_AssignArray(tmp, src, NULL, NPY_UNSAFE_CASTING) < 0) {
+        if (PyMicArray_AssignArray(tmp, src, NULL, NPY_UNSAFE_CASTING) < 0 ||
+                mpy_residency_pin(tmp) < 0) {
             Py_DECREF(tmp);
             goto fail;
         }
@@ -894,22 +945,135 @@ PyMicArray_AssignArray(PyMicArrayObject *dst, PyMicArrayObject *src,
     }
 
     if (copied_src) {
+        mpy_residency_unpin(src);
         Py_DECREF(src);
     }
     return 0;
 
 fail:
     if (copied_src) {
+        mpy_residency_unpin(src);
         Py_DECREF(src);
     }
     return -1;
 }
 
+NPY_NO_EXPORT int
+PyMicArray_AssignArray(PyMicArrayObject *dst, PyMicArrayObject *src,
+                    PyMicArrayObject *wheremask,
+                    NPY_CASTING casting)
+{
+    PyMicArrayObject *pinned[3] = {dst, src, wheremask};
+    int ret;
+
+    /* the data are used with the GIL released, see residency.h */
+    if (mpy_residency_pin_all(pinned, 3) < 0) {
+        return -1;
+    }
+    ret = _assign_array(dst, src, wheremask, casting);
+    mpy_residency_unpin_all(pinned, 3);
+    return ret;
+}
+
+/*
+ * Copy src on device into dst, on another device, with the same shape
+ * and dtype as one contiguous block instead of row by row. Non
+ * contiguous operands get a contiguous copy on their own device first.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+static int
+_assign_peer_contiguous(PyMicArrayObject *dst, PyMicArrayObject *src)
+{
+    PyMicArrayObject *src_c = src, *dst_c = dst, *pinned[2];
+    int ret = -1, err;
+
+    if (!PyMicArray_IS_C_CONTIGUOUS(src)) {
+        src_c = (PyMicArrayObject *)PyMicArray_NewCopy(src, NPY_CORDER);
+        if (src_c == NULL) {
+            return -1;
+        }
+    }
+    if (!PyMicArray_IS_C_CONTIGUOUS(dst)) {
+        dst_c = (PyMicArrayObject *)PyMicArray_NewLikeArray(
+                                        PyMicArray_DEVICE(dst),
+                                        (PyArrayObject *)dst,
+                                        NPY_CORDER, NULL, 0);
+        if (dst_c == NULL) {
+            goto finish;
+        }
+    }
+
+    /* the copies, allocated after each other, are not pinned yet */
+    pinned[0] = dst_c;
+    pinned[1] = src_c;
+    if (mpy_residency_pin_all(pinned, 2) < 0) {
+        goto finish;
+    }
+    err = mpy_peer_copy(PyMicArray_DATA(dst_c), PyMicArray_DEVICE(dst_c),
+                        PyMicArray_DATA(src_c), PyMicArray_DEVICE(src_c),
+                        PyMicArray_NBYTES(src_c));
+    mpy_residency_unpin_all(pinned, 2);
+    if (err < 0) {
+        goto finish;
+    }
+    if (dst_c != dst &&
+            PyMicArray_AssignArray(dst, dst_c, NULL,
+                                   NPY_UNSAFE_CASTING) < 0) {
+        goto finish;
+    }
+    ret = 0;
+
+finish:
+    if (src_c != src) {
+        Py_DECREF(src_c);
+    }
+    if (dst_c != dst) {
+        Py_XDECREF(dst_c);
+    }
+    return ret;
+}
+
+/*
+ * Host <-> device assignment with a change of type, cast chunk by chunk
+ * during the transfer. Only for arrays of the same shape laid out as one
+ * block in the same order; anything else goes through a temporary.
+ *
+ * Returns 1 if the assignment was done, 0 if the arrays do not qualify,
+ * -1 on failure.
+ */
+static int
+_assign_cast_transfer(int ndim, npy_intp *dims,
+                      char *dst, int dst_device, PyArray_Descr *dst_dtype,
+                      int dst_flags,
+                      int src_ndim, npy_intp *src_dims,
+                      char *src, int src_device, PyArray_Descr *src_dtype,
+                      int src_flags)
+{
+    int layout = NPY_ARRAY_ALIGNED | NPY_ARRAY_C_CONTIGUOUS;
+
+    if (ndim != src_ndim || !PyArray_CompareLists(dims, src_dims, ndim) ||
+            !mpy_cast_copy_supported(src_dtype, dst_dtype)) {
+        return 0;
+    }
+    if ((dst_flags & layout) != layout || (src_flags & layout) != layout) {
+        layout = NPY_ARRAY_ALIGNED | NPY_ARRAY_F_CONTIGUOUS;
+        if ((dst_flags & layout) != layout || (src_flags & layout) != layout) {
+            return 0;
+        }
+    }
+    if (mpy_cast_copy(dst, dst_device, dst_dtype, src, src_device, src_dtype,
+                      PyArray_MultiplyList(dims, ndim)) < 0) {
+        return -1;
+    }
+    return 1;
+}
+
 static int
 _AssignArrayFromAnotherDevice(PyMicArrayObject *dst, PyArrayObject *src,
                                     int device, NPY_CASTING casting)
 {
-    int copied_src = 0;
+    int copied_src = 0, pinned_src = 0;
     int host_device = CPU_DEVICE;
 
     npy_intp src_strides[NPY_MAXDIMS];
@@ -938,6 +1102,17 @@ _AssignArrayFromAnotherDevice(PyMicArrayObject *dst, PyArrayObject *src,
     if (PyArray_TYPE(src) != PyMicArray_TYPE(dst)) {
         if (device == host_device) {
             PyArrayObject *tmp;
+            int done = _assign_cast_transfer(PyMicArray_NDIM(dst),
+                            PyMicArray_DIMS(dst), PyMicArray_BYTES(dst),
+                            PyMicArray_DEVICE(dst), PyMicArray_DESCR(dst),
+                            PyMicArray_FLAGS(dst),
+                            PyArray_NDIM(src), PyArray_DIMS(src),
+                            PyArray_BYTES(src), host_device,
+                            PyArray_DESCR(src), PyArray_FLAGS(src));
+
+            if (done != 0) {
+                return done < 0 ? -1 : 0;
+            }
 
             /*
             * Allocate a temporary copy array.
@@ -961,15 +1136,37 @@ _AssignArrayFromAnotherDevice(PyMicArrayObject *dst, PyArrayObject *src,
                                             device,
                                             (PyArrayObject *) dst,
                                             NPY_KEEPORDER, NULL, 0);
-            if (PyMicArray_CopyInto(tmp, (PyMicArrayObject *)src) < 0) {
+            if (tmp == NULL) {
+                goto fail;
+            }
+            if (PyMicArray_CopyInto(tmp, (PyMicArrayObject *)src) < 0 ||
+                    mpy_residency_pin(tmp) < 0) {
                 Py_DECREF(tmp);
                 goto fail;
             }
             src = (PyArrayObject *)tmp;
+            pinned_src = 1;
         }
         copied_src = 1;
     }
 
+    /* Device to device without broadcasting: one block transfer */
+    if (device != host_device &&
+            PyArray_NDIM(src) == PyMicArray_NDIM(dst) &&
+            PyArray_CompareLists(PyArray_DIMS(src), PyMicArray_DIMS(dst),
+                                 PyMicArray_NDIM(dst))) {
+        if (_assign_peer_contiguous(dst, (PyMicArrayObject *)src) < 0) {
+            goto fail;
+        }
+        if (pinned_src) {
+            mpy_residency_unpin((PyMicArrayObject *)src);
+        }
+        if (copied_src) {
+            Py_DECREF(src);
+        }
+        return 0;
+    }
+
     /* Broadcast 'src' to 'dst' for raw iteration */
     if (!broadcast_array_strides((PyArrayObject *) dst, src, src_strides)) {
         goto fail;
@@ -985,12 +1182,18 @@ _AssignArrayFromAnotherDevice(PyMicArrayObject *dst, PyArrayObject *src,
         goto fail;
     }
 
+    if (pinned_src) {
+        mpy_residency_unpin((PyMicArrayObject *)src);
+    }
     if (copied_src) {
         Py_DECREF(src);
     }
     return 0;
 
 fail:
+    if (pinned_src) {
+        mpy_residency_unpin((PyMicArrayObject *)src);
+    }
     if (copied_src) {
         Py_DECREF(src);
     }
@@ -1012,14 +1215,30 @@ NPY_NO_EXPORT int
 PyMicArray_AssignArrayFromHost(PyMicArrayObject *dst, PyArrayObject *src,
                     NPY_CASTING casting)
 {
-    return _AssignArrayFromAnotherDevice(dst, src, CPU_DEVICE, casting);
+    int ret;
+
+    /* the data are used with the GIL released, see residency.h */
+    if (mpy_residency_pin(dst) < 0) {
+        return -1;
+    }
+    ret = _AssignArrayFromAnotherDevice(dst, src, CPU_DEVICE, casting);
+    mpy_residency_unpin(dst);
+    return ret;
 }
 
 NPY_NO_EXPORT int
 PyMicArray_AssignArrayFromDevice(PyMicArrayObject *dst, PyMicArrayObject *src,
                     NPY_CASTING casting) {
-    return _AssignArrayFromAnotherDevice(dst, (PyArrayObject *)src,
+    PyMicArrayObject *pinned[2] = {dst, src};
+    int ret;
+
+    if (mpy_residency_pin_all(pinned, 2) < 0) {
+        return -1;
+    }
+    ret = _AssignArrayFromAnotherDevice(dst, (PyArrayObject *)src,
                     PyMicArray_DEVICE(src), casting);
+    mpy_residency_unpin_all(pinned, 2);
+    return ret;
 }
 
 /*
@@ -1033,8 +1252,8 @@ PyMicArray_AssignArrayFromDevice(PyMicArrayObject *dst, PyMicArrayObject *src,
  *
  * Returns 0 on success, -1 on failure.
  */
-NPY_NO_EXPORT int
-PyArray_AssignArrayFromDevice(PyArrayObject *dst, PyMicArrayObject *src,
+static int
+_assign_array_to_host(PyArrayObject *dst, PyMicArrayObject *src,
                     NPY_CASTING casting)
 {
     int host_device;
@@ -1053,9 +1272,8 @@ PyArray_AssignArrayFromDevice(PyArrayObject *dst, PyMicArrayObject *src,
 
         /* Copy scalar from device to host */
         host_device = omp_get_initial_device();
-        if (omp_target_memcpy(tmp, PyMicArray_DATA(src),
-                            itemsize,
-                            0, 0, host_device, PyMicArray_DEVICE(src)) < 0){
+        if (target_memcpy(tmp, PyMicArray_DATA(src),
+                          itemsize, host_device, PyMicArray_DEVICE(src)) < 0){
             goto fail;
         }
 
@@ -1088,6 +1306,16 @@ PyArray_AssignArrayFromDevice(PyArrayObject *dst, PyMicArrayObject *src,
      */
     if (PyMicArray_TYPE(src) != PyArray_TYPE(dst)) {
         PyArrayObject *tmp;
+        int done = _assign_cast_transfer(PyArray_NDIM(dst), PyArray_DIMS(dst),
+                        PyArray_BYTES(dst), omp_get_initial_device(),
+                        PyArray_DESCR(dst), PyArray_FLAGS(dst),
+                        PyMicArray_NDIM(src), PyMicArray_DIMS(src),
+                        PyMicArray_BYTES(src), PyMicArray_DEVICE(src),
+                        PyMicArray_DESCR(src), PyMicArray_FLAGS(src));
+
+        if (done != 0) {
+            return done < 0 ? -1 : 0;
+        }
 
         /*
          * Allocate a temporary copy array.
@@ -1137,3 +1365,18 @@ fail:
     }
     return -1;
 }
+
+NPY_NO_EXPORT int
+PyArray_AssignArrayFromDevice(PyArrayObject *dst, PyMicArrayObject *src,
+                    NPY_CASTING casting)
+{
+    int ret;
+
+    /* the data are used with the GIL released, see residency.h */
+    if (mpy_residency_pin(src) < 0) {
+        return -1;
+    }
+    ret = _assign_array_to_host(dst, src, casting);
+    mpy_residency_unpin(src);
+    return ret;
+}
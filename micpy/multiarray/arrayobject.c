@@ -39,6 +39,7 @@
 #include "methods.h"
 #include "getset.h"
 #include "alloc.h"
+#include "residency.h"
 #include "number.h"
 #include "mpy_binop_override.h"
 
@@ -205,6 +206,7 @@ PyMicArray_SetBaseObject(PyMicArrayObject *arr, PyObject *obj)
     }
 
     ((PyMicArrayObject *)arr)->base = obj;
+    mpy_residency_set_base(arr);
 
     return 0;
 }
@@ -284,6 +286,8 @@ array_dealloc(PyMicArrayObject *self)
         Py_DECREF(fa->base);
     }
 
+    /* after the copy to base, which may need the data back on the device */
+    mpy_residency_release(fa);
     if ((fa->flags & NPY_ARRAY_OWNDATA) && fa->data) {
         /* Free internal references if an Object array */
         if (PyDataType_FLAGCHK(fa->descr, NPY_ITEM_REFCOUNT)) {
@@ -294,8 +298,9 @@ array_dealloc(PyMicArrayObject *self)
              * self already...
              */
         }
-        mpy_free_cache(fa->data, PyMicArray_NBYTES(self), fa->device);
+        mpy_free_cache(fa->data, PyMicArray_CAPACITY(self), fa->device);
     }
+    mpy_array_set_capacity(fa, 0);
 
     /* must match allocation in PyArray_NewFromDescr */
     mpy_free_cache_dim(fa->dimensions, 2 * fa->nd);
@@ -67,6 +67,17 @@ PyMicArray_SetUpdateIfCopyBase(PyMicArrayObject *arr, PyMicArrayObject *base);
 NPY_NO_EXPORT int
 PyMicArray_ElementStrides(PyObject *obj);
 
+/*
+ * Bytes allocated for the data of arr, more than PyMicArray_NBYTES when
+ * resize left room to grow. They are kept in a table, see alloc.c.
+ */
+NPY_NO_EXPORT npy_intp
+mpy_array_capacity(PyMicArrayObject *arr);
+
+/* Record the bytes allocated for the data of arr, 0 drops the record */
+NPY_NO_EXPORT void
+mpy_array_set_capacity(PyMicArrayObject *arr, npy_intp capacity);
+
 /*
  * This flag is used to mark arrays which we would like to, in the future,
  * turn into views. It causes a warning to be issued on the first attempt to
@@ -135,6 +146,7 @@ extern PyTypeObject PyMicArray_Type;
 
 #define PyMicArray_SIZE(m) PyArray_MultiplyList(PyMicArray_DIMS(m), PyMicArray_NDIM(m))
 #define PyMicArray_NBYTES(m) (PyMicArray_ITEMSIZE(m) * PyMicArray_SIZE(m))
+#define PyMicArray_CAPACITY(m) mpy_array_capacity((PyMicArrayObject *)(m))
 
 #define PyMicArray_UpdateFlags(o, FLAGS)\
             PyArray_UpdateFlags((PyArrayObject *)o, FLAGS)
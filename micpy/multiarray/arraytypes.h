@@ -30,6 +30,28 @@ CLONGDOUBLE_vdot(void *, npy_intp, void *, npy_intp, void *, npy_intp, int);
 NPY_NO_EXPORT PyMicArray_ArrFuncs *
 PyMicArray_GetArrFuncs(int typenum);
 
+/* Batched argmax (is_max) or argmin of the type, NULL if it has none */
+NPY_NO_EXPORT PyMicArray_ArgReduceFunc *
+PyMicArray_GetArgReduceFunc(int typenum, int is_max);
+
+/*
+ * Bytes of device scratch the batched arg reductions, and minmax, need
+ * for nrows rows of n items of elsize bytes; 0 if they need none. It is
+ * allocated with the GIL held, as the allocation may evict arrays.
+ */
+NPY_NO_EXPORT npy_intp
+PyMicArray_ArgReduceScratch(npy_intp n, npy_intp stride,
+                            npy_intp nrows, npy_intp row_stride, int elsize);
+
+/* Fused minimum and maximum of the type, NULL for complex and datetimes */
+NPY_NO_EXPORT PyMicArray_MinMaxFunc *
+PyMicArray_GetMinMaxFunc(int typenum);
+
+/* The same for the fused minimum and maximum, which always needs some */
+NPY_NO_EXPORT npy_intp
+PyMicArray_MinMaxScratch(npy_intp n, npy_intp stride,
+                         npy_intp nrows, npy_intp row_stride, int elsize);
+
 /* for _pyarray_correlate */
 NPY_NO_EXPORT int
 small_correlate(const char * d_, npy_intp dstride,
@@ -20,6 +20,15 @@
 #include "array_assign.h"
 #include "arraytypes.h"
 #include "shape.h"
+#include "residency.h"
+#include "alloc.h"
+
+#include <math.h>
+
+/* elements of a cell reduced by one thread in PyMicArray_MeanVar */
+#define MPY_STATS_BLOCK 4096
+/* cells a thread reduces side by side when they are interleaved */
+#define MPY_STATS_COLS 64
 
 static double
 power_of_ten(int n)
@@ -38,18 +47,66 @@ power_of_ten(int n)
     return ret;
 }
 
+/*
+ * Collapse the axes lo to hi - 1 of op into one axis of n items stride
+ * bytes apart. Returns 0 if their strides do not allow it.
+ */
+static int
+_collapse_axes(PyMicArrayObject *op, int lo, int hi,
+               npy_intp *n_out, npy_intp *stride_out)
+{
+    npy_intp n = 1, stride = 0;
+    int idim;
+
+    for (idim = hi - 1; idim >= lo; --idim) {
+        npy_intp dim = PyMicArray_DIMS(op)[idim];
+        npy_intp s = PyMicArray_STRIDES(op)[idim];
+
+        if (dim == 0) {
+            n = 0;
+            break;
+        }
+        if (dim == 1) {
+            continue;
+        }
+        if (n == 1) {
+            stride = s;
+        }
+        else if (s != stride * n) {
+            return 0;
+        }
+        n *= dim;
+    }
+    *n_out = n;
+    *stride_out = stride;
+    return 1;
+}
+
+/*
+ * The rows of op for a batched arg reduction over its last axis: the
+ * other axes have to collapse into one of nrows rows row_stride bytes
+ * apart. Returns 0 if they do not.
+ */
+static int
+_arg_rows(PyMicArrayObject *op, npy_intp *nrows, npy_intp *row_stride)
+{
+    return _collapse_axes(op, 0, PyMicArray_NDIM(op) - 1, nrows, row_stride);
+}
+
 /*NUMPY_API
  * ArgMax
  */
 NPY_NO_EXPORT PyObject *
 PyMicArray_ArgMax(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
 {
-    PyMicArrayObject *ap = NULL, *rp = NULL;
+    PyMicArrayObject *ap = NULL, *rp = NULL, *pinned[2];
     PyMicArray_ArgFunc* arg_func;
+    PyMicArray_ArgReduceFunc *reduce_func;
     char *ip;
     npy_intp *rptr;
-    npy_intp i, n, m;
-    int elsize;
+    npy_intp i, n, m, nrows, row_stride, nbytes = 0;
+    void *scratch = NULL;
+    int elsize, batched;
     int device;
     NPY_BEGIN_THREADS_DEF;
 
@@ -85,13 +142,26 @@ PyMicArray_ArgMax(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
     }
 
     device = PyMicArray_DEVICE(op);
+    reduce_func = PyMicArray_GetArgReduceFunc(PyMicArray_DESCR(op)->type_num,
+                                              1);
 
-    /* Will get native-byte order contiguous copy. */
-    ap = (PyMicArrayObject *)PyMicArray_ContiguousFromAny(device, (PyObject *)op,
-                                  PyMicArray_DESCR(op)->type_num, 1, 0);
-    Py_DECREF(op);
-    if (ap == NULL) {
-        return NULL;
+    /*
+     * The batched kernel reads the rows where they are, as long as the
+     * other axes collapse into one stride.
+     */
+    if (reduce_func != NULL && PyMicArray_ISNOTSWAPPED(op) &&
+            PyMicArray_ISALIGNED(op) && _arg_rows(op, &nrows, &row_stride)) {
+        ap = op;
+    }
+    else {
+        /* Will get native-byte order contiguous copy. */
+        ap = (PyMicArrayObject *)PyMicArray_ContiguousFromAny(device,
+                                      (PyObject *)op,
+                                      PyMicArray_DESCR(op)->type_num, 1, 0);
+        Py_DECREF(op);
+        if (ap == NULL) {
+            return NULL;
+        }
     }
     arg_func = PyMicArray_GetArrFuncs(PyMicArray_DESCR(ap)->type_num)->argmax;
     if (arg_func == NULL) {
@@ -134,14 +204,47 @@ PyMicArray_ArgMax(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
         }
     }
 
+    /* the kernels run with the GIL released, see residency.h */
+    pinned[0] = ap;
+    pinned[1] = rp;
+    if (mpy_residency_pin_all(pinned, 2) < 0) {
+        goto fail;
+    }
+    batched = reduce_func != NULL && _arg_rows(ap, &nrows, &row_stride);
+    if (batched) {
+        /* the allocation may evict, so it cannot wait for the kernel */
+        nbytes = PyMicArray_ArgReduceScratch(m,
+                          PyMicArray_STRIDES(ap)[PyMicArray_NDIM(ap)-1],
+                          nrows, row_stride, elsize);
+    }
+    if (nbytes > 0) {
+        scratch = PyDataMemMic_NEW(nbytes, device);
+        if (scratch == NULL) {
+            mpy_residency_unpin_all(pinned, 2);
+            PyErr_NoMemory();
+            goto fail;
+        }
+    }
     NPY_BEGIN_THREADS_DESCR(PyMicArray_DESCR(ap));
-    n = PyMicArray_SIZE(ap)/m;
-    rptr = (npy_intp *)PyMicArray_DATA(rp);
-    for (ip = PyMicArray_DATA(ap), i = 0; i < n; i++, ip += elsize*m) {
-        arg_func(ip, m, rptr, device);
-        rptr += 1;
+    if (batched) {
+        reduce_func(PyMicArray_DATA(ap), m,
+                    PyMicArray_STRIDES(ap)[PyMicArray_NDIM(ap)-1],
+                    nrows, row_stride,
+                    (npy_intp *)PyMicArray_DATA(rp), scratch, device);
+    }
+    else {
+        n = PyMicArray_SIZE(ap)/m;
+        rptr = (npy_intp *)PyMicArray_DATA(rp);
+        for (ip = PyMicArray_DATA(ap), i = 0; i < n; i++, ip += elsize*m) {
+            arg_func(ip, m, rptr, device);
+            rptr += 1;
+        }
     }
     NPY_END_THREADS_DESCR(PyMicArray_DESCR(ap));
+    if (scratch != NULL) {
+        PyDataMemMic_FREE(scratch, device);
+    }
+    mpy_residency_unpin_all(pinned, 2);
 
     Py_DECREF(ap);
     /* Trigger the UPDATEIFCOPY if necessary */
@@ -166,12 +269,14 @@ PyMicArray_ArgMax(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
 NPY_NO_EXPORT PyObject *
 PyMicArray_ArgMin(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
 {
-    PyMicArrayObject *ap = NULL, *rp = NULL;
+    PyMicArrayObject *ap = NULL, *rp = NULL, *pinned[2];
     PyMicArray_ArgFunc* arg_func;
+    PyMicArray_ArgReduceFunc *reduce_func;
     char *ip;
     npy_intp *rptr;
-    npy_intp i, n, m;
-    int elsize;
+    npy_intp i, n, m, nrows, row_stride, nbytes = 0;
+    void *scratch = NULL;
+    int elsize, batched;
     int device;
     NPY_BEGIN_THREADS_DEF;
 
@@ -207,13 +312,23 @@ PyMicArray_ArgMin(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
     }
 
     device = PyMicArray_DEVICE(op);
+    reduce_func = PyMicArray_GetArgReduceFunc(PyMicArray_DESCR(op)->type_num,
+                                              0);
 
-    /* Will get native-byte order contiguous copy. */
-    ap = (PyMicArrayObject *)PyMicArray_ContiguousFromAny(device, (PyObject *)op,
-                                  PyMicArray_DESCR(op)->type_num, 1, 0);
-    Py_DECREF(op);
-    if (ap == NULL) {
-        return NULL;
+    /* The batched kernel reads the rows where they are */
+    if (reduce_func != NULL && PyMicArray_ISNOTSWAPPED(op) &&
+            PyMicArray_ISALIGNED(op) && _arg_rows(op, &nrows, &row_stride)) {
+        ap = op;
+    }
+    else {
+        /* Will get native-byte order contiguous copy. */
+        ap = (PyMicArrayObject *)PyMicArray_ContiguousFromAny(device,
+                                      (PyObject *)op,
+                                      PyMicArray_DESCR(op)->type_num, 1, 0);
+        Py_DECREF(op);
+        if (ap == NULL) {
+            return NULL;
+        }
     }
     arg_func = PyMicArray_GetArrFuncs(PyMicArray_DESCR(ap)->type_num)->argmin;
     if (arg_func == NULL) {
@@ -256,14 +371,47 @@ PyMicArray_ArgMin(PyMicArrayObject *op, int axis, PyMicArrayObject *out)
         }
     }
 
+    /* the kernels run with the GIL released, see residency.h */
+    pinned[0] = ap;
+    pinned[1] = rp;
+    if (mpy_residency_pin_all(pinned, 2) < 0) {
+        goto fail;
+    }
+    batched = reduce_func != NULL && _arg_rows(ap, &nrows, &row_stride);
+    if (batched) {
+        /* the allocation may evict, so it cannot wait for the kernel */
+        nbytes = PyMicArray_ArgReduceScratch(m,
+                          PyMicArray_STRIDES(ap)[PyMicArray_NDIM(ap)-1],
+                          nrows, row_stride, elsize);
+    }
+    if (nbytes > 0) {
+        scratch = PyDataMemMic_NEW(nbytes, device);
+        if (scratch == NULL) {
+            mpy_residency_unpin_all(pinned, 2);
+            PyErr_NoMemory();
+            goto fail;
+        }
+    }
     NPY_BEGIN_THREADS_DESCR(PyMicArray_DESCR(ap));
-    n = PyMicArray_SIZE(ap)/m;
-    rptr = (npy_intp *)PyMicArray_DATA(rp);
-    for (ip = PyMicArray_DATA(ap), i = 0; i < n; i++, ip += elsize*m) {
-        arg_func(ip, m, rptr, device);
-        rptr += 1;
+    if (batched) {
+        reduce_func(PyMicArray_DATA(ap), m,
+                    PyMicArray_STRIDES(ap)[PyMicArray_NDIM(ap)-1],
+                    nrows, row_stride,
+                    (npy_intp *)PyMicArray_DATA(rp), scratch, device);
+    }
+    else {
+        n = PyMicArray_SIZE(ap)/m;
+        rptr = (npy_intp *)PyMicArray_DATA(rp);
+        for (ip = PyMicArray_DATA(ap), i = 0; i < n; i++, ip += elsize*m) {
+            arg_func(ip, m, rptr, device);
+            rptr += 1;
+        }
     }
     NPY_END_THREADS_DESCR(PyMicArray_DESCR(ap));
+    if (scratch != NULL) {
+        PyDataMemMic_FREE(scratch, device);
+    }
+    mpy_residency_unpin_all(pinned, 2);
 
     Py_DECREF(ap);
     /* Trigger the UPDATEIFCOPY if necessary */
@@ -320,13 +468,194 @@ PyMicArray_Min(PyMicArrayObject *ap, int axis, PyMicArrayObject *out)
     return ret;
 }
 
+/*
+ * Minimum and maximum of self along axis, NPY_MAXDIMS for the flattened
+ * array, and their indices, in one pass over the data. The results not
+ * wanted may be NULL. The indices are those of argmin and argmax: the
+ * first extreme wins, and a nan is both the minimum and the maximum.
+ * Returns 0 on success, -1 on failure.
+ */
+NPY_NO_EXPORT int
+PyMicArray_MinMax(PyMicArrayObject *self, int axis,
+                  PyMicArrayObject **min, PyMicArrayObject **argmin,
+                  PyMicArrayObject **max, PyMicArrayObject **argmax)
+{
+    PyMicArrayObject *ap = NULL, *op;
+    PyMicArrayObject *res[4] = {NULL, NULL, NULL, NULL}, *pinned[5];
+    PyMicArrayObject **outs[4];
+    PyMicArray_MinMaxFunc *minmax_func;
+    npy_intp m, nrows, row_stride, nbytes;
+    void *scratch = NULL;
+    int device, type_num, nd, i;
+    NPY_BEGIN_THREADS_DEF;
+
+    outs[0] = min;
+    outs[1] = argmin;
+    outs[2] = max;
+    outs[3] = argmax;
+
+    type_num = PyMicArray_TYPE(self);
+    minmax_func = PyMicArray_GetMinMaxFunc(type_num);
+    if (minmax_func == NULL) {
+        PyErr_SetString(PyExc_TypeError,
+                        "minmax needs a real numeric or boolean array");
+        return -1;
+    }
+
+    if ((op = (PyMicArrayObject *)PyMicArray_CheckAxis(self, &axis, 0)) == NULL) {
+        return -1;
+    }
+    nd = PyMicArray_NDIM(op);
+    device = PyMicArray_DEVICE(op);
+
+    /* The axis goes last, as in ArgMax, but the rows stay where they are */
+    if (axis != nd - 1) {
+        PyArray_Dims newaxes;
+        npy_intp dims[NPY_MAXDIMS];
+        int j;
+
+        newaxes.ptr = dims;
+        newaxes.len = nd;
+        for (j = 0; j < axis; j++) {
+            dims[j] = j;
+        }
+        for (j = axis; j < nd - 1; j++) {
+            dims[j] = j + 1;
+        }
+        dims[nd - 1] = axis;
+        ap = (PyMicArrayObject *)PyMicArray_Transpose(op, &newaxes);
+        Py_DECREF(op);
+        if (ap == NULL) {
+            return -1;
+        }
+        op = ap;
+    }
+    if (PyMicArray_ISNOTSWAPPED(op) && PyMicArray_ISALIGNED(op) &&
+            _arg_rows(op, &nrows, &row_stride)) {
+        ap = op;
+    }
+    else {
+        ap = (PyMicArrayObject *)PyMicArray_ContiguousFromAny(device,
+                                      (PyObject *)op, type_num, 1, 0);
+        Py_DECREF(op);
+        if (ap == NULL) {
+            return -1;
+        }
+        _arg_rows(ap, &nrows, &row_stride);
+    }
+
+    m = PyMicArray_DIMS(ap)[nd - 1];
+    if (m == 0) {
+        PyErr_SetString(PyExc_ValueError,
+                "zero-size array to reduction operation minmax "
+                "which has no identity");
+        goto fail;
+    }
+
+    for (i = 0; i < 4; ++i) {
+        if (outs[i] == NULL) {
+            continue;
+        }
+        res[i] = (PyMicArrayObject *)PyMicArray_New(device, Py_TYPE(ap),
+                                          nd - 1, PyMicArray_DIMS(ap),
+                                          i % 2 ? NPY_INTP : type_num,
+                                          NULL, NULL, 0, 0,
+                                          (PyObject *)ap);
+        if (res[i] == NULL) {
+            goto fail;
+        }
+    }
+
+    /* the kernel runs with the GIL released, see residency.h */
+    pinned[0] = ap;
+    memcpy(&pinned[1], res, sizeof(res));
+    if (mpy_residency_pin_all(pinned, 5) < 0) {
+        goto fail;
+    }
+    /* the allocation may evict, so it cannot wait for the kernel */
+    nbytes = PyMicArray_MinMaxScratch(m, PyMicArray_STRIDES(ap)[nd - 1],
+                                      nrows, row_stride,
+                                      PyMicArray_ITEMSIZE(ap));
+    if (nbytes > 0) {
+        scratch = PyDataMemMic_NEW(nbytes, device);
+        if (scratch == NULL) {
+            mpy_residency_unpin_all(pinned, 5);
+            PyErr_NoMemory();
+            goto fail;
+        }
+    }
+    NPY_BEGIN_THREADS_DESCR(PyMicArray_DESCR(ap));
+    minmax_func(PyMicArray_DATA(ap), m,
+                PyMicArray_STRIDES(ap)[nd - 1], nrows, row_stride,
+                res[0] ? PyMicArray_DATA(res[0]) : NULL,
+                res[1] ? (npy_intp *)PyMicArray_DATA(res[1]) : NULL,
+                res[2] ? PyMicArray_DATA(res[2]) : NULL,
+                res[3] ? (npy_intp *)PyMicArray_DATA(res[3]) : NULL,
+                scratch, device);
+    NPY_END_THREADS_DESCR(PyMicArray_DESCR(ap));
+    if (scratch != NULL) {
+        PyDataMemMic_FREE(scratch, device);
+    }
+    mpy_residency_unpin_all(pinned, 5);
+
+    Py_DECREF(ap);
+    for (i = 0; i < 4; ++i) {
+        if (outs[i] != NULL) {
+            *outs[i] = res[i];
+        }
+    }
+    return 0;
+
+ fail:
+    Py_DECREF(ap);
+    for (i = 0; i < 4; ++i) {
+        Py_XDECREF(res[i]);
+    }
+    return -1;
+}
+
 /*NUMPY_API
  * Ptp
  */
 NPY_NO_EXPORT PyObject *
 PyMicArray_Ptp(PyMicArrayObject *ap, int axis, PyMicArrayObject *out)
 {
-    return NULL;
+    PyMicArrayObject *arr, *lo = NULL, *hi = NULL;
+    PyObject *ret = NULL;
+
+    arr = (PyMicArrayObject *)PyMicArray_CheckAxis(ap, &axis, 0);
+    if (arr == NULL) {
+        return NULL;
+    }
+    if (PyMicArray_GetMinMaxFunc(PyMicArray_TYPE(arr)) != NULL) {
+        /* both extremes from one pass */
+        if (PyMicArray_MinMax(arr, axis, &lo, NULL, &hi, NULL) < 0) {
+            goto finish;
+        }
+    }
+    else {
+        hi = (PyMicArrayObject *)PyMicArray_Max(arr, axis, NULL);
+        if (hi == NULL) {
+            goto finish;
+        }
+        lo = (PyMicArrayObject *)PyMicArray_Min(arr, axis, NULL);
+        if (lo == NULL) {
+            goto finish;
+        }
+    }
+
+    if (out) {
+        ret = PyObject_CallFunction(n_ops.subtract, "OOO", hi, lo, out);
+    }
+    else {
+        ret = PyNumber_Subtract((PyObject *)hi, (PyObject *)lo);
+    }
+
+ finish:
+    Py_DECREF(arr);
+    Py_XDECREF(lo);
+    Py_XDECREF(hi);
+    return ret;
 }
 
 
@@ -342,14 +671,374 @@ PyMicArray_Std(PyMicArrayObject *self, int axis, int rtype, PyMicArrayObject *ou
     return __New_PyMicArray_Std(self, axis, rtype, out, variance, 0);
 }
 
+/* The types the Welford kernel reads in place, widening them to double */
+#define _WELFORD_TYPES(X) \
+        X(NPY_BOOL, npy_bool) \
+        X(NPY_BYTE, npy_byte) X(NPY_UBYTE, npy_ubyte) \
+        X(NPY_SHORT, npy_short) X(NPY_USHORT, npy_ushort) \
+        X(NPY_INT, npy_int) X(NPY_UINT, npy_uint) \
+        X(NPY_LONG, npy_long) X(NPY_ULONG, npy_ulong) \
+        X(NPY_LONGLONG, npy_longlong) X(NPY_ULONGLONG, npy_ulonglong) \
+        X(NPY_FLOAT, npy_float) X(NPY_DOUBLE, npy_double)
+
+static int
+_welford_reads(int type_num)
+{
+#define _WELFORD_CASE(num, type) case num:
+    switch (type_num) {
+        _WELFORD_TYPES(_WELFORD_CASE)
+            return 1;
+    }
+#undef _WELFORD_CASE
+    return 0;
+}
+
+/*
+ * Welford over len rows of ncol values, rows elem_stride bytes apart and
+ * the values of a row cell_stride bytes apart, from x. The count, mean
+ * and M2 of column j go to out[j * out_stride], and the two doubles
+ * after it.
+ */
+static MPY_TARGET_MIC void
+_welford_block(int type_num, char *x, npy_intp elem_stride, npy_intp len,
+               npy_intp cell_stride, npy_intp ncol,
+               double *out, npy_intp out_stride)
+{
+    double mu[MPY_STATS_COLS], m2[MPY_STATS_COLS];
+    npy_intp j, k;
+
+    for (j = 0; j < ncol; ++j) {
+        mu[j] = m2[j] = 0.0;
+    }
+
+#define _WELFORD_CASE(num, type) \
+        case num: \
+            for (k = 0; k < len; ++k) { \
+                char *row = x + k * elem_stride; \
+                double w = 1.0 / (k + 1); \
+                \
+                for (j = 0; j < ncol; ++j) { \
+                    double v = (double)*(type *)(row + j * cell_stride); \
+                    double delta = v - mu[j]; \
+                    \
+                    mu[j] += delta * w; \
+                    m2[j] += delta * (v - mu[j]); \
+                } \
+            } \
+            break;
+    switch (type_num) {
+        _WELFORD_TYPES(_WELFORD_CASE)
+    }
+#undef _WELFORD_CASE
+
+    for (j = 0; j < ncol; ++j) {
+        out[j * out_stride] = (double)len;
+        out[j * out_stride + 1] = mu[j];
+        out[j * out_stride + 2] = m2[j];
+    }
+}
+
+/*
+ * Blocks of the cells of _welford: sets the number of cells side by side
+ * in a block and its number of rows, and returns the number of blocks
+ * of each cell. _welford needs 3 * ncell * nblk doubles of partials.
+ */
+static npy_intp
+_welford_blocks(npy_intp ncell, npy_intp cell_stride,
+                npy_intp m, npy_intp elem_stride,
+                npy_intp *ncol, npy_intp *rows)
+{
+    npy_intp abs_cell = cell_stride < 0 ? -cell_stride : cell_stride;
+    npy_intp abs_elem = elem_stride < 0 ? -elem_stride : elem_stride;
+
+    *ncol = ncell > 1 && abs_cell < abs_elem ? MPY_STATS_COLS : 1;
+    *rows = MPY_STATS_BLOCK / *ncol;
+    return (m + *rows - 1) / *rows;
+}
+
+/*
+ * Welford over the m values of each of the ncell cells of data, read in
+ * place: the values of a cell are elem_stride bytes apart, the cells
+ * cell_stride bytes apart, and type_num is one of _WELFORD_TYPES. Mean
+ * and M2 of blocks of MPY_STATS_BLOCK values are computed in parallel
+ * into partials, on the device, then the blocks of a cell are merged
+ * with the pairwise update of Chan et al. Writes the mean, and
+ * M2 / (n - ddof) or its square root.
+ *
+ * When the cells are closer to each other than the values of a cell, as
+ * in a reduction over the rows of a C ordered matrix, a block covers
+ * MPY_STATS_COLS cells side by side, so that it walks memory in order.
+ */
+static void
+_welford(int device, int type_num, char *data,
+         npy_intp ncell, npy_intp cell_stride,
+         npy_intp m, npy_intp elem_stride,
+         double *mean, double *var, int ddof, int take_sqrt,
+         double *partials)
+{
+    npy_intp ncol, rows;
+    npy_intp nblk = _welford_blocks(ncell, cell_stride, m, elem_stride,
+                                    &ncol, &rows);
+    npy_intp ntask = (ncell + ncol - 1) / ncol * nblk;
+
+    #pragma omp target device(mpy_omp_launch(device)) \
+                       map(to: type_num, data, ncell, cell_stride, m, \
+                                              elem_stride, mean, var, ddof, \
+                                              take_sqrt, ncol, rows, nblk, \
+                                              ntask, partials)
+    {
+        npy_intp t, c;
+
+        #pragma omp parallel for
+        for (t = 0; t < ntask; ++t) {
+            npy_intp b = t % nblk;
+            npy_intp c0 = (t / nblk) * ncol;
+            npy_intp lo = b * rows;
+            npy_intp len = m - lo < rows ? m - lo : rows;
+
+            _welford_block(type_num,
+                           data + c0 * cell_stride + lo * elem_stride,
+                           elem_stride, len, cell_stride,
+                           ncell - c0 < ncol ? ncell - c0 : ncol,
+                           partials + 3 * (c0 * nblk + b), 3 * nblk);
+        }
+
+        #pragma omp parallel for
+        for (c = 0; c < ncell; ++c) {
+            double n = 0.0, mu = 0.0, m2 = 0.0, denom;
+            npy_intp b;
+
+            for (b = 0; b < nblk; ++b) {
+                double *p = partials + 3 * (c * nblk + b);
+                double nb = p[0], delta = p[1] - mu;
+                double total = n + nb;
+
+                mu += delta * nb / total;
+                m2 += p[2] + delta * delta * n * nb / total;
+                n = total;
+            }
+            /* as numpy: no values give nan, n <= ddof gives inf or nan */
+            denom = n - ddof > 0 ? n - ddof : 0.0;
+            mean[c] = n > 0 ? mu : NAN;
+            var[c] = (n > 0 ? m2 : NAN) / denom;
+            if (take_sqrt) {
+                var[c] = sqrt(var[c]);
+            }
+        }
+    }
+}
+
+/*
+ * Mean and variance (or standard deviation, with take_sqrt) of self over
+ * the axes set in axis_flags, in one pass over the data. The values are
+ * read where they are and widened to double on load; the sums are kept
+ * in double. The results have
+ * type dtype, by default double for integers and the input type for
+ * floats, and keep the reduced axes with length 1 if keepdims is set.
+ *
+ * mean or var may be NULL when not wanted. Returns 0 on success, -1 on
+ * failure. Steals the reference to dtype, which may be NULL.
+ */
+NPY_NO_EXPORT int
+PyMicArray_MeanVar(PyMicArrayObject *self, npy_bool *axis_flags,
+                   PyArray_Descr *dtype, int ddof, int keepdims,
+                   int take_sqrt,
+                   PyMicArrayObject **mean, PyMicArrayObject **var)
+{
+    PyMicArrayObject *op = NULL, *ap = NULL;
+    PyMicArrayObject *res[2] = {NULL, NULL}, *pinned[3];
+    PyMicArrayObject **outs[2];
+    npy_intp perm_ptr[NPY_MAXDIMS], out_dims[NPY_MAXDIMS];
+    npy_intp ncell = 1, m = 1, cell_stride, elem_stride;
+    npy_intp npart, ncol, rows;
+    double *partials = NULL;
+    PyArray_Dims perm = {perm_ptr, 0};
+    int ndim = PyMicArray_NDIM(self), out_ndim = 0, nkept;
+    int device = PyMicArray_DEVICE(self);
+    int in_type = PyMicArray_TYPE(self), read_type, idim, i;
+
+    outs[0] = mean;
+    outs[1] = var;
+
+    if (PyTypeNum_ISCOMPLEX(in_type) ||
+            !(PyTypeNum_ISNUMBER(in_type) || PyTypeNum_ISBOOL(in_type))) {
+        PyErr_SetString(PyExc_TypeError,
+                        "mean and variance need a real numeric array");
+        goto fail;
+    }
+    if (dtype == NULL) {
+        dtype = PyArray_DescrFromType(PyTypeNum_ISINTEGER(in_type) ||
+                                      PyTypeNum_ISBOOL(in_type) ?
+                                      NPY_DOUBLE : in_type);
+    }
+
+    /* Kept axes first, reduced ones last, each to collapse into one */
+    for (idim = 0; idim < ndim; ++idim) {
+        if (!axis_flags[idim]) {
+            perm_ptr[perm.len++] = idim;
+            out_dims[out_ndim++] = PyMicArray_DIMS(self)[idim];
+            ncell *= PyMicArray_DIMS(self)[idim];
+        }
+        else if (keepdims) {
+            out_dims[out_ndim++] = 1;
+        }
+    }
+    nkept = perm.len;
+    for (idim = 0; idim < ndim; ++idim) {
+        if (axis_flags[idim]) {
+            perm_ptr[perm.len++] = idim;
+            m *= PyMicArray_DIMS(self)[idim];
+        }
+    }
+
+    op = (PyMicArrayObject *)PyMicArray_Transpose(self, &perm);
+    if (op == NULL) {
+        goto fail;
+    }
+    /*
+     * The kernel reads op in place, casting on load, as long as its kept
+     * axes and its reduced ones each collapse into one stride. Otherwise
+     * it gets a contiguous copy.
+     */
+    read_type = _welford_reads(in_type) ? in_type : NPY_DOUBLE;
+    if (read_type == in_type &&
+            PyMicArray_ISNOTSWAPPED(op) && PyMicArray_ISALIGNED(op) &&
+            _collapse_axes(op, 0, nkept, &ncell, &cell_stride) &&
+            _collapse_axes(op, nkept, ndim, &m, &elem_stride)) {
+        Py_INCREF(op);
+        ap = op;
+    }
+    else {
+        ap = (PyMicArrayObject *)PyMicArray_ContiguousFromAny(device,
+                                    (PyObject *)op, read_type, 0, 0);
+        if (ap == NULL) {
+            goto fail;
+        }
+        elem_stride = PyMicArray_ITEMSIZE(ap);
+        cell_stride = m * elem_stride;
+    }
+
+    for (i = 0; i < 2; ++i) {
+        res[i] = (PyMicArrayObject *)PyMicArray_New(device,
+                                &PyMicArray_Type, out_ndim, out_dims,
+                                NPY_DOUBLE, NULL, NULL, 0, 0, NULL);
+        if (res[i] == NULL) {
+            goto fail;
+        }
+    }
+
+    /* the kernel runs with the GIL released, see residency.h */
+    pinned[0] = ap;
+    pinned[1] = res[0];
+    pinned[2] = res[1];
+    if (mpy_residency_pin_all(pinned, 3) < 0) {
+        goto fail;
+    }
+    /* the allocation may evict, so it cannot wait for the kernel */
+    npart = ncell * _welford_blocks(ncell, cell_stride, m, elem_stride,
+                                    &ncol, &rows);
+    if (npart > 0) {
+        partials = PyDataMemMic_NEW(3 * npart * sizeof(double), device);
+        if (partials == NULL) {
+            mpy_residency_unpin_all(pinned, 3);
+            PyErr_NoMemory();
+            goto fail;
+        }
+    }
+    NPY_BEGIN_ALLOW_THREADS;
+    _welford(device, read_type, PyMicArray_DATA(ap),
+             ncell, cell_stride, m, elem_stride,
+             (double *)PyMicArray_DATA(res[0]),
+             (double *)PyMicArray_DATA(res[1]), ddof, take_sqrt, partials);
+    NPY_END_ALLOW_THREADS;
+    if (partials != NULL) {
+        PyDataMemMic_FREE(partials, device);
+    }
+    mpy_residency_unpin_all(pinned, 3);
+
+    for (i = 0; i < 2; ++i) {
+        if (outs[i] == NULL) {
+            continue;
+        }
+        if (dtype->type_num != NPY_DOUBLE) {
+            Py_INCREF(dtype);
+            *outs[i] = (PyMicArrayObject *)PyMicArray_CastToType(res[i],
+                                                                 dtype, 0);
+            if (*outs[i] == NULL) {
+                if (i == 1 && mean != NULL) {
+                    Py_CLEAR(*mean);
+                }
+                goto fail;
+            }
+        }
+        else {
+            *outs[i] = res[i];
+            res[i] = NULL;
+        }
+    }
+
+    Py_XDECREF(res[0]);
+    Py_XDECREF(res[1]);
+    Py_DECREF(ap);
+    Py_DECREF(op);
+    Py_DECREF(dtype);
+    return 0;
+
+fail:
+    Py_XDECREF(res[0]);
+    Py_XDECREF(res[1]);
+    Py_XDECREF(ap);
+    Py_XDECREF(op);
+    Py_XDECREF(dtype);
+    return -1;
+}
+
+/*
+ * Mean (what 0), variance (1) or standard deviation (2) over axis, or
+ * all axes for NPY_MAXDIMS, written to out if given.
+ */
+static PyObject *
+_axis_stats(PyMicArrayObject *self, int axis, int rtype,
+            PyMicArrayObject *out, int ddof, int what)
+{
+    PyMicArrayObject *ret = NULL;
+    npy_bool axis_flags[NPY_MAXDIMS];
+    int idim;
+
+    if (axis != NPY_MAXDIMS &&
+            check_and_adjust_axis(&axis, PyMicArray_NDIM(self)) < 0) {
+        return NULL;
+    }
+    for (idim = 0; idim < PyMicArray_NDIM(self); ++idim) {
+        axis_flags[idim] = axis == NPY_MAXDIMS || idim == axis;
+    }
+    if (PyMicArray_MeanVar(self, axis_flags,
+                           rtype == NPY_NOTYPE ? NULL
+                                               : PyArray_DescrFromType(rtype),
+                           ddof, 0, what == 2,
+                           what == 0 ? &ret : NULL,
+                           what == 0 ? NULL : &ret) < 0) {
+        return NULL;
+    }
+    if (out != NULL) {
+        if (PyMicArray_AssignArray(out, ret, NULL, NPY_UNSAFE_CASTING) < 0) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(ret);
+        Py_INCREF(out);
+        return (PyObject *)out;
+    }
+    return (PyObject *)ret;
+}
+
 NPY_NO_EXPORT PyObject *
 __New_PyMicArray_Std(PyMicArrayObject *self, int axis, int rtype, PyMicArrayObject *out,
                   int variance, int num)
 {
-    return NULL;
+    return _axis_stats(self, axis, rtype, out, num, variance ? 1 : 2);
 }
 
-
 /*NUMPY_API
  *Sum
  */
@@ -406,8 +1095,7 @@ PyMicArray_Round(PyMicArrayObject *a, int decimals, PyMicArrayObject *out)
 NPY_NO_EXPORT PyObject *
 PyMicArray_Mean(PyMicArrayObject *self, int axis, int rtype, PyMicArrayObject *out)
 {
-    //TODO
-    return NULL;
+    return _axis_stats(self, axis, rtype, out, 0, 0);
 }
 
 /*NUMPY_API
@@ -13,12 +13,31 @@ PyMicArray_Max(PyMicArrayObject* self, int axis, PyMicArrayObject* out);
 NPY_NO_EXPORT PyObject*
 PyMicArray_Min(PyMicArrayObject* self, int axis, PyMicArrayObject* out);
 
+/*
+ * Minimum and maximum along axis, and their indices, in a single pass.
+ * The results not wanted may be NULL.
+ */
+NPY_NO_EXPORT int
+PyMicArray_MinMax(PyMicArrayObject *self, int axis,
+                  PyMicArrayObject **min, PyMicArrayObject **argmin,
+                  PyMicArrayObject **max, PyMicArrayObject **argmax);
+
 NPY_NO_EXPORT PyObject*
 PyMicArray_Ptp(PyMicArrayObject* self, int axis, PyMicArrayObject* out);
 
 NPY_NO_EXPORT PyObject*
 PyMicArray_Mean(PyMicArrayObject* self, int axis, int rtype, PyMicArrayObject* out);
 
+/*
+ * Mean and variance, or standard deviation, over several axes in a
+ * single pass. Steals the reference to dtype, which may be NULL.
+ */
+NPY_NO_EXPORT int
+PyMicArray_MeanVar(PyMicArrayObject *self, npy_bool *axis_flags,
+                   PyArray_Descr *dtype, int ddof, int keepdims,
+                   int take_sqrt,
+                   PyMicArrayObject **mean, PyMicArrayObject **var);
+
 NPY_NO_EXPORT PyObject *
 PyMicArray_Round(PyMicArrayObject *a, int decimals, PyMicArrayObject *out);
 
@@ -26,6 +26,7 @@
 #include "convert.h"
 #include "creators.h"
 #include "scalar.h"
+#include "residency.h"
 
 /* These might be faster without the dereferencing of obj
    going on inside -- of course an optimizing compiler should
@@ -97,7 +98,8 @@ gemm(int typenum, enum CBLAS_ORDER order,
 
     int device = PyMicArray_DEVICE(A);
 
-#pragma omp target device(device) map(to: typenum, order, transA, transB, m, n, k, \
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: typenum, order, transA, transB, m, n, k, \
                                     Adata, lda, Bdata, ldb, Rdata, ldc)
     switch (typenum) {
         case NPY_DOUBLE:
@@ -134,7 +136,8 @@ gemv(int typenum, enum CBLAS_ORDER order, enum CBLAS_TRANSPOSE trans,
     int m = PyMicArray_DIM(A, 0), n = PyMicArray_DIM(A, 1);
     int device = PyMicArray_DEVICE(A);
 
-#pragma omp target device(device) map(to: typenum, order, trans, m, n, \
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: typenum, order, trans, m, n, \
                                     Adata, lda, Xdata, incX, Rdata)
     switch (typenum) {
         case NPY_DOUBLE:
@@ -174,7 +177,8 @@ syrk(int typenum, enum CBLAS_ORDER order, enum CBLAS_TRANSPOSE trans,
     npy_intp i;
     npy_intp j;
 
-#pragma omp target device(device) map(to: typenum, order, trans, n, k, \
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: typenum, order, trans, n, k, \
                                   Adata, lda, ldc, Rdata, Rstrides[0:2])
     switch (typenum) {
         case NPY_DOUBLE:
@@ -304,6 +308,7 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
     MatrixShape ap1shape, ap2shape;
     void *tmpdata;
     int device = PyMicArray_DEVICE(ap1); // Assume on the same device
+    int pinned = 0;
 
     if (_bad_strides(ap1)) {
             PyObject *op1 = PyMicArray_NewCopy(ap1, NPY_ANYORDER);
@@ -503,9 +508,28 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
         result = out_buf;
     }
 
+    /*
+     * The data are used with the GIL released from here on, see
+     * residency.h. The copies made below swap their pin.
+     */
+    if (mpy_residency_pin(ap1) < 0) {
+        goto fail;
+    }
+    pinned = 1;
+    if (mpy_residency_pin(ap2) < 0) {
+        goto fail;
+    }
+    pinned = 2;
+    if (mpy_residency_pin(out_buf) < 0) {
+        goto fail;
+    }
+    pinned = 3;
     numbytes = PyMicArray_NBYTES(out_buf);
     target_memset(PyMicArray_DATA(out_buf), 0, numbytes, device);
     if (numbytes == 0 || l == 0) {
+            mpy_residency_unpin(ap1);
+            mpy_residency_unpin(ap2);
+            mpy_residency_unpin(out_buf);
             Py_DECREF(ap1);
             Py_DECREF(ap2);
             return PyMicArray_Return(out_buf);
@@ -535,11 +559,13 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
 
         if (typenum == NPY_DOUBLE) {
             if (l == 1) {
-                #pragma omp target device(device) map(to: outdata, ap1data, ap2data)
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: outdata, ap1data, ap2data)
                 *((double *)outdata) = *((double *)ap2data) * *((double *)ap1data);
             }
             else if (ap1shape != _matrix) {
-                #pragma omp target device(device) map(to: l, ap2data, ap1data, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, ap2data, ap1data, \
                                                         ap1stride, outdata)
                 cblas_daxpy(l,
                             *((double *)ap2data),
@@ -566,7 +592,7 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
                 incptr = PyMicArray_STRIDE(ap1, oind);
                 incoptr = PyMicArray_STRIDE(out_buf, oind);
 
-                #pragma omp target device(device) \
+                #pragma omp target device(mpy_omp_launch(device)) \
                                      map(to: l, ptr, a1s, optr, outs, ap2data,\
                                              niter, incptr, incoptr)
                 for (i = 0; i < niter; i++) {
@@ -581,7 +607,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
             if (l == 1) {
                 npy_cdouble *ptr1, *ptr2, *res;
 
-                #pragma omp target device(device) map(to: outdata, ap1data, ap2data)
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: outdata, ap1data, ap2data)
                 {
                     ptr1 = (npy_cdouble *)ap2data;
                     ptr2 = (npy_cdouble *)ap1data;
@@ -591,7 +618,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
                 }
             }
             else if (ap1shape != _matrix) {
-                #pragma omp target device(device) map(to: l, ap1stride, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, ap1stride, \
                                                     outdata, ap1data, ap2data)
                 cblas_zaxpy(l,
                             (double *)ap2data,
@@ -618,7 +646,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
                 incptr = PyMicArray_STRIDE(ap1, oind);
                 incoptr = PyMicArray_STRIDE(out_buf, oind);
 
-                #pragma omp target device(device) map(to: l, pval, ptr, a1s, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, pval, ptr, a1s, \
                                                       optr, outs, \
                                                       niter, incptr, incoptr)
                 for (i = 0; i < niter; i++) {
@@ -631,11 +660,13 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
         }
         else if (typenum == NPY_FLOAT) {
             if (l == 1) {
-                #pragma omp target device(device) map(to: outdata, ap1data, ap2data)
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: outdata, ap1data, ap2data)
                 *((float *)outdata) = *((float *)ap2data) * *((float *)ap1data);
             }
             else if (ap1shape != _matrix) {
-                #pragma omp target device(device) map(to: l, ap1stride, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, ap1stride, \
                                                       outdata, ap1data, ap2data)
                 cblas_saxpy(l,
                             *((float *)ap2data),
@@ -662,7 +693,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
                 incptr = PyMicArray_STRIDE(ap1, oind);
                 incoptr = PyMicArray_STRIDE(out_buf, oind);
 
-                #pragma omp target device(device) map(to: l, ptr, a1s, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, ptr, a1s, \
                                                       optr, outs, ap2data, \
                                                       niter, incptr, incoptr)
                 for (i = 0; i < niter; i++) {
@@ -677,7 +709,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
             if (l == 1) {
                 npy_cfloat *ptr1, *ptr2, *res;
                 
-                #pragma omp target device(device) map(to: outdata, ap1data, ap2data)
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: outdata, ap1data, ap2data)
                 {
                     ptr1 = (npy_cfloat *)PyMicArray_DATA(ap2);
                     ptr2 = (npy_cfloat *)PyMicArray_DATA(ap1);
@@ -687,7 +720,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
                 }
             }
             else if (ap1shape != _matrix) {
-                #pragma omp target device(device) map(to: l, ap1stride, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, ap1stride, \
                                                       outdata, ap1data, ap2data)
                 cblas_caxpy(l,
                             (float *)ap2data,
@@ -714,7 +748,8 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
                 incptr = PyMicArray_STRIDE(ap1, oind);
                 incoptr = PyMicArray_STRIDE(out_buf, oind);
 
-                #pragma omp target device(device) map(to: l, ptr, a1s, \
+                #pragma omp target device(mpy_omp_launch(device)) \
+                                   map(to: l, ptr, a1s, \
                                                       optr, outs, pval, \
                                                       niter, incptr, incoptr)
                 for (i = 0; i < niter; i++) {
@@ -747,9 +782,11 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
         if (!PyMicArray_ISONESEGMENT(ap1)) {
             PyObject *new;
             new = PyMicArray_Copy(ap1);
+            mpy_residency_unpin(ap1);
             Py_DECREF(ap1);
             ap1 = (PyMicArrayObject *)new;
-            if (new == NULL) {
+            if (new == NULL || mpy_residency_pin(ap1) < 0) {
+                Py_CLEAR(ap1);
                 goto fail;
             }
         }
@@ -774,9 +811,11 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
         if (!PyMicArray_ISONESEGMENT(ap2)) {
             PyObject *new;
             new = PyMicArray_Copy(ap2);
+            mpy_residency_unpin(ap2);
             Py_DECREF(ap2);
             ap2 = (PyMicArrayObject *)new;
-            if (new == NULL) {
+            if (new == NULL || mpy_residency_pin(ap2) < 0) {
+                Py_CLEAR(ap2);
                 goto fail;
             }
         }
@@ -816,18 +855,22 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
         if (!PyMicArray_IS_C_CONTIGUOUS(ap2) && !PyMicArray_IS_F_CONTIGUOUS(ap2)) {
             PyObject *new = PyMicArray_Copy(ap2);
 
+            mpy_residency_unpin(ap2);
             Py_DECREF(ap2);
             ap2 = (PyMicArrayObject *)new;
-            if (new == NULL) {
+            if (new == NULL || mpy_residency_pin(ap2) < 0) {
+                Py_CLEAR(ap2);
                 goto fail;
             }
         }
         if (!PyMicArray_IS_C_CONTIGUOUS(ap1) && !PyMicArray_IS_F_CONTIGUOUS(ap1)) {
             PyObject *new = PyMicArray_Copy(ap1);
 
+            mpy_residency_unpin(ap1);
             Py_DECREF(ap1);
             ap1 = (PyMicArrayObject *)new;
-            if (new == NULL) {
+            if (new == NULL || mpy_residency_pin(ap1) < 0) {
+                Py_CLEAR(ap1);
                 goto fail;
             }
         }
@@ -883,6 +926,9 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
     }
 
 
+    mpy_residency_unpin(ap1);
+    mpy_residency_unpin(ap2);
+    mpy_residency_unpin(out_buf);
     Py_DECREF(ap1);
     Py_DECREF(ap2);
 
@@ -892,6 +938,15 @@ cblas_matrixproduct(int typenum, PyMicArrayObject *ap1, PyMicArrayObject *ap2,
     return PyMicArray_Return(result);
 
 fail:
+    if (pinned > 0) {
+        mpy_residency_unpin(ap1);
+    }
+    if (pinned > 1) {
+        mpy_residency_unpin(ap2);
+    }
+    if (pinned > 2) {
+        mpy_residency_unpin(out_buf);
+    }
     Py_XDECREF(ap1);
     Py_XDECREF(ap2);
     Py_XDECREF(out_buf);
@@ -23,7 +23,7 @@ _zerofill(PyMicArrayObject *ret)
     }
     else {
         npy_intp n = PyMicArray_NBYTES(ret);
-        #pragma omp target device(ret->device)
+        #pragma omp target device(mpy_omp_launch(ret->device))
         memset(PyMicArray_DATA(ret), 0, n);
     }
     return 0;
@@ -18,6 +18,18 @@
 
 #define CPU_DEVICE (omp_get_initial_device())
 
+/*
+ * Pin the workers of the OpenMP team of the calling thread to the cores
+ * of the NUMA node of device, for a kernel launched on it. Only does
+ * something when the devices are host NUMA nodes (see numa.h), and only
+ * when the team was last pinned elsewhere. The other modules reach it
+ * through the API table.
+ */
+#ifndef PyMicArray_BindTeam
+NPY_NO_EXPORT void
+PyMicArray_BindTeam(int device);
+#endif
+
 /*
  * Define a chunksize for CBLAS. CBLAS counts in integers.
  */
@@ -17,8 +17,11 @@
 #include "scalar.h"
 #include "creators.h"
 #include "array_assign.h"
+#include "arraytypes.h"
 //#include "mapping.h"
 #include "convert.h"
+#include "staging.h"
+#include "residency.h"
 #include "lowlevel_strided_loops.h"
 
 int
@@ -71,14 +74,190 @@ npy_fallocate(npy_intp nbytes, FILE * fp)
 }
 
 
+/*
+ * Return self if it is contiguous in order, else a contiguous copy of it
+ * on the same device. New reference.
+ */
+static PyMicArrayObject *
+_contiguous_on_device(PyMicArrayObject *self, NPY_ORDER order)
+{
+    if ((order == NPY_FORTRANORDER) ? PyMicArray_IS_F_CONTIGUOUS(self)
+                                    : PyMicArray_IS_C_CONTIGUOUS(self)) {
+        Py_INCREF(self);
+        return self;
+    }
+    return (PyMicArrayObject *)PyMicArray_NewCopy(self, order);
+}
+
+/*NUMPY_API
+ * To File
+ *
+ * Only binary output is supported. The data leaves the device in chunks
+ * through the staging buffers, the host never holds a full copy of it.
+ */
+NPY_NO_EXPORT int
+PyMicArray_ToFile(PyMicArrayObject *self, FILE *fp, char *sep, char *format)
+{
+    PyMicArrayObject *src;
+    npy_intp nbytes;
+    npy_off_t pos;
+    int ret;
+
+    if (sep != NULL && strlen(sep) != 0) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "micpy only writes binary files, sep must be ''");
+        return -1;
+    }
+    if (PyDataType_FLAGCHK(PyMicArray_DESCR(self), NPY_LIST_PICKLE)) {
+        PyErr_SetString(PyExc_IOError,
+                "cannot write object arrays to a file in binary mode");
+        return -1;
+    }
+
+    src = _contiguous_on_device(self, NPY_CORDER);
+    if (src == NULL) {
+        return -1;
+    }
+    /* kept until the last chunk is written, see residency.h */
+    if (mpy_residency_pin(src) < 0) {
+        Py_DECREF(src);
+        return -1;
+    }
+    nbytes = PyMicArray_NBYTES(src);
+
+    if (npy_fallocate(nbytes, fp) != 0) {
+        mpy_residency_unpin(src);
+        Py_DECREF(src);
+        return -1;
+    }
+
+    /* the data goes to the descriptor, behind the back of the FILE */
+    fflush(fp);
+    pos = npy_ftell(fp);
+    if (pos < 0) {
+        PyErr_SetFromErrno(PyExc_IOError);
+        mpy_residency_unpin(src);
+        Py_DECREF(src);
+        return -1;
+    }
+
+    ret = mpy_write_from_device(fileno(fp), pos, nbytes,
+                                PyMicArray_DATA(src), PyMicArray_DEVICE(src));
+    mpy_residency_unpin(src);
+    Py_DECREF(src);
+    if (ret < 0) {
+        return -1;
+    }
+
+    if (npy_fseek(fp, pos + nbytes, SEEK_SET) != 0) {
+        PyErr_SetFromErrno(PyExc_IOError);
+        return -1;
+    }
+    return 0;
+}
+
+/*NUMPY_API
+ * Return the raw data of self in order as a bytes object, filled by
+ * one device to host copy.
+ */
+NPY_NO_EXPORT PyObject *
+PyMicArray_ToString(PyMicArrayObject *self, NPY_ORDER order)
+{
+    PyMicArrayObject *src;
+    PyObject *ret;
+    npy_intp nbytes;
+    int err = 0;
+
+    if (order == NPY_ANYORDER) {
+        order = PyMicArray_IS_F_CONTIGUOUS(self) &&
+                !PyMicArray_IS_C_CONTIGUOUS(self) ? NPY_FORTRANORDER
+                                                  : NPY_CORDER;
+    }
+
+    src = _contiguous_on_device(self, order);
+    if (src == NULL) {
+        return NULL;
+    }
+    nbytes = PyMicArray_NBYTES(src);
+
+    ret = PyBytes_FromStringAndSize(NULL, nbytes);
+    if (ret == NULL) {
+        Py_DECREF(src);
+        return NULL;
+    }
+    if (nbytes > 0) {
+        if (mpy_residency_pin(src) < 0) {
+            Py_DECREF(src);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        NPY_BEGIN_ALLOW_THREADS;
+        err = target_memcpy(PyBytes_AS_STRING(ret), PyMicArray_DATA(src),
+                            nbytes, CPU_DEVICE, PyMicArray_DEVICE(src));
+        NPY_END_ALLOW_THREADS;
+        mpy_residency_unpin(src);
+    }
+    Py_DECREF(src);
+    if (err != 0) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cannot copy the array to the host");
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
+
 /*NUMPY_API
  * To List
  */
 NPY_NO_EXPORT PyObject *
 PyMicArray_ToList(PyMicArrayObject *self)
 {
-    /*return PyArray_ToList((PyArrayObject *)self);*/
-    return NULL;
+    PyMicArrayObject *src;
+    PyArrayObject *host;
+    PyObject *ret;
+    npy_intp nbytes;
+    int err = 0;
+
+    /*
+     * The data come over in one transfer, and the list is built from
+     * the host copy instead of reading the items one by one.
+     */
+    src = _contiguous_on_device(self, NPY_CORDER);
+    if (src == NULL) {
+        return NULL;
+    }
+    Py_INCREF(PyMicArray_DESCR(src));
+    host = (PyArrayObject *)PyArray_NewFromDescr(&PyArray_Type,
+                                PyMicArray_DESCR(src), PyMicArray_NDIM(src),
+                                PyMicArray_DIMS(src), NULL, NULL, 0, NULL);
+    if (host == NULL) {
+        Py_DECREF(src);
+        return NULL;
+    }
+    nbytes = PyArray_NBYTES(host);
+    if (nbytes > 0) {
+        if (mpy_residency_pin(src) < 0) {
+            Py_DECREF(src);
+            Py_DECREF(host);
+            return NULL;
+        }
+        NPY_BEGIN_ALLOW_THREADS;
+        err = target_memcpy(PyArray_DATA(host), PyMicArray_DATA(src), nbytes,
+                            CPU_DEVICE, PyMicArray_DEVICE(src));
+        NPY_END_ALLOW_THREADS;
+        mpy_residency_unpin(src);
+    }
+    Py_DECREF(src);
+    if (err != 0) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cannot copy the array to the host");
+        Py_DECREF(host);
+        return NULL;
+    }
+    ret = PyArray_ToList(host);
+    Py_DECREF(host);
+    return ret;
 }
 
 /* XXX: FIXME --- add ordering argument to
@@ -87,6 +266,63 @@ PyMicArray_ToList(PyMicArrayObject *self)
  */
 
 
+#define _FILLABLE(type_num) \
+        (PyTypeNum_ISNUMBER(type_num) || PyTypeNum_ISBOOL(type_num))
+
+/*
+ * Fill a one-segment array of a numeric type with the scalar value of
+ * type dtype, in host memory, using the fillwithscalar kernel of the
+ * type: the value is cast on the host and written by the device
+ * threads, with no staging through device memory.
+ *
+ * Returns 1 if arr was filled, 0 if it does not qualify and -1 on error.
+ */
+static int
+_fill_contiguous(PyMicArrayObject *arr, PyArray_Descr *dtype, char *value)
+{
+    PyArray_Descr *descr = PyMicArray_DESCR(arr);
+    PyMicArray_FillWithScalarFunc *fill;
+    npy_longlong buffer[4];
+
+    if (!PyMicArray_ISONESEGMENT(arr) || !PyMicArray_ISALIGNED(arr) ||
+            !PyArray_ISNBO(descr->byteorder) ||
+            !PyArray_ISNBO(dtype->byteorder) ||
+            !_FILLABLE(descr->type_num) || !_FILLABLE(dtype->type_num) ||
+            descr->elsize > (int)sizeof(buffer)) {
+        return 0;
+    }
+    fill = PyMicArray_GetArrFuncs(descr->type_num)->fillwithscalar;
+    if (fill == NULL) {
+        return 0;
+    }
+    if (PyMicArray_FailUnlessWriteable(arr, "assignment destination") < 0) {
+        return -1;
+    }
+
+    if (!PyArray_EquivTypes(dtype, descr)) {
+        PyArray_VectorUnaryFunc *cast;
+
+        cast = PyArray_GetCastFunc(dtype, descr->type_num);
+        if (cast == NULL) {
+            return -1;
+        }
+        cast(value, buffer, 1, NULL, NULL);
+        value = (char *)buffer;
+    }
+
+    if (mpy_residency_pin(arr) < 0) {
+        return -1;
+    }
+    NPY_BEGIN_ALLOW_THREADS;
+    fill(PyMicArray_DATA(arr), PyMicArray_SIZE(arr), value,
+         PyMicArray_DEVICE(arr));
+    NPY_END_ALLOW_THREADS;
+    mpy_residency_unpin(arr);
+    return 1;
+}
+
+#undef _FILLABLE
+
 /*NUMPY_API*/
 NPY_NO_EXPORT int
 PyMicArray_FillWithScalar(PyMicArrayObject *arr, PyObject *obj)
@@ -210,6 +446,14 @@ PyMicArray_FillWithScalar(PyMicArrayObject *arr, PyObject *obj)
 
     /* Use the value pointer we got if possible */
     if (value != NULL) {
+        /* the value is in host memory unless it came from a MicArray */
+        if (!PyMicArray_Check(obj)) {
+            retcode = _fill_contiguous(arr, dtype, value);
+            if (retcode != 0) {
+                Py_DECREF(dtype);
+                return retcode < 0 ? -1 : 0;
+            }
+        }
         /* TODO: switch to SAME_KIND casting */
         retcode = PyMicArray_AssignRawScalar(arr, dtype, value,
                                 device, NULL, NPY_UNSAFE_CASTING);
@@ -269,8 +513,15 @@ PyMicArray_AssignZero(PyMicArrayObject *dst,
     }
     value = 0;
 
-    retcode = PyMicArray_AssignRawScalar(dst, bool_dtype, (char *)&value,
+    retcode = wheremask == NULL ?
+                _fill_contiguous(dst, bool_dtype, (char *)&value) : 0;
+    if (retcode == 0) {
+        retcode = PyMicArray_AssignRawScalar(dst, bool_dtype, (char *)&value,
                                       CPU_DEVICE, wheremask, NPY_SAFE_CASTING);
+    }
+    else if (retcode > 0) {
+        retcode = 0;
+    }
 
     Py_DECREF(bool_dtype);
     return retcode;
@@ -299,8 +550,15 @@ PyMicArray_AssignOne(PyMicArrayObject *dst,
     }
     value = 1;
 
-    retcode = PyMicArray_AssignRawScalar(dst, bool_dtype, (char *)&value,
+    retcode = wheremask == NULL ?
+                _fill_contiguous(dst, bool_dtype, (char *)&value) : 0;
+    if (retcode == 0) {
+        retcode = PyMicArray_AssignRawScalar(dst, bool_dtype, (char *)&value,
                                       CPU_DEVICE, wheremask, NPY_SAFE_CASTING);
+    }
+    else if (retcode > 0) {
+        retcode = 0;
+    }
 
     Py_DECREF(bool_dtype);
     return retcode;
@@ -363,6 +621,11 @@ PyMicArray_View(PyMicArrayObject *self, PyArray_Descr *type, PyTypeObject *pytyp
 
     flags = PyMicArray_FLAGS(self);
 
+    /* the view pins the data once its base is set, see residency.h */
+    if (mpy_residency_pin(self) < 0) {
+        Py_XDECREF(type);
+        return NULL;
+    }
     dtype = PyMicArray_DESCR(self);
     Py_INCREF(dtype);
     ret = (PyMicArrayObject *)PyMicArray_NewFromDescr_int(
@@ -375,6 +638,7 @@ PyMicArray_View(PyMicArrayObject *self, PyArray_Descr *type, PyTypeObject *pytyp
                                flags,
                                (PyObject *)self, 0, 1);
     if (ret == NULL) {
+        mpy_residency_unpin(self);
         Py_XDECREF(type);
         return NULL;
     }
@@ -382,10 +646,12 @@ PyMicArray_View(PyMicArrayObject *self, PyArray_Descr *type, PyTypeObject *pytyp
     /* Set the base object */
     Py_INCREF(self);
     if (PyMicArray_SetBaseObject(ret, (PyObject *)self) < 0) {
+        mpy_residency_unpin(self);
         Py_DECREF(ret);
         Py_XDECREF(type);
         return NULL;
     }
+    mpy_residency_unpin(self);
 
     if (type != NULL) {
         if (PyObject_SetAttrString((PyObject *)ret, "dtype",
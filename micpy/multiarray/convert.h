@@ -26,4 +26,13 @@ PyMicArray_View(PyMicArrayObject *self,
 NPY_NO_EXPORT int
 PyMicArray_FillWithScalar(PyMicArrayObject *arr, PyObject *obj);
 
+NPY_NO_EXPORT int
+PyMicArray_ToFile(PyMicArrayObject *self, FILE *fp, char *sep, char *format);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_ToString(PyMicArrayObject *self, NPY_ORDER order);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_ToList(PyMicArrayObject *self);
+
 #endif
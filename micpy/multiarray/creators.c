@@ -15,6 +15,7 @@
 #include "common.h"
 #include "mpy_common.h"
 #include "arrayobject.h"
+#include "mpyndarraytypes.h"
 #include "multiarraymodule.h"
 #include "creators.h"
 #include "convert.h"
@@ -26,6 +27,12 @@
 #include "mpy_lowlevel_strided_loops.h"
 #include "methods.h"
 #include "alloc.h"
+#include "staging.h"
+#include "residency.h"
+#include "arraytypes.h"
+
+#include <sys/stat.h>
+#include <math.h>
 
 
 /*
@@ -389,6 +396,9 @@ PyMicArray_NewFromDescr_int(int device, PyTypeObject *subtype, PyArray_Descr *de
         fa->flags &= ~NPY_ARRAY_OWNDATA;
     }
     fa->data = data;
+    if ((fa->flags & NPY_ARRAY_OWNDATA) && mpy_residency_enabled()) {
+        mpy_residency_track(fa, nbytes);
+    }
 
     /*
      * always update the flags to get the right CONTIGUOUS, ALIGN properties
@@ -610,6 +620,25 @@ PyMicArray_FromAny(int device, PyObject *op, PyArray_Descr *newtype, int min_dep
         return PyMicArray_FromArray((PyArrayObject *)op, newtype, device, flags);
     }
 
+    /* Objects exporting device data are wrapped, not copied */
+    ret = PyMicArray_FromStructInterface(op);
+    if (ret == Py_NotImplemented) {
+        ret = PyMicArray_FromInterface(op);
+    }
+    if (ret == Py_NotImplemented) {
+        ret = PyMicArray_FromArrayAttr(op, newtype, context);
+    }
+    if (ret == NULL) {
+        Py_XDECREF(newtype);
+        return NULL;
+    }
+    if (ret != Py_NotImplemented) {
+        PyObject *res = PyMicArray_FromArray((PyArrayObject *)ret, newtype,
+                                             device, flags);
+        Py_DECREF(ret);
+        return res;
+    }
+
     arr = (PyArrayObject *) PyArray_FromAny(op, newtype, min_depth, max_depth,
                                             flags, context);
     if (arr == NULL) {
@@ -843,30 +872,336 @@ PyMicArray_FromArray(PyArrayObject *arr, PyArray_Descr *newtype, int device, int
     return (PyObject *)ret;
 }
 
-/*NUMPY_API */
+/*
+ * Wrap data, already on device, into a new array keeping a reference
+ * to owner. Steals the reference to descr. The device kernels handle
+ * neither object references nor swapped data, so these are refused.
+ */
+static PyObject *
+_wrap_device_data(int device, PyArray_Descr *descr, int nd, npy_intp *dims,
+                  npy_intp *strides, void *data, int writeable,
+                  PyObject *owner)
+{
+    PyMicArrayObject *ret;
+
+    if (device < 0 || device >= N_DEVICES) {
+        PyErr_Format(PyExc_ValueError,
+                     "interface device %d is not a valid device", device);
+        Py_DECREF(descr);
+        return NULL;
+    }
+    if (PyDataType_REFCHK(descr)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "cannot wrap device data holding object references");
+        Py_DECREF(descr);
+        return NULL;
+    }
+    if (!PyArray_ISNBO(descr->byteorder)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "cannot wrap device data in non-native byte order");
+        Py_DECREF(descr);
+        return NULL;
+    }
+    ret = (PyMicArrayObject *)PyMicArray_NewFromDescr(device,
+                                    &PyMicArray_Type, descr, nd, dims,
+                                    strides, data,
+                                    writeable ? NPY_ARRAY_WRITEABLE : 0,
+                                    NULL);
+    if (ret == NULL) {
+        return NULL;
+    }
+    Py_INCREF(owner);
+    if (PyMicArray_SetBaseObject(ret, owner) < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return (PyObject *)ret;
+}
+
+/*NUMPY_API
+ * Wrap the data described by the "mic_array_struct" capsule of
+ * input.__mic_array_struct__ without copying it.
+ * Returns Py_NotImplemented if input does not have the attribute.
+ */
 NPY_NO_EXPORT PyObject *
 PyMicArray_FromStructInterface(PyObject *input)
 {
-    //TODO: implement
+    PyArray_Descr *thetype = NULL;
+    char buf[40];
+    PyMicArrayInterface *inter;
+    PyObject *attr, *typestr;
+    char endian = NPY_NATBYTE;
+
+    attr = PyObject_GetAttr(input, mpy_ma_str_mic_array_struct);
+    if (attr == NULL) {
+        PyErr_Clear();
+        return Py_NotImplemented;
+    }
+    if (!NpyCapsule_Check(attr)) {
+        goto fail;
+    }
+    inter = NpyCapsule_AsVoidPtr(attr);
+    if (inter == NULL || inter->two != 2) {
+        goto fail;
+    }
+    if ((inter->flags & NPY_ARRAY_NOTSWAPPED) != NPY_ARRAY_NOTSWAPPED) {
+        endian = NPY_OPPBYTE;
+        inter->flags &= ~NPY_ARRAY_NOTSWAPPED;
+    }
+
+    PyOS_snprintf(buf, sizeof(buf),
+                  "%c%c%d", endian, inter->typekind, inter->itemsize);
+    typestr = PyUString_FromString(buf);
+    if (typestr == NULL) {
+        Py_DECREF(attr);
+        return NULL;
+    }
+    if (!PyArray_DescrConverter(typestr, &thetype)) {
+        Py_DECREF(typestr);
+        Py_DECREF(attr);
+        return NULL;
+    }
+    Py_DECREF(typestr);
+
+    /* the array keeps the capsule, and so the exporter, alive */
+    input = _wrap_device_data(inter->device, thetype, inter->nd,
+                              inter->shape, inter->strides, inter->data,
+                              inter->flags & NPY_ARRAY_WRITEABLE, attr);
+    Py_DECREF(attr);
+    return input;
+
+ fail:
+    PyErr_SetString(PyExc_ValueError, "invalid __mic_array_struct__");
+    Py_DECREF(attr);
     return NULL;
 }
 
 #define PyIntOrLong_Check(obj) (PyInt_Check(obj) || PyLong_Check(obj))
 
-/*NUMPY_API*/
+/*NUMPY_API
+ * Wrap the device data described by the origin.__mic_array_interface__
+ * dict without copying it:
+ *
+ *   pointer   int, address of the first element in device memory
+ *   device    int, device holding the data
+ *   shape     tuple of int
+ *   typestr   str, as in __array_interface__
+ *   strides   tuple of int, or None/missing for C contiguous data
+ *   readonly  bool, optional
+ *   owner     object keeping the data alive, origin if missing
+ *
+ * Returns Py_NotImplemented if origin does not have the attribute.
+ */
 NPY_NO_EXPORT PyObject *
 PyMicArray_FromInterface(PyObject *origin)
 {
-    //TODO: implement
+    PyObject *iface, *attr, *owner;
+    PyArray_Descr *dtype = NULL;
+    void *data;
+    npy_intp dims[NPY_MAXDIMS], strides[NPY_MAXDIMS];
+    npy_intp *stridesptr = NULL;
+    int nd, device, readonly = 0;
+    PyObject *ret;
+
+    iface = PyObject_GetAttr(origin, mpy_ma_str_mic_array_interface);
+    if (iface == NULL) {
+        PyErr_Clear();
+        return Py_NotImplemented;
+    }
+    if (!PyDict_Check(iface)) {
+        Py_DECREF(iface);
+        PyErr_SetString(PyExc_ValueError,
+                "Invalid __mic_array_interface__ value, must be a dict");
+        return NULL;
+    }
+
+    /* data type */
+    attr = PyDict_GetItemString(iface, "typestr");
+    if (attr == NULL) {
+        PyErr_SetString(PyExc_ValueError,
+                "Missing __mic_array_interface__ typestr");
+        goto fail;
+    }
+    if (!PyArray_DescrConverter(attr, &dtype)) {
+        goto fail;
+    }
+
+    /* shape */
+    attr = PyDict_GetItemString(iface, "shape");
+    if (attr == NULL || !PyTuple_Check(attr)) {
+        PyErr_SetString(PyExc_ValueError,
+                "Missing or invalid __mic_array_interface__ shape");
+        goto fail;
+    }
+    nd = PyArray_IntpFromSequence(attr, dims, NPY_MAXDIMS);
+    if (nd < 0) {
+        goto fail;
+    }
+
+    /* data pointer and device */
+    attr = PyDict_GetItemString(iface, "pointer");
+    if (attr == NULL || !PyIntOrLong_Check(attr)) {
+        PyErr_SetString(PyExc_ValueError,
+                "Missing or invalid __mic_array_interface__ pointer");
+        goto fail;
+    }
+    data = PyLong_AsVoidPtr(attr);
+    if (data == NULL && PyErr_Occurred()) {
+        goto fail;
+    }
+    attr = PyDict_GetItemString(iface, "device");
+    if (attr == NULL || !PyIntOrLong_Check(attr)) {
+        PyErr_SetString(PyExc_ValueError,
+                "Missing or invalid __mic_array_interface__ device");
+        goto fail;
+    }
+    device = (int)PyInt_AsLong(attr);
+    if (device == -1 && PyErr_Occurred()) {
+        goto fail;
+    }
+
+    attr = PyDict_GetItemString(iface, "readonly");
+    if (attr != NULL) {
+        readonly = PyObject_IsTrue(attr);
+        if (readonly < 0) {
+            goto fail;
+        }
+    }
+
+    /* strides */
+    attr = PyDict_GetItemString(iface, "strides");
+    if (attr != NULL && attr != Py_None) {
+        if (!PyTuple_Check(attr) ||
+                PyArray_IntpFromSequence(attr, strides, nd) != nd) {
+            if (!PyErr_Occurred()) {
+                PyErr_SetString(PyExc_ValueError,
+                        "__mic_array_interface__ strides must be a tuple "
+                        "as long as the shape");
+            }
+            goto fail;
+        }
+        stridesptr = strides;
+    }
+
+    owner = PyDict_GetItemString(iface, "owner");
+    if (owner == NULL || owner == Py_None) {
+        owner = origin;
+    }
+
+    ret = _wrap_device_data(device, dtype, nd, dims, stridesptr, data,
+                            !readonly, owner);
+    Py_DECREF(iface);
+    return ret;
+
+ fail:
+    Py_XDECREF(dtype);
+    Py_DECREF(iface);
     return NULL;
 }
 
-/*NUMPY_API*/
+/*NUMPY_API
+ * Convert op through its __mic_array__ method, to typecode if given.
+ * Returns Py_NotImplemented if op does not have the method.
+ */
 NPY_NO_EXPORT PyObject *
 PyMicArray_FromArrayAttr(PyObject *op, PyArray_Descr *typecode, PyObject *context)
 {
-    //TODO(superbo): implement this
-    return NULL;
+    PyObject *new;
+    PyObject *array_meth;
+
+    array_meth = PyObject_GetAttr(op, mpy_ma_str_mic_array);
+    if (array_meth == NULL) {
+        PyErr_Clear();
+        return Py_NotImplemented;
+    }
+    if (typecode == NULL) {
+        new = PyObject_CallFunction(array_meth, NULL);
+    }
+    else {
+        new = PyObject_CallFunction(array_meth, "O", typecode);
+    }
+    Py_DECREF(array_meth);
+    if (new == NULL) {
+        return NULL;
+    }
+    if (!PyMicArray_Check(new)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "object __mic_array__ method not "
+                        "producing an array");
+        Py_DECREF(new);
+        return NULL;
+    }
+    return new;
+}
+
+/*NUMPY_API
+ * Read num items of type dtype from fd, starting at offset, into a new
+ * 1-d array on device. If num is negative, read up to the end of the file.
+ * direct tells that fd was opened with O_DIRECT.
+ *
+ * The data is streamed through the staging buffers, never holding more
+ * than two chunks of it on the host.
+ *
+ * steals a reference to dtype
+ */
+NPY_NO_EXPORT PyObject *
+PyMicArray_FromFile(int device, int fd, npy_off_t offset,
+                    PyArray_Descr *dtype, npy_intp num, int direct)
+{
+    PyMicArrayObject *ret;
+    struct stat st;
+    npy_intp nbytes;
+    int err;
+
+    if (PyDataType_REFCHK(dtype)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Cannot read into object array");
+        Py_DECREF(dtype);
+        return NULL;
+    }
+    if (dtype->elsize == 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "The elements are 0-sized.");
+        Py_DECREF(dtype);
+        return NULL;
+    }
+
+    if (num < 0) {
+        if (fstat(fd, &st) < 0) {
+            PyErr_SetFromErrno(PyExc_IOError);
+            Py_DECREF(dtype);
+            return NULL;
+        }
+        if (st.st_size < offset) {
+            PyErr_SetString(PyExc_ValueError, "offset is past end of file");
+            Py_DECREF(dtype);
+            return NULL;
+        }
+        num = (npy_intp)((st.st_size - offset) / dtype->elsize);
+    }
+
+    ret = (PyMicArrayObject *)PyMicArray_NewFromDescr(device, &PyMicArray_Type,
+                                                      dtype, 1, &num,
+                                                      NULL, NULL, 0, NULL);
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    /* the read releases the GIL, see residency.h */
+    if (mpy_residency_pin(ret) < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    nbytes = num * PyMicArray_DESCR(ret)->elsize;
+    err = mpy_read_to_device(fd, offset, nbytes, PyMicArray_DATA(ret),
+                             device, direct);
+    mpy_residency_unpin(ret);
+    if (err < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+
+    return (PyObject *)ret;
 }
 
 /* TODO: Put the order parameter in PyArray_CopyAnyInto and remove this */
@@ -1076,14 +1411,109 @@ static int _safe_ceil_to_intp(double value, npy_intp* ret)
 }
 
 
+/*
+ * Write start and next as the first two elements of range, and have the
+ * fill kernel of the type generate the others on the device from them.
+ */
+static int
+_arange_fill_pinned(PyMicArrayObject *range, PyObject *start, PyObject *next)
+{
+    PyMicArray_ArrFuncs *funcs;
+    npy_intp length = PyMicArray_SIZE(range);
+
+    funcs = PyMicArray_GetArrFuncs(PyMicArray_DESCR(range)->type_num);
+    if (funcs->setitem(start, PyMicArray_DATA(range), range) < 0) {
+        return -1;
+    }
+    if (length == 1) {
+        return 0;
+    }
+    if (funcs->setitem(next, PyMicArray_BYTES(range) +
+                             PyMicArray_ITEMSIZE(range), range) < 0) {
+        return -1;
+    }
+    if (length == 2) {
+        return 0;
+    }
+    if (!funcs->fill) {
+        PyErr_SetString(PyExc_ValueError, "no fill-function for data-type.");
+        return -1;
+    }
+    NPY_BEGIN_ALLOW_THREADS;
+    funcs->fill(PyMicArray_DATA(range), length, PyMicArray_DEVICE(range));
+    NPY_END_ALLOW_THREADS;
+    return 0;
+}
+
+/* the fill runs with the GIL released, see residency.h */
+static int
+_arange_fill(PyMicArrayObject *range, PyObject *start, PyObject *next)
+{
+    int ret;
+
+    if (mpy_residency_pin(range) < 0) {
+        return -1;
+    }
+    ret = _arange_fill_pinned(range, start, next);
+    mpy_residency_unpin(range);
+    return ret;
+}
+
 /*NUMPY_API
   Arange,
 */
 NPY_NO_EXPORT PyObject *
 PyMicArray_Arange(double start, double stop, double step, int type_num)
 {
-    //TODO: implement
-    return NULL;
+    npy_intp length;
+    PyMicArrayObject *range;
+    PyObject *o_start, *o_next;
+    double delta, tmp_len;
+    int ret;
+
+    if (step == 0) {
+        PyErr_SetString(PyExc_ValueError, "Maximum allowed size exceeded");
+        return NULL;
+    }
+    delta = stop - start;
+    tmp_len = delta / step;
+
+    /* Underflow and divide-by-inf check */
+    if (tmp_len == 0.0 && delta != 0.0) {
+        length = npy_signbit(tmp_len) ? 0 : 1;
+    }
+    else if (_safe_ceil_to_intp(tmp_len, &length)) {
+        PyErr_SetString(PyExc_OverflowError,
+                "arange: overflow while computing length");
+        return NULL;
+    }
+    if (length <= 0) {
+        length = 0;
+    }
+
+    range = (PyMicArrayObject *)PyMicArray_New(CURRENT_DEVICE,
+                                               &PyMicArray_Type, 1, &length,
+                                               type_num, NULL, NULL, 0, 0,
+                                               NULL);
+    if (range == NULL || length == 0) {
+        return (PyObject *)range;
+    }
+
+    o_start = PyFloat_FromDouble(start);
+    o_next = PyFloat_FromDouble(start + step);
+    if (o_start == NULL || o_next == NULL) {
+        ret = -1;
+    }
+    else {
+        ret = _arange_fill(range, o_start, o_next);
+    }
+    Py_XDECREF(o_start);
+    Py_XDECREF(o_next);
+    if (ret < 0) {
+        Py_DECREF(range);
+        return NULL;
+    }
+    return (PyObject *)range;
 }
 
 /*
@@ -1157,6 +1587,327 @@ _calc_length(PyObject *start, PyObject *stop, PyObject *step, PyObject **next, i
     return len;
 }
 
+/*
+ * Like numpy.arange, with the values generated on device: only the first
+ * two are converted on the host. dtype may be NULL.
+ *
+ * This doesn't change the references.
+ */
+NPY_NO_EXPORT PyObject *
+PyMicArray_ArangeObj(int device, PyObject *start, PyObject *stop,
+                     PyObject *step, PyArray_Descr *dtype)
+{
+    PyMicArrayObject *range = NULL;
+    PyObject *next = NULL, *err;
+    npy_intp length;
+
+    if (!dtype) {
+        PyArray_Descr *deftype;
+        PyArray_Descr *newtype;
+
+        /* intentionally made to be at least NPY_LONG */
+        deftype = PyArray_DescrFromType(NPY_LONG);
+        newtype = PyArray_DescrFromObject(start, deftype);
+        Py_DECREF(deftype);
+        if (newtype == NULL) {
+            return NULL;
+        }
+        deftype = newtype;
+        if (stop && stop != Py_None) {
+            newtype = PyArray_DescrFromObject(stop, deftype);
+            Py_DECREF(deftype);
+            if (newtype == NULL) {
+                return NULL;
+            }
+            deftype = newtype;
+        }
+        if (step && step != Py_None) {
+            newtype = PyArray_DescrFromObject(step, deftype);
+            Py_DECREF(deftype);
+            if (newtype == NULL) {
+                return NULL;
+            }
+            deftype = newtype;
+        }
+        dtype = deftype;
+    }
+    else if (!PyArray_ISNBO(dtype->byteorder)) {
+        /* device arrays are always in native byte order */
+        dtype = PyArray_DescrNewByteorder(dtype, NPY_NATIVE);
+        if (dtype == NULL) {
+            return NULL;
+        }
+    }
+    else {
+        Py_INCREF(dtype);
+    }
+
+    if (!step || step == Py_None) {
+        step = PyInt_FromLong(1);
+    }
+    else {
+        Py_INCREF(step);
+    }
+    if (!stop || stop == Py_None) {
+        stop = start;
+        start = PyInt_FromLong(0);
+    }
+    else {
+        Py_INCREF(start);
+    }
+
+    /* calculate the length */
+    length = _calc_length(start, stop, step, &next,
+                          PyTypeNum_ISCOMPLEX(dtype->type_num));
+    err = PyErr_Occurred();
+    if (err) {
+        Py_DECREF(dtype);
+        if (PyErr_GivenExceptionMatches(err, PyExc_OverflowError)) {
+            PyErr_SetString(PyExc_ValueError, "Maximum allowed size exceeded");
+        }
+        goto fail;
+    }
+    if (length <= 0) {
+        length = 0;
+    }
+
+    range = (PyMicArrayObject *)PyMicArray_NewFromDescr(device,
+                                                        &PyMicArray_Type,
+                                                        dtype, 1, &length,
+                                                        NULL, NULL, 0, NULL);
+    if (range == NULL) {
+        goto fail;
+    }
+    if (length > 0 && _arange_fill(range, start, next) < 0) {
+        Py_CLEAR(range);
+        goto fail;
+    }
+
+    Py_DECREF(start);
+    Py_DECREF(step);
+    Py_XDECREF(next);
+    return (PyObject *)range;
+
+ fail:
+    Py_DECREF(start);
+    Py_DECREF(step);
+    Py_XDECREF(next);
+    return NULL;
+}
+
+/*
+ * num evenly spaced doubles from start to stop, every stride doubles
+ * from out, computed on device the way numpy.linspace computes them.
+ * With round_down they are floored, as numpy does before a cast to an
+ * integer type.
+ */
+static void
+_linspace_fill(double *out, npy_intp stride, npy_intp num,
+               double start, double stop, int endpoint, int round_down,
+               int device)
+{
+    double div = endpoint ? num - 1 : num;
+    double delta = stop - start;
+    double step = div > 0 ? delta / div : NPY_NAN;
+    /* when delta / div underflows, scale each element instead */
+    int scale = !(div > 0) || step == 0;
+
+    if (!(div > 0)) {
+        div = 1;
+    }
+    #pragma omp target device(mpy_omp_launch(device)) \
+                       map(to: out, stride, num, start, \
+                                              stop, endpoint, div, delta, \
+                                              step, scale, round_down)
+    {
+        npy_intp i;
+
+        #pragma omp parallel for
+        for (i = 0; i < num; i++) {
+            double v = scale ? (i / div) * delta + start : i * step + start;
+
+            out[i * stride] = round_down ? floor(v) : v;
+        }
+        if (endpoint && num > 1) {
+            out[(num - 1) * stride] = round_down ? floor(stop) : stop;
+        }
+    }
+}
+
+static int
+_is_complex_object(PyObject *op)
+{
+    return PyComplex_Check(op) || PyArray_IsScalar(op, ComplexFloating);
+}
+
+/*
+ * Like numpy.linspace: num evenly spaced values over [start, stop], or
+ * [start, stop) without endpoint, generated on device in double or
+ * complex double precision and then cast to dtype if given. Like numpy,
+ * real values are floored before a cast to an integer type. If retstep
+ * is not NULL, it is set to a new reference to the spacing.
+ *
+ * Steals a reference to dtype, which may be NULL.
+ */
+NPY_NO_EXPORT PyObject *
+PyMicArray_Linspace(int device, PyObject *start, PyObject *stop,
+                    npy_intp num, int endpoint, PyArray_Descr *dtype,
+                    PyObject **retstep)
+{
+    PyMicArrayObject *ret;
+    Py_complex c_start, c_stop;
+    int cmplx = _is_complex_object(start) || _is_complex_object(stop);
+    int round_down;
+    double div = endpoint ? num - 1 : num;
+
+    if (num < 0) {
+        PyErr_Format(PyExc_ValueError,
+                     "Number of samples, %" NPY_INTP_FMT ", must be "
+                     "non-negative.", num);
+        goto fail;
+    }
+    if (cmplx) {
+        c_start = PyComplex_AsCComplex(start);
+        c_stop = PyComplex_AsCComplex(stop);
+    }
+    else {
+        c_start.real = PyFloat_AsDouble(start);
+        c_stop.real = PyFloat_AsDouble(stop);
+        c_start.imag = c_stop.imag = 0;
+    }
+    if (PyErr_Occurred()) {
+        goto fail;
+    }
+    round_down = !cmplx && dtype != NULL &&
+                 PyTypeNum_ISINTEGER(dtype->type_num);
+
+    ret = (PyMicArrayObject *)PyMicArray_New(device, &PyMicArray_Type,
+                                             1, &num,
+                                             cmplx ? NPY_CDOUBLE : NPY_DOUBLE,
+                                             NULL, NULL, 0, 0, NULL);
+    if (ret == NULL) {
+        goto fail;
+    }
+    if (num > 0) {
+        double *out;
+
+        if (mpy_residency_pin(ret) < 0) {
+            Py_DECREF(ret);
+            goto fail;
+        }
+        out = PyMicArray_DATA(ret);
+        NPY_BEGIN_ALLOW_THREADS;
+        _linspace_fill(out, cmplx ? 2 : 1, num, c_start.real, c_stop.real,
+                       endpoint, round_down, device);
+        if (cmplx) {
+            _linspace_fill(out + 1, 2, num, c_start.imag, c_stop.imag,
+                           endpoint, 0, device);
+        }
+        NPY_END_ALLOW_THREADS;
+        mpy_residency_unpin(ret);
+    }
+
+    if (retstep != NULL) {
+        if (!(div > 0)) {
+            *retstep = PyFloat_FromDouble(NPY_NAN);
+        }
+        else if (cmplx) {
+            *retstep = PyComplex_FromDoubles(
+                                    (c_stop.real - c_start.real) / div,
+                                    (c_stop.imag - c_start.imag) / div);
+        }
+        else {
+            *retstep = PyFloat_FromDouble((c_stop.real - c_start.real) / div);
+        }
+        if (*retstep == NULL) {
+            Py_DECREF(ret);
+            goto fail;
+        }
+    }
+
+    if (dtype != NULL && !PyArray_EquivTypes(dtype, PyMicArray_DESCR(ret))) {
+        PyObject *cast = PyMicArray_CastToType(ret, dtype, 0);
+
+        Py_DECREF(ret);
+        if (cast == NULL && retstep != NULL) {
+            Py_CLEAR(*retstep);
+        }
+        return cast;
+    }
+    Py_XDECREF(dtype);
+    return (PyObject *)ret;
+
+ fail:
+    Py_XDECREF(dtype);
+    return NULL;
+}
+
+/*
+ * Like numpy.eye: an n x m array of zeros with ones on the k-th
+ * diagonal. The ones are written through a strided view of the
+ * diagonal, on device.
+ *
+ * Steals a reference to dtype, which may be NULL.
+ */
+NPY_NO_EXPORT PyObject *
+PyMicArray_Eye(int device, npy_intp n, npy_intp m, npy_intp k,
+               PyArray_Descr *dtype, int is_f_order)
+{
+    PyMicArrayObject *ret, *diag;
+    PyArray_Descr *descr;
+    PyObject *one;
+    npy_intp dims[2] = {n, m};
+    npy_intp length, offset, stride;
+
+    ret = (PyMicArrayObject *)PyMicArray_Zeros(device, 2, dims, dtype,
+                                               is_f_order);
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    if (k >= 0) {
+        length = PyArray_MIN(n, m - k);
+        offset = k * PyMicArray_STRIDE(ret, 1);
+    }
+    else {
+        length = PyArray_MIN(n + k, m);
+        offset = -k * PyMicArray_STRIDE(ret, 0);
+    }
+    if (length <= 0) {
+        return (PyObject *)ret;
+    }
+    stride = PyMicArray_STRIDE(ret, 0) + PyMicArray_STRIDE(ret, 1);
+
+    descr = PyMicArray_DESCR(ret);
+    Py_INCREF(descr);
+    diag = (PyMicArrayObject *)PyMicArray_NewFromDescr(device,
+                                        &PyMicArray_Type, descr,
+                                        1, &length, &stride,
+                                        PyMicArray_BYTES(ret) + offset,
+                                        NPY_ARRAY_WRITEABLE, NULL);
+    if (diag == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    Py_INCREF(ret);
+    if (PyMicArray_SetBaseObject(diag, (PyObject *)ret) < 0) {
+        Py_DECREF(diag);
+        Py_DECREF(ret);
+        return NULL;
+    }
+
+    one = PyInt_FromLong(1);
+    if (one == NULL || PyMicArray_FillWithScalar(diag, one) < 0) {
+        Py_XDECREF(one);
+        Py_DECREF(diag);
+        Py_DECREF(ret);
+        return NULL;
+    }
+    Py_DECREF(one);
+    Py_DECREF(diag);
+    return (PyObject *)ret;
+}
+
 #undef FROM_BUFFER_SIZE
 
 
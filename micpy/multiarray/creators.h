@@ -44,6 +44,22 @@ PyMicArray_Zeros(int device, int nd, npy_intp *dims,
                     PyArray_Descr *type, int is_f_order);
 
 
+NPY_NO_EXPORT PyObject *
+PyMicArray_Arange(double start, double stop, double step, int type_num);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_ArangeObj(int device, PyObject *start, PyObject *stop,
+                     PyObject *step, PyArray_Descr *dtype);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_Linspace(int device, PyObject *start, PyObject *stop,
+                    npy_intp num, int endpoint, PyArray_Descr *dtype,
+                    PyObject **retstep);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_Eye(int device, npy_intp n, npy_intp m, npy_intp k,
+               PyArray_Descr *dtype, int is_f_order);
+
 NPY_NO_EXPORT PyObject *
 PyMicArray_FromAny(int device, PyObject *op, PyArray_Descr *newtype, int min_depth,
                     int max_depth, int flags, PyObject *context);
@@ -55,6 +71,16 @@ PyMicArray_FromAny(int device, PyObject *op, PyArray_Descr *newtype, int min_dep
 NPY_NO_EXPORT PyObject *
 PyMicArray_FromArray(PyArrayObject *arr, PyArray_Descr *newtype, int device, int flags);
 
+NPY_NO_EXPORT PyObject *
+PyMicArray_FromStructInterface(PyObject *input);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_FromInterface(PyObject *origin);
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_FromArrayAttr(PyObject *op, PyArray_Descr *typecode,
+                         PyObject *context);
+
 NPY_NO_EXPORT int
 PyMicArray_CopyAnyInto(PyMicArrayObject *dst, PyMicArrayObject *src);
 
@@ -76,6 +102,10 @@ PyMicArray_CopyAsFlat(PyMicArrayObject *dst, PyMicArrayObject *src, NPY_ORDER or
 NPY_NO_EXPORT PyObject *
 PyMicArray_EnsureArray(PyObject *op, int device);
 
+NPY_NO_EXPORT PyObject *
+PyMicArray_FromFile(int device, int fd, npy_off_t offset,
+                    PyArray_Descr *dtype, npy_intp num, int direct);
+
 NPY_NO_EXPORT PyObject *
 PyMicArray_CheckAxis(PyMicArrayObject *arr, int *axis, int flags);
 
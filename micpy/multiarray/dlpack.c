@@ -0,0 +1,385 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_API_VERSION
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL MICPY_ARRAY_API
+#include <numpy/arrayobject.h>
+#include <numpy/npy_3kcompat.h>
+
+#define _MICARRAYMODULE
+#include "common.h"
+#include "arrayobject.h"
+#include "creators.h"
+#include "dlpack.h"
+#include "mpy_dlpack.h"
+#include "residency.h"
+
+/*
+ * DLPack exchange of device arrays.
+ *
+ * Arrays on an offload device are exported with the kDLExtDev device
+ * type and the OpenMP device number as device_id. When the devices are
+ * host NUMA nodes, or the offload falls back to the host, there is no
+ * device memory, and the data is exported as kDLCPU memory instead.
+ */
+
+/* Device of the memory of an array on device, for __dlpack_device__ */
+static DLDevice
+_array_get_dl_device(PyMicArrayObject *self)
+{
+    DLDevice ret;
+
+    if (mpy_host_devices() || PyMicArray_DEVICE(self) == CPU_DEVICE) {
+        ret.device_type = kDLCPU;
+        ret.device_id = 0;
+    }
+    else {
+        ret.device_type = kDLExtDev;
+        ret.device_id = PyMicArray_DEVICE(self);
+    }
+    return ret;
+}
+
+static int
+_array_get_dl_dtype(PyArray_Descr *descr, DLDataType *ret)
+{
+    if (!PyArray_ISNBO(descr->byteorder)) {
+        PyErr_SetString(PyExc_BufferError,
+                "DLPack only supports native byte swapping.");
+        return -1;
+    }
+    if (descr->elsize > 16) {
+        PyErr_SetString(PyExc_BufferError,
+                "DLPack only supports IEEE floating point types "
+                "without padding.");
+        return -1;
+    }
+
+    if (PyDataType_ISSIGNED(descr)) {
+        ret->code = kDLInt;
+    }
+    else if (PyDataType_ISUNSIGNED(descr)) {
+        ret->code = kDLUInt;
+    }
+    else if (PyDataType_ISFLOAT(descr)) {
+        ret->code = kDLFloat;
+    }
+    else if (PyDataType_ISCOMPLEX(descr)) {
+        ret->code = kDLComplex;
+    }
+    else {
+        PyErr_SetString(PyExc_BufferError,
+                "DLPack only supports signed/unsigned integers, float "
+                "and complex dtypes.");
+        return -1;
+    }
+    ret->bits = (uint8_t)(descr->elsize * 8);
+    ret->lanes = 1;
+    return 0;
+}
+
+/* Inverse of _array_get_dl_dtype, returns a new reference */
+static PyArray_Descr *
+_descr_from_dl_dtype(DLDataType dtype)
+{
+    int type_num = NPY_NOTYPE;
+    int itemsize = dtype.bits / 8;
+
+    if (dtype.lanes != 1 || dtype.bits % 8 != 0) {
+        PyErr_SetString(PyExc_BufferError,
+                "vector and sub-byte DLPack dtypes are not supported");
+        return NULL;
+    }
+
+    switch (dtype.code) {
+        case kDLInt:
+            switch (itemsize) {
+                case 1: type_num = NPY_INT8; break;
+                case 2: type_num = NPY_INT16; break;
+                case 4: type_num = NPY_INT32; break;
+                case 8: type_num = NPY_INT64; break;
+            }
+            break;
+        case kDLUInt:
+            switch (itemsize) {
+                case 1: type_num = NPY_UINT8; break;
+                case 2: type_num = NPY_UINT16; break;
+                case 4: type_num = NPY_UINT32; break;
+                case 8: type_num = NPY_UINT64; break;
+            }
+            break;
+        case kDLFloat:
+            switch (itemsize) {
+                case 2: type_num = NPY_FLOAT16; break;
+                case 4: type_num = NPY_FLOAT32; break;
+                case 8: type_num = NPY_FLOAT64; break;
+            }
+            break;
+        case kDLComplex:
+            switch (itemsize) {
+                case 8: type_num = NPY_COMPLEX64; break;
+                case 16: type_num = NPY_COMPLEX128; break;
+            }
+            break;
+    }
+
+    if (type_num == NPY_NOTYPE) {
+        PyErr_Format(PyExc_BufferError,
+                "unsupported DLPack dtype (code %d, bits %d)",
+                (int)dtype.code, (int)dtype.bits);
+        return NULL;
+    }
+    return PyArray_DescrFromType(type_num);
+}
+
+/* Called by the consumer when it is done with an exported tensor */
+static void
+array_dlpack_deleter(DLManagedTensor *self)
+{
+    PyGILState_STATE state = PyGILState_Ensure();
+
+    /* shape and strides share the allocation of the tensor */
+    if (self->manager_ctx != NULL) {
+        mpy_residency_unpin((PyMicArrayObject *)self->manager_ctx);
+        Py_DECREF((PyObject *)self->manager_ctx);
+    }
+    PyMem_Free(self);
+
+    PyGILState_Release(state);
+}
+
+/* Destructor of an exported capsule that was never consumed */
+static void
+dlpack_capsule_deleter(PyObject *self)
+{
+    DLManagedTensor *managed;
+
+    if (PyCapsule_IsValid(self, MPY_DLPACK_USED_CAPSULE_NAME)) {
+        return;
+    }
+
+    /* an exception may be in flight, keep it */
+    {
+        PyObject *type, *value, *traceback;
+
+        PyErr_Fetch(&type, &value, &traceback);
+        managed = (DLManagedTensor *)PyCapsule_GetPointer(
+                                        self, MPY_DLPACK_CAPSULE_NAME);
+        if (managed == NULL) {
+            PyErr_WriteUnraisable(self);
+        }
+        else if (managed->deleter) {
+            managed->deleter(managed);
+        }
+        PyErr_Restore(type, value, traceback);
+    }
+}
+
+/* Destructor of the base of an array imported from DLPack */
+static void
+dlpack_internal_capsule_deleter(PyObject *self)
+{
+    DLManagedTensor *managed = (DLManagedTensor *)PyCapsule_GetPointer(
+                                    self, MPY_DLPACK_INTERNAL_CAPSULE_NAME);
+
+    if (managed == NULL) {
+        PyErr_WriteUnraisable(self);
+        return;
+    }
+    if (managed->deleter) {
+        managed->deleter(managed);
+    }
+}
+
+NPY_NO_EXPORT PyObject *
+array_dlpack(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"stream", NULL};
+    PyObject *stream = Py_None;
+    DLManagedTensor *managed;
+    DLDataType dtype;
+    int64_t *shape, *strides;
+    npy_intp itemsize = PyMicArray_ITEMSIZE(self);
+    int ndim = PyMicArray_NDIM(self), i;
+    PyObject *capsule;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O:__dlpack__", kwlist,
+                                     &stream)) {
+        return NULL;
+    }
+    /* offload transfers are synchronous, there is nothing to wait for */
+    if (stream != Py_None) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "micpy only supports stream=None.");
+        return NULL;
+    }
+    if (!PyMicArray_ISWRITEABLE(self)) {
+        PyErr_SetString(PyExc_TypeError,
+                "DLPack only supports writable arrays");
+        return NULL;
+    }
+    if (_array_get_dl_dtype(PyMicArray_DESCR(self), &dtype) < 0) {
+        return NULL;
+    }
+    for (i = 0; i < ndim; ++i) {
+        if (PyMicArray_DIM(self, i) > 1 &&
+                PyMicArray_STRIDE(self, i) % itemsize != 0) {
+            PyErr_SetString(PyExc_BufferError,
+                    "DLPack only supports strides which are a multiple "
+                    "of itemsize.");
+            return NULL;
+        }
+    }
+
+    /* one allocation for the tensor, its shape and its strides */
+    managed = PyMem_Malloc(sizeof(DLManagedTensor) +
+                           2 * ndim * sizeof(int64_t));
+    if (managed == NULL) {
+        return PyErr_NoMemory();
+    }
+    /* the consumer keeps the data pointer: no eviction until it is done */
+    if (mpy_residency_pin(self) < 0) {
+        PyMem_Free(managed);
+        return NULL;
+    }
+    shape = (int64_t *)(managed + 1);
+    strides = shape + ndim;
+    for (i = 0; i < ndim; ++i) {
+        shape[i] = PyMicArray_DIM(self, i);
+        strides[i] = PyMicArray_STRIDE(self, i) / itemsize;
+    }
+
+    managed->dl_tensor.data = PyMicArray_DATA(self);
+    managed->dl_tensor.device = _array_get_dl_device(self);
+    managed->dl_tensor.ndim = ndim;
+    managed->dl_tensor.dtype = dtype;
+    managed->dl_tensor.shape = shape;
+    managed->dl_tensor.strides = ndim > 0 ? strides : NULL;
+    managed->dl_tensor.byte_offset = 0;
+    managed->manager_ctx = self;
+    managed->deleter = array_dlpack_deleter;
+
+    capsule = PyCapsule_New(managed, MPY_DLPACK_CAPSULE_NAME,
+                            dlpack_capsule_deleter);
+    if (capsule == NULL) {
+        mpy_residency_unpin(self);
+        PyMem_Free(managed);
+        return NULL;
+    }
+    /* the consumer holds the array through the tensor */
+    Py_INCREF(self);
+    return capsule;
+}
+
+NPY_NO_EXPORT PyObject *
+array_dlpack_device(PyMicArrayObject *self, PyObject *NPY_UNUSED(args))
+{
+    DLDevice device = _array_get_dl_device(self);
+    return Py_BuildValue("ii", device.device_type, device.device_id);
+}
+
+NPY_NO_EXPORT PyObject *
+from_dlpack(PyObject *NPY_UNUSED(self), PyObject *obj)
+{
+    PyObject *capsule, *new_capsule, *ret;
+    DLManagedTensor *managed;
+    DLTensor *tensor;
+    PyArray_Descr *descr;
+    npy_intp shape[NPY_MAXDIMS], strides[NPY_MAXDIMS];
+    int device, i;
+    char *data;
+
+    capsule = PyObject_CallMethod(obj, "__dlpack__", NULL);
+    if (capsule == NULL) {
+        return NULL;
+    }
+    managed = (DLManagedTensor *)PyCapsule_GetPointer(capsule,
+                                            MPY_DLPACK_CAPSULE_NAME);
+    if (managed == NULL) {
+        Py_DECREF(capsule);
+        return NULL;
+    }
+    tensor = &managed->dl_tensor;
+
+    if (tensor->ndim > NPY_MAXDIMS) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "maxdims of DLPack tensor is higher than the supported "
+                "maxdims.");
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    /*
+     * Memory of an offload device is wrapped in place. Host memory can
+     * only be wrapped when the offload itself runs on the host.
+     */
+    if (tensor->device.device_type == kDLExtDev) {
+        device = tensor->device.device_id;
+        if (device < 0 || device >= N_DEVICES) {
+            PyErr_Format(PyExc_BufferError,
+                    "DLPack tensor is on device %d, which does not exist",
+                    device);
+            Py_DECREF(capsule);
+            return NULL;
+        }
+    }
+    else if (tensor->device.device_type == kDLCPU && mpy_host_devices()) {
+        device = CURRENT_DEVICE;
+    }
+    else {
+        PyErr_SetString(PyExc_BufferError,
+                "Unsupported device in DLTensor, micpy takes offload "
+                "device memory, or host memory when the devices are on "
+                "the host.");
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    descr = _descr_from_dl_dtype(tensor->dtype);
+    if (descr == NULL) {
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    for (i = 0; i < tensor->ndim; ++i) {
+        shape[i] = tensor->shape[i];
+        /* DLPack has elements as stride units, micpy has bytes. */
+        if (tensor->strides != NULL) {
+            strides[i] = tensor->strides[i] * descr->elsize;
+        }
+    }
+
+    data = (char *)tensor->data + tensor->byte_offset;
+    ret = PyMicArray_NewFromDescr(device, &PyMicArray_Type, descr,
+                                  tensor->ndim, shape,
+                                  tensor->strides != NULL ? strides : NULL,
+                                  data, NPY_ARRAY_WRITEABLE, NULL);
+    if (ret == NULL) {
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    /* the array now owns the tensor, through a capsule of its own */
+    if (PyCapsule_SetName(capsule, MPY_DLPACK_USED_CAPSULE_NAME) < 0) {
+        Py_DECREF(capsule);
+        Py_DECREF(ret);
+        return NULL;
+    }
+    Py_DECREF(capsule);
+
+    new_capsule = PyCapsule_New(managed, MPY_DLPACK_INTERNAL_CAPSULE_NAME,
+                                dlpack_internal_capsule_deleter);
+    if (new_capsule == NULL) {
+        Py_DECREF(ret);
+        if (managed->deleter) {
+            managed->deleter(managed);
+        }
+        return NULL;
+    }
+    if (PyMicArray_SetBaseObject((PyMicArrayObject *)ret, new_capsule) < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
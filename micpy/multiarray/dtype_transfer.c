@@ -125,7 +125,8 @@ _null_to_strided_memset_zero(void *_dst,
     _dst_memset_zero_data *d = (_dst_memset_zero_data *)data;
     npy_intp dst_itemsize = d->dst_itemsize;
 
-    #pragma omp target device(device) map(to: N, _dst, dst_stride, dst_itemsize)
+    #pragma omp target device(mpy_omp_launch(device)) \
+                       map(to: N, _dst, dst_stride, dst_itemsize)
     {
         char *dst = (char *) _dst;
         while (N--) {
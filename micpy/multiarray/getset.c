@@ -19,6 +19,7 @@
 #include "creators.h"
 #include "getset.h"
 #include "shape.h"
+#include "residency.h"
 
 /*******************  array attribute get and set routines ******************/
 
@@ -441,6 +442,11 @@ _get_part(PyMicArrayObject *self, int imag)
         Py_DECREF(type);
         type = new;
     }
+    /* the view pins the data once its base is set, see residency.h */
+    if (mpy_residency_pin(self) < 0) {
+        Py_DECREF(type);
+        return NULL;
+    }
     ret = (PyMicArrayObject *)
         PyMicArray_NewFromDescr(PyMicArray_DEVICE(self),
                              Py_TYPE(self),
@@ -451,13 +457,16 @@ _get_part(PyMicArrayObject *self, int imag)
                              PyMicArray_BYTES(self) + offset,
                              PyMicArray_FLAGS(self), (PyObject *)self);
     if (ret == NULL) {
+        mpy_residency_unpin(self);
         return NULL;
     }
     Py_INCREF(self);
     if (PyMicArray_SetBaseObject(ret, (PyObject *)self) < 0) {
+        mpy_residency_unpin(self);
         Py_DECREF(ret);
         return NULL;
     }
+    mpy_residency_unpin(self);
     PyMicArray_CLEARFLAGS(ret, NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_F_CONTIGUOUS);
     return ret;
 }
@@ -592,6 +601,79 @@ array_transpose_get(PyMicArrayObject *self)
     return PyMicArray_Transpose(self, NULL);
 }
 
+/* Set key of dict to obj, stealing the reference to obj */
+static int
+_dict_set_steal(PyObject *dict, const char *key, PyObject *obj)
+{
+    int ret;
+
+    if (obj == NULL) {
+        return -1;
+    }
+    ret = PyDict_SetItemString(dict, key, obj);
+    Py_DECREF(obj);
+    return ret;
+}
+
+/* False while the residency manager keeps the data on the host */
+static PyObject *
+array_resident_get(PyMicArrayObject *self)
+{
+    return PyBool_FromLong(mpy_residency_is_resident(self));
+}
+
+/*
+ * The device side counterpart of __array_interface__, see
+ * PyMicArray_FromInterface. The owner is the array itself, so a
+ * consumer keeping the dict keeps the data alive.
+ */
+static PyObject *
+array_mic_interface_get(PyMicArrayObject *self)
+{
+    PyObject *dict, *strides;
+
+    /*
+     * The consumer holds the pointer for as long as it wants, so the
+     * data stay on the device for the life of the array
+     */
+    if (mpy_residency_export(self) < 0) {
+        return NULL;
+    }
+    dict = PyDict_New();
+    if (dict == NULL) {
+        return NULL;
+    }
+
+    if (PyMicArray_IS_C_CONTIGUOUS(self)) {
+        Py_INCREF(Py_None);
+        strides = Py_None;
+    }
+    else {
+        strides = PyArray_IntTupleFromIntp(PyMicArray_NDIM(self),
+                                           PyMicArray_STRIDES(self));
+    }
+
+    if (_dict_set_steal(dict, "pointer",
+                        PyLong_FromVoidPtr(PyMicArray_DATA(self))) < 0 ||
+        _dict_set_steal(dict, "device",
+                        PyInt_FromLong(PyMicArray_DEVICE(self))) < 0 ||
+        _dict_set_steal(dict, "shape",
+                        PyArray_IntTupleFromIntp(PyMicArray_NDIM(self),
+                                                 PyMicArray_DIMS(self))) < 0 ||
+        _dict_set_steal(dict, "strides", strides) < 0 ||
+        _dict_set_steal(dict, "typestr",
+                        PyObject_GetAttrString(
+                            (PyObject *)PyMicArray_DESCR(self), "str")) < 0 ||
+        _dict_set_steal(dict, "readonly",
+                        PyBool_FromLong(!PyMicArray_ISWRITEABLE(self))) < 0 ||
+        PyDict_SetItemString(dict, "owner", (PyObject *)self) < 0 ||
+        _dict_set_steal(dict, "version", PyInt_FromLong(1)) < 0) {
+        Py_DECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
 /* If this is None, no function call is made
    --- default sub-class behavior
 */
@@ -669,6 +751,14 @@ NPY_NO_EXPORT PyGetSetDef array_getsetlist[] = {
         (getter)array_transpose_get,
         NULL,
         NULL, NULL},
+    {"__mic_array_interface__",
+        (getter)array_mic_interface_get,
+        NULL,
+        NULL, NULL},
+    {"resident",
+        (getter)array_resident_get,
+        NULL,
+        NULL, NULL},
     /*TODO: keep or delete ?
     {"__array_interface__",
         (getter)array_interface_get,
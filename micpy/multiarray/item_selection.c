@@ -18,6 +18,8 @@
 //#include "lowlevel_strided_loops.h"
 
 #include "item_selection.h"
+#include "residency.h"
+#include "alloc.h"
 //#include "npy_sort.h"
 //#include "npy_partition.h"
 //#include "npy_binsearch.h"
@@ -280,10 +282,178 @@ PyMicArray_Nonzero(PyMicArrayObject *self)
  * Gets a single item from the array, based on a single multi-index
  * array of values, which must be of length PyArray_NDIM(self).
  */
+static PyObject *
+_multi_index_get_item(PyMicArrayObject *self, npy_intp *multi_index)
+{
+    int idim, ndim = PyMicArray_NDIM(self);
+    char *data = PyMicArray_DATA(self);
+    npy_intp *shape = PyMicArray_SHAPE(self);
+    npy_intp *strides = PyMicArray_STRIDES(self);
+    PyArrayObject *host;
+    PyObject *ret;
+
+    /* Get the data pointer */
+    for (idim = 0; idim < ndim; ++idim) {
+        npy_intp shapevalue = shape[idim];
+        npy_intp ind = multi_index[idim];
+
+        if (check_and_adjust_index(&ind, shapevalue, idim, NULL) < 0) {
+            return NULL;
+        }
+        data += ind * strides[idim];
+    }
+
+    /* The item is read through a 0-d host array, for its getitem */
+    Py_INCREF(PyMicArray_DESCR(self));
+    host = (PyArrayObject *)PyArray_NewFromDescr(&PyArray_Type,
+                                PyMicArray_DESCR(self), 0, NULL,
+                                NULL, NULL, 0, NULL);
+    if (host == NULL) {
+        return NULL;
+    }
+    if (target_memcpy(PyArray_DATA(host), data, PyArray_ITEMSIZE(host),
+                      CPU_DEVICE, PyMicArray_DEVICE(self)) != 0) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cannot copy the item to the host");
+        Py_DECREF(host);
+        return NULL;
+    }
+    ret = PyArray_GETITEM(host, PyArray_DATA(host));
+    Py_DECREF(host);
+    return ret;
+}
+
 NPY_NO_EXPORT PyObject *
 PyMicArray_MultiIndexGetItem(PyMicArrayObject *self, npy_intp *multi_index)
 {
-    return NULL;
+    PyObject *ret;
+
+    /* the item is read with the data pointer of self, see residency.h */
+    if (mpy_residency_pin(self) < 0) {
+        return NULL;
+    }
+    ret = _multi_index_get_item(self, multi_index);
+    mpy_residency_unpin(self);
+    return ret;
+}
+
+/*
+ * Gather the elements of self at the flat, C order indices into a host
+ * array of the shape of indices. The elements are collected into one
+ * buffer on the device, so there is a single transfer to the host
+ * however scattered they are. Negative indices count from the end.
+ */
+static PyObject *
+_take_items(PyMicArrayObject *self, PyObject *indices)
+{
+    PyArrayObject *idx, *ret = NULL;
+    npy_intp *offsets = NULL, *dev_offsets = NULL;
+    char *dev_out = NULL, *data = PyMicArray_DATA(self);
+    npy_intp i, n, size = PyMicArray_SIZE(self);
+    npy_intp itemsize = PyMicArray_ITEMSIZE(self);
+    int idim, ndim = PyMicArray_NDIM(self);
+    int device = PyMicArray_DEVICE(self);
+    int err = 0;
+
+    idx = (PyArrayObject *)PyArray_FROMANY(indices, NPY_INTP, 0, 0,
+                                           NPY_ARRAY_CARRAY);
+    if (idx == NULL) {
+        return NULL;
+    }
+    n = PyArray_SIZE(idx);
+
+    Py_INCREF(PyMicArray_DESCR(self));
+    ret = (PyArrayObject *)PyArray_NewFromDescr(&PyArray_Type,
+                                PyMicArray_DESCR(self),
+                                PyArray_NDIM(idx), PyArray_DIMS(idx),
+                                NULL, NULL, 0, NULL);
+    if (ret == NULL || n == 0) {
+        goto finish;
+    }
+
+    /* Byte offsets of the elements, so that self need not be contiguous */
+    offsets = PyArray_malloc(n * sizeof(npy_intp));
+    if (offsets == NULL) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    for (i = 0; i < n; ++i) {
+        npy_intp ind = ((npy_intp *)PyArray_DATA(idx))[i];
+        npy_intp offset = 0;
+
+        if (check_and_adjust_index(&ind, size, -1, NULL) < 0) {
+            goto fail;
+        }
+        for (idim = ndim - 1; idim >= 0; --idim) {
+            offset += (ind % PyMicArray_DIMS(self)[idim]) *
+                                    PyMicArray_STRIDES(self)[idim];
+            ind /= PyMicArray_DIMS(self)[idim];
+        }
+        offsets[i] = offset;
+    }
+
+    /* self is pinned, the allocations may evict the other arrays */
+    dev_offsets = PyDataMemMic_NEW(n * sizeof(npy_intp), device);
+    dev_out = PyDataMemMic_NEW(n * itemsize, device);
+    if (dev_offsets == NULL || dev_out == NULL) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    NPY_BEGIN_ALLOW_THREADS;
+    err = target_memcpy(dev_offsets, offsets, n * sizeof(npy_intp),
+                        device, CPU_DEVICE) != 0;
+    if (!err) {
+        #pragma omp target device(mpy_omp_launch(device)) \
+                           map(to: n, itemsize, data, \
+                                                  dev_offsets, dev_out)
+        {
+            npy_intp k;
+
+            #pragma omp parallel for
+            for (k = 0; k < n; ++k) {
+                memcpy(dev_out + k * itemsize, data + dev_offsets[k],
+                       itemsize);
+            }
+        }
+        err = target_memcpy(PyArray_DATA(ret), dev_out, n * itemsize,
+                            CPU_DEVICE, device) != 0;
+    }
+    NPY_END_ALLOW_THREADS;
+
+    if (err) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "cannot copy the items to the host");
+        goto fail;
+    }
+    goto finish;
+
+fail:
+    Py_CLEAR(ret);
+finish:
+    if (dev_offsets != NULL) {
+        PyDataMemMic_FREE(dev_offsets, device);
+    }
+    if (dev_out != NULL) {
+        PyDataMemMic_FREE(dev_out, device);
+    }
+    PyArray_free(offsets);
+    Py_DECREF(idx);
+    return (PyObject *)ret;
+}
+
+NPY_NO_EXPORT PyObject *
+PyMicArray_TakeItems(PyMicArrayObject *self, PyObject *indices)
+{
+    PyObject *ret;
+
+    /* the gather runs with the GIL released, see residency.h */
+    if (mpy_residency_pin(self) < 0) {
+        return NULL;
+    }
+    ret = _take_items(self, indices);
+    mpy_residency_unpin(self);
+    return ret;
 }
 
 /*
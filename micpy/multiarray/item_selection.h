@@ -27,6 +27,13 @@ NPY_NO_EXPORT int
 PyMicArray_MultiIndexSetItem(PyMicArrayObject *self, npy_intp *multi_index,
                                                 PyObject *obj);
 
+/*
+ * Gathers the items of self at the flat indices into a host array, with
+ * one transfer from the device.
+ */
+NPY_NO_EXPORT PyObject *
+PyMicArray_TakeItems(PyMicArrayObject *self, PyObject *indices);
+
 NPY_NO_EXPORT PyObject *
 PyMicArray_Repeat(PyMicArrayObject *aop, PyObject *op, int axis);
 
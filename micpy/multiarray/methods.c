@@ -24,6 +24,10 @@
 #include "calculation.h"
 #include "multiarraymodule.h"
 #include "number.h"
+#include "alloc.h"
+#include "mpy_dlpack.h"
+#include "array_assign.h"
+#include "residency.h"
 
 
 /* NpyArg_ParseKeywords
@@ -383,6 +387,11 @@ PyMicArray_GetField(PyMicArrayObject *self, PyArray_Descr *typed, int offset)
         return NULL;
     }
 
+    /* the view pins the data once its base is set, see residency.h */
+    if (mpy_residency_pin(self) < 0) {
+        Py_DECREF(typed);
+        return NULL;
+    }
     ret = PyMicArray_NewFromDescr_int(PyMicArray_DEVICE(self),
                                    Py_TYPE(self),
                                    typed,
@@ -392,13 +401,16 @@ PyMicArray_GetField(PyMicArrayObject *self, PyArray_Descr *typed, int offset)
                                    PyMicArray_FLAGS(self) & (~NPY_ARRAY_F_CONTIGUOUS),
                                    (PyObject *)self, 0, 1);
     if (ret == NULL) {
+        mpy_residency_unpin(self);
         return NULL;
     }
     Py_INCREF(self);
     if (PyMicArray_SetBaseObject(((PyMicArrayObject *)ret), (PyObject *)self) < 0) {
+        mpy_residency_unpin(self);
         Py_DECREF(ret);
         return NULL;
     }
+    mpy_residency_unpin(self);
 
     PyMicArray_UpdateFlags((PyMicArrayObject *)ret, NPY_ARRAY_UPDATE_ALL);
     return ret;
@@ -498,8 +510,14 @@ array_byteswap(PyMicArrayObject *self, PyObject *args)
 static PyObject *
 array_tobytes(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 {
-    //TODO: keep or delete
-    return NULL;
+    NPY_ORDER order = NPY_CORDER;
+    static char *kwlist[] = {"order", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&:tobytes", kwlist,
+                                     PyArray_OrderConverter, &order)) {
+        return NULL;
+    }
+    return PyMicArray_ToString(self, order);
 }
 
 
@@ -509,10 +527,62 @@ array_tobytes(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 static PyObject *
 array_tofile(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 {
-    //TODO: implement
+    int own;
+    PyObject *file;
+    FILE *fd;
+    char *sep = "";
+    char *format = "";
+    npy_off_t orig_pos = 0;
+    static char *kwlist[] = {"file", "sep", "format", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|ss:tofile", kwlist,
+                                     &file, &sep, &format)) {
+        return NULL;
+    }
+
+    if (PyBytes_Check(file) || PyUnicode_Check(file)) {
+        file = npy_PyFile_OpenFile(file, "wb");
+        if (file == NULL) {
+            return NULL;
+        }
+        own = 1;
+    }
+    else {
+        Py_INCREF(file);
+        own = 0;
+    }
+    fd = npy_PyFile_Dup2(file, "wb", &orig_pos);
+    if (fd == NULL) {
+        PyErr_SetString(PyExc_IOError,
+                "first argument must be a string or open file");
+        goto fail;
+    }
+    if (PyMicArray_ToFile(self, fd, sep, format) < 0) {
+        goto fail;
+    }
+    if (npy_PyFile_DupClose2(file, fd, orig_pos) < 0) {
+        goto fail;
+    }
+    if (own && npy_PyFile_CloseFile(file) < 0) {
+        goto fail;
+    }
+    Py_DECREF(file);
+    Py_RETURN_NONE;
+
+fail:
+    Py_DECREF(file);
     return NULL;
 }
 
+static PyObject *
+array_tolist(PyMicArrayObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, "")) {
+        return NULL;
+    }
+    return PyMicArray_ToList(self);
+}
+
 static PyObject *
 array_toscalar(PyMicArrayObject *self, PyObject *args)
 {
@@ -913,27 +983,315 @@ array_deepcopy(PyMicArrayObject *self, PyObject *args)
 /* Convert Array to flat list (using getitem) */
 
 
+/*
+ * The pickled state is the one of numpy.ndarray:
+ * (version, shape, dtype, is_fortran, rawdata), where rawdata is a
+ * bytes object, or a PickleBuffer sent out-of-band with protocol 5.
+ * It is rebuilt by multiarray._reconstruct and __setstate__.
+ */
+static PyObject *
+array_reduce_ex(PyMicArrayObject *self, PyObject *args)
+{
+    int protocol = 2;
+    int is_f_order;
+    PyMicArrayObject *src;
+    PyObject *mod, *reconstruct, *payload, *shape, *ret;
+    npy_intp nbytes;
+
+    if (!PyArg_ParseTuple(args, "|i:__reduce_ex__", &protocol)) {
+        return NULL;
+    }
+    if (PyDataType_FLAGCHK(PyMicArray_DESCR(self), NPY_LIST_PICKLE)) {
+        PyErr_SetString(PyExc_ValueError, "cannot pickle object arrays");
+        return NULL;
+    }
+
+    is_f_order = PyMicArray_IS_F_CONTIGUOUS(self) &&
+                 !PyMicArray_IS_C_CONTIGUOUS(self);
+    if (PyMicArray_ISONESEGMENT(self)) {
+        Py_INCREF(self);
+        src = self;
+    }
+    else {
+        src = (PyMicArrayObject *)PyMicArray_NewCopy(self, NPY_CORDER);
+        if (src == NULL) {
+            return NULL;
+        }
+    }
+    nbytes = PyMicArray_NBYTES(src);
+
+    /*
+     * The data comes off the device in one copy straight into the
+     * buffer handed to pickle. With protocol 5 that buffer goes
+     * out-of-band and is never copied again.
+     */
+#if PY_VERSION_HEX >= 0x03080000
+    if (protocol >= 5) {
+        PyObject *buf = PyByteArray_FromStringAndSize(NULL, nbytes);
+        if (buf == NULL) {
+            Py_DECREF(src);
+            return NULL;
+        }
+        if (nbytes > 0) {
+            int err;
+
+            if (mpy_residency_pin(src) < 0) {
+                Py_DECREF(buf);
+                Py_DECREF(src);
+                return NULL;
+            }
+            NPY_BEGIN_ALLOW_THREADS;
+            err = target_memcpy(PyByteArray_AS_STRING(buf),
+                                PyMicArray_DATA(src), nbytes,
+                                CPU_DEVICE, PyMicArray_DEVICE(src));
+            NPY_END_ALLOW_THREADS;
+            mpy_residency_unpin(src);
+            if (err != 0) {
+                PyErr_SetString(PyExc_RuntimeError,
+                                "cannot copy the array to the host");
+                Py_DECREF(buf);
+                Py_DECREF(src);
+                return NULL;
+            }
+        }
+        payload = PyPickleBuffer_FromObject(buf);
+        Py_DECREF(buf);
+    }
+    else
+#endif
+    {
+        payload = PyMicArray_ToString(src, is_f_order ? NPY_FORTRANORDER
+                                                      : NPY_CORDER);
+    }
+    Py_DECREF(src);
+    if (payload == NULL) {
+        return NULL;
+    }
+
+    mod = PyImport_ImportModule("micpy.multiarray");
+    if (mod == NULL) {
+        Py_DECREF(payload);
+        return NULL;
+    }
+    reconstruct = PyObject_GetAttrString(mod, "_reconstruct");
+    Py_DECREF(mod);
+    if (reconstruct == NULL) {
+        Py_DECREF(payload);
+        return NULL;
+    }
+
+    shape = PyArray_IntTupleFromIntp(PyMicArray_NDIM(self),
+                                     PyMicArray_DIMS(self));
+    if (shape == NULL) {
+        Py_DECREF(reconstruct);
+        Py_DECREF(payload);
+        return NULL;
+    }
+
+    ret = Py_BuildValue("N(Oi)(iNOiN)",
+                        reconstruct,
+                        (PyObject *)Py_TYPE(self), PyMicArray_DEVICE(self),
+                        1, shape, (PyObject *)PyMicArray_DESCR(self),
+                        is_f_order, payload);
+    return ret;
+}
+
+static PyObject *
+array_reduce(PyMicArrayObject *self, PyObject *NPY_UNUSED(args))
+{
+    PyObject *args, *ret;
+
+    args = Py_BuildValue("(i)", 2);
+    if (args == NULL) {
+        return NULL;
+    }
+    ret = array_reduce_ex(self, args);
+    Py_DECREF(args);
+    return ret;
+}
+
 static PyObject *
 array_setstate(PyMicArrayObject *self, PyObject *args)
 {
-    //TODO
-    return NULL;
+    PyObject *shape;
+    PyArray_Descr *typecode;
+    int version = 1;
+    int is_f_order;
+    PyObject *rawdata = NULL;
+    Py_buffer view;
+    npy_intp dimensions[NPY_MAXDIMS];
+    npy_intp size, nbytes;
+    int nd, device = PyMicArray_DEVICE(self);
+    void *data;
+
+    /* This will free any memory associated with a and
+       use the string in setstate as the (writeable) memory.
+    */
+    if (!PyArg_ParseTuple(args, "(iO!O!iO):__setstate__",
+                          &version,
+                          &PyTuple_Type, &shape,
+                          &PyArrayDescr_Type, &typecode,
+                          &is_f_order,
+                          &rawdata)) {
+        PyErr_Clear();
+        version = 0;
+        if (!PyArg_ParseTuple(args, "(O!O!iO):__setstate__",
+                              &PyTuple_Type, &shape,
+                              &PyArrayDescr_Type, &typecode,
+                              &is_f_order,
+                              &rawdata)) {
+            return NULL;
+        }
+    }
+    if (version != 1 && version != 0) {
+        PyErr_Format(PyExc_ValueError,
+                     "can't handle version %d of numpy.ndarray pickle",
+                     version);
+        return NULL;
+    }
+    if (PyDataType_FLAGCHK(typecode, NPY_LIST_PICKLE)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "micpy cannot unpickle object arrays");
+        return NULL;
+    }
+
+    nd = PyArray_IntpFromSequence(shape, dimensions, NPY_MAXDIMS);
+    if (nd < 0) {
+        return NULL;
+    }
+    size = PyArray_OverflowMultiplyList(dimensions, nd);
+    if (size < 0 ||
+            npy_mul_with_overflow_intp(&nbytes, size, typecode->elsize)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(rawdata, &view, PyBUF_SIMPLE) < 0) {
+        return NULL;
+    }
+    if (view.len != nbytes) {
+        PyErr_SetString(PyExc_ValueError,
+                        "buffer size does not match array size");
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    /* allocate something even for zero-space arrays, like NewFromDescr */
+    data = mpy_alloc_cache(nbytes > 0 ? nbytes : typecode->elsize, device);
+    if (data == NULL) {
+        PyBuffer_Release(&view);
+        return PyErr_NoMemory();
+    }
+    if (nbytes > 0) {
+        int err;
+
+        NPY_BEGIN_ALLOW_THREADS;
+        err = target_memcpy(data, view.buf, nbytes, device, CPU_DEVICE);
+        NPY_END_ALLOW_THREADS;
+        if (err != 0) {
+            PyErr_Format(PyExc_RuntimeError,
+                         "cannot copy the array to device %d", device);
+            mpy_free_cache(data, nbytes, device);
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+    }
+    PyBuffer_Release(&view);
+
+    /* the new data is in place, drop the old one */
+    mpy_residency_release(self);
+    if ((self->flags & NPY_ARRAY_OWNDATA) && self->data != NULL) {
+        mpy_free_cache(self->data, PyMicArray_CAPACITY(self), device);
+    }
+    mpy_array_set_capacity(self, 0);
+    Py_CLEAR(self->base);
+    mpy_free_cache_dim(self->dimensions, 2 * self->nd);
+    self->dimensions = self->strides = NULL;
+
+    Py_INCREF(typecode);
+    Py_DECREF(self->descr);
+    self->descr = typecode;
+
+    self->nd = nd;
+    self->data = data;
+    self->flags = NPY_ARRAY_DEFAULT | NPY_ARRAY_OWNDATA;
+    if (nd > 0) {
+        self->dimensions = mpy_alloc_cache_dim(2 * nd);
+        if (self->dimensions == NULL) {
+            self->nd = 0;
+            return PyErr_NoMemory();
+        }
+        self->strides = self->dimensions + nd;
+        memcpy(self->dimensions, dimensions, sizeof(npy_intp) * nd);
+        _array_fill_strides(self->strides, dimensions, nd,
+                            (size_t)typecode->elsize,
+                            is_f_order ? NPY_ARRAY_F_CONTIGUOUS
+                                       : NPY_ARRAY_C_CONTIGUOUS,
+                            &(self->flags));
+    }
+    PyArray_UpdateFlags((PyArrayObject *)self, NPY_ARRAY_UPDATE_ALL);
+    if (mpy_residency_enabled()) {
+        mpy_residency_track(self, nbytes);
+    }
+
+    Py_RETURN_NONE;
 }
 
 /*NUMPY_API*/
 NPY_NO_EXPORT int
 PyMicArray_Dump(PyObject *self, PyObject *file, int protocol)
 {
-    //TODO: implement
-    return -1;
+    PyObject *pickle, *ret;
+    int own = 0;
+
+#if defined(NPY_PY3K)
+    pickle = PyImport_ImportModule("pickle");
+#else
+    pickle = PyImport_ImportModule("cPickle");
+#endif
+    if (pickle == NULL) {
+        return -1;
+    }
+    if (PyBytes_Check(file) || PyUnicode_Check(file)) {
+        file = npy_PyFile_OpenFile(file, "wb");
+        if (file == NULL) {
+            Py_DECREF(pickle);
+            return -1;
+        }
+        own = 1;
+    }
+    ret = PyObject_CallMethod(pickle, "dump", "OOi", self, file, protocol);
+    Py_DECREF(pickle);
+    if (own) {
+        if (npy_PyFile_CloseFile(file) < 0 && ret != NULL) {
+            Py_CLEAR(ret);
+        }
+        Py_DECREF(file);
+    }
+    if (ret == NULL) {
+        return -1;
+    }
+    Py_DECREF(ret);
+    return 0;
 }
 
 /*NUMPY_API*/
 NPY_NO_EXPORT PyObject *
 PyMicArray_Dumps(PyObject *self, int protocol)
 {
-    //TODO: implement
-    return NULL;
+    PyObject *pickle, *ret;
+
+#if defined(NPY_PY3K)
+    pickle = PyImport_ImportModule("pickle");
+#else
+    pickle = PyImport_ImportModule("cPickle");
+#endif
+    if (pickle == NULL) {
+        return NULL;
+    }
+    ret = PyObject_CallMethod(pickle, "dumps", "Oi", self, protocol);
+    Py_DECREF(pickle);
+    return ret;
 }
 
 
@@ -1008,11 +1366,70 @@ array_transpose(PyMicArrayObject *self, PyObject *args)
 
 #define _CHKTYPENUM(typ) ((typ) ? (typ)->type_num : NPY_NOTYPE)
 
+/*
+ * mean (what 0), var (1) and std (2), computed together in one pass by
+ * PyMicArray_MeanVar.
+ */
+static PyObject *
+_array_stats(PyMicArrayObject *self, PyObject *args, PyObject *kwds,
+             int what)
+{
+    PyObject *axis_in = NULL;
+    PyArray_Descr *dtype = NULL;
+    PyMicArrayObject *out = NULL, *ret = NULL;
+    npy_bool axis_flags[NPY_MAXDIMS];
+    int ddof = 0, keepdims = 0;
+    static char *mean_kwlist[] = {"axis", "dtype", "out", "keepdims", NULL};
+    static char *var_kwlist[] = {"axis", "dtype", "out", "ddof",
+                                 "keepdims", NULL};
+
+    if (what == 0) {
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OO&O&i:mean",
+                                         mean_kwlist, &axis_in,
+                                         PyArray_DescrConverter2, &dtype,
+                                         PyMicArray_OutputConverter, &out,
+                                         &keepdims)) {
+            Py_XDECREF(dtype);
+            return NULL;
+        }
+    }
+    else if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OO&O&ii", var_kwlist,
+                                          &axis_in,
+                                          PyArray_DescrConverter2, &dtype,
+                                          PyMicArray_OutputConverter, &out,
+                                          &ddof, &keepdims)) {
+        Py_XDECREF(dtype);
+        return NULL;
+    }
+
+    if (PyMicArray_ConvertMultiAxis(axis_in == NULL ? Py_None : axis_in,
+                                    PyMicArray_NDIM(self),
+                                    axis_flags) != NPY_SUCCEED) {
+        Py_XDECREF(dtype);
+        return NULL;
+    }
+    if (PyMicArray_MeanVar(self, axis_flags, dtype, ddof, keepdims,
+                           what == 2,
+                           what == 0 ? &ret : NULL,
+                           what == 0 ? NULL : &ret) < 0) {
+        return NULL;
+    }
+    if (out != NULL) {
+        if (PyMicArray_AssignArray(out, ret, NULL, NPY_UNSAFE_CASTING) < 0) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(ret);
+        Py_INCREF(out);
+        return (PyObject *)out;
+    }
+    return PyMicArray_Return(ret);
+}
+
 static PyObject *
 array_mean(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 {
-    //TODO
-    return NULL;
+    return _array_stats(self, args, kwds, 0);
 }
 
 static PyObject *
@@ -1116,15 +1533,13 @@ array_all(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 static PyObject *
 array_stddev(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 {
-    //TODO
-    return NULL;
+    return _array_stats(self, args, kwds, 2);
 }
 
 static PyObject *
 array_variance(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
 {
-    //TODO
-    return NULL;
+    return _array_stats(self, args, kwds, 1);
 }
 
 static PyObject *
@@ -1386,6 +1801,148 @@ array_tohost(PyMicArrayObject *self, PyObject *args)
 }
 
 
+/*
+ * Copy of self on another device. With async_=True the copy runs in a
+ * background thread and a micpy.device.PeerCopy handle is returned.
+ */
+static PyObject *
+array_copy_to_device(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"device", "async_", NULL};
+    static PyObject *copy_async = NULL;
+    PyMicArrayObject *ret;
+    int device = -1, async = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|i:copy_to_device",
+                                     kwlist,
+                                     PyMicArray_DeviceConverter, &device,
+                                     &async)) {
+        return NULL;
+    }
+    if (device < 0) {
+        PyErr_SetString(PyExc_TypeError, "device must be an integer");
+        return NULL;
+    }
+
+    if (async) {
+        if (copy_async == NULL) {
+            PyObject *mod = PyImport_ImportModule("micpy.device");
+            if (mod == NULL) {
+                return NULL;
+            }
+            copy_async = PyObject_GetAttrString(mod, "_copy_async");
+            Py_DECREF(mod);
+            if (copy_async == NULL) {
+                return NULL;
+            }
+        }
+        return PyObject_CallFunction(copy_async, "Oi", self, device);
+    }
+
+    if (device == PyMicArray_DEVICE(self)) {
+        return PyMicArray_NewCopy(self, NPY_KEEPORDER);
+    }
+    ret = (PyMicArrayObject *)PyMicArray_NewLikeArray(device,
+                                    (PyArrayObject *)self, NPY_KEEPORDER,
+                                    NULL, 0);
+    if (ret == NULL) {
+        return NULL;
+    }
+    if (PyMicArray_AssignArray(ret, self, NULL, NPY_UNSAFE_CASTING) < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return (PyObject *)ret;
+}
+
+/*
+ * Residency hints, see residency.h. They do nothing on arrays the
+ * residency manager does not track.
+ */
+static PyObject *
+array_evict(PyMicArrayObject *self, PyObject *NPY_UNUSED(args))
+{
+    int ret = mpy_residency_evict_array(self);
+
+    if (ret < 0) {
+        return NULL;
+    }
+    return PyBool_FromLong(ret);
+}
+
+static PyObject *
+array_pin_resident(PyMicArrayObject *self, PyObject *NPY_UNUSED(args))
+{
+    if (mpy_residency_pin_user(self) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+array_unpin_resident(PyMicArrayObject *self, PyObject *NPY_UNUSED(args))
+{
+    if (mpy_residency_unpin_user(self) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/*
+ * Call micpy.dispatch.<name>(self, *args, **kwds). The callable is
+ * looked up once and kept in *cache.
+ */
+static PyObject *
+forward_to_dispatch(PyMicArrayObject *self, PyObject *args, PyObject *kwds,
+                    const char *name, PyObject **cache)
+{
+    PyObject *newargs, *item, *ret;
+    Py_ssize_t i, n = PyTuple_GET_SIZE(args);
+
+    if (*cache == NULL) {
+        PyObject *mod = PyImport_ImportModule("micpy.dispatch");
+        if (mod == NULL) {
+            return NULL;
+        }
+        *cache = PyObject_GetAttrString(mod, name);
+        Py_DECREF(mod);
+        if (*cache == NULL) {
+            return NULL;
+        }
+    }
+
+    newargs = PyTuple_New(n + 1);
+    if (newargs == NULL) {
+        return NULL;
+    }
+    Py_INCREF(self);
+    PyTuple_SET_ITEM(newargs, 0, (PyObject *)self);
+    for (i = 0; i < n; i++) {
+        item = PyTuple_GET_ITEM(args, i);
+        Py_INCREF(item);
+        PyTuple_SET_ITEM(newargs, i + 1, item);
+    }
+    ret = PyObject_Call(*cache, newargs, kwds);
+    Py_DECREF(newargs);
+    return ret;
+}
+
+static PyObject *
+array_ufunc(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
+{
+    static PyObject *callable = NULL;
+    return forward_to_dispatch(self, args, kwds, "array_ufunc", &callable);
+}
+
+static PyObject *
+array_function(PyMicArrayObject *self, PyObject *args, PyObject *kwds)
+{
+    static PyObject *callable = NULL;
+    return forward_to_dispatch(self, args, kwds, "array_function",
+                               &callable);
+}
+
 static PyObject *
 array_complex(PyArrayObject *self, PyObject *NPY_UNUSED(args))
 {
@@ -1409,9 +1966,12 @@ NPY_NO_EXPORT PyMethodDef array_methods[] = {
         METH_VARARGS, NULL},
 
     /* for Pickling */
-    /*{"__reduce__",
+    {"__reduce__",
         (PyCFunction) array_reduce,
         METH_VARARGS, NULL},
+    {"__reduce_ex__",
+        (PyCFunction) array_reduce_ex,
+        METH_VARARGS, NULL},
     {"__setstate__",
         (PyCFunction) array_setstate,
         METH_VARARGS, NULL},
@@ -1422,7 +1982,23 @@ NPY_NO_EXPORT PyMethodDef array_methods[] = {
         (PyCFunction) array_dump,
         METH_VARARGS, NULL},
 
-    {"__complex__",
+    /* for the NumPy protocols */
+    {"__array_ufunc__",
+        (PyCFunction)array_ufunc,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"__array_function__",
+        (PyCFunction)array_function,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+
+    /* for DLPack */
+    {"__dlpack__",
+        (PyCFunction)array_dlpack,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"__dlpack_device__",
+        (PyCFunction)array_dlpack_device,
+        METH_NOARGS, NULL},
+
+    /*{"__complex__",
         (PyCFunction) array_complex,
         METH_VARARGS, NULL},*/
 
@@ -1489,11 +2065,11 @@ NPY_NO_EXPORT PyMethodDef array_methods[] = {
         METH_VARARGS | METH_KEYWORDS, NULL},
     {"getfield",
         (PyCFunction)array_getfield,
-        METH_VARARGS | METH_KEYWORDS, NULL},
+        METH_VARARGS | METH_KEYWORDS, NULL},*/
     {"item",
         (PyCFunction)array_toscalar,
         METH_VARARGS, NULL},
-    {"itemset",
+    /*{"itemset",
         (PyCFunction) array_setscalar,
         METH_VARARGS, NULL},*/
     {"max",
@@ -1518,10 +2094,10 @@ NPY_NO_EXPORT PyMethodDef array_methods[] = {
     {"prod",
         (PyCFunction)array_prod,
         METH_VARARGS | METH_KEYWORDS, NULL},
-    /*{"ptp",
+    {"ptp",
         (PyCFunction)array_ptp,
         METH_VARARGS | METH_KEYWORDS, NULL},
-    {"put",
+    /*{"put",
         (PyCFunction)array_put,
         METH_VARARGS | METH_KEYWORDS, NULL},*/
     {"ravel",
@@ -1553,10 +2129,10 @@ NPY_NO_EXPORT PyMethodDef array_methods[] = {
         METH_VARARGS | METH_KEYWORDS, NULL},
     {"squeeze",
         (PyCFunction)array_squeeze,
-        METH_VARARGS | METH_KEYWORDS, NULL},
+        METH_VARARGS | METH_KEYWORDS, NULL},*/
     {"std",
         (PyCFunction)array_stddev,
-        METH_VARARGS | METH_KEYWORDS, NULL},*/
+        METH_VARARGS | METH_KEYWORDS, NULL},
     {"sum",
         (PyCFunction)array_sum,
         METH_VARARGS | METH_KEYWORDS, NULL},
@@ -1565,30 +2141,45 @@ NPY_NO_EXPORT PyMethodDef array_methods[] = {
         METH_VARARGS, NULL},
     {"take",
         (PyCFunction)array_take,
-        METH_VARARGS | METH_KEYWORDS, NULL},
+        METH_VARARGS | METH_KEYWORDS, NULL},*/
     {"tobytes",
         (PyCFunction)array_tobytes,
         METH_VARARGS | METH_KEYWORDS, NULL},
     {"tofile",
         (PyCFunction)array_tofile,
         METH_VARARGS | METH_KEYWORDS, NULL},
+    {"tolist",
+        (PyCFunction)array_tolist,
+        METH_VARARGS, NULL},
     {"tostring",
         (PyCFunction)array_tobytes,
         METH_VARARGS | METH_KEYWORDS, NULL},
-    {"trace",
+    /*{"trace",
         (PyCFunction)array_trace,
         METH_VARARGS | METH_KEYWORDS, NULL},*/
     {"transpose",
         (PyCFunction)array_transpose,
         METH_VARARGS, NULL},
-    /*{"var",
+    {"var",
         (PyCFunction)array_variance,
-        METH_VARARGS | METH_KEYWORDS, NULL},*/
+        METH_VARARGS | METH_KEYWORDS, NULL},
     {"view",
         (PyCFunction)array_view,
         METH_VARARGS | METH_KEYWORDS, NULL},
     {"to_cpu",
         (PyCFunction)array_tohost,
         METH_NOARGS, NULL},
+    {"copy_to_device",
+        (PyCFunction)array_copy_to_device,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"evict",
+        (PyCFunction)array_evict,
+        METH_NOARGS, NULL},
+    {"pin_resident",
+        (PyCFunction)array_pin_resident,
+        METH_NOARGS, NULL},
+    {"unpin_resident",
+        (PyCFunction)array_unpin_resident,
+        METH_NOARGS, NULL},
     {NULL, NULL, 0, NULL}           /* sentinel */
 };
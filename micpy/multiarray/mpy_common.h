@@ -1,9 +1,11 @@
 #ifndef _MPY_EXTERNAL_COMMON_H
 #define _MPY_EXTERNAL_COMMON_H
 
+#include <string.h>
 #include <omp.h>
 #include <offload.h>
 #include <numpy/npy_os.h>
+#include <numpy/npy_common.h>
 
 
 /* Some usefull macros */
@@ -14,20 +16,66 @@
 #define MPY_TARGET_MIC __attribute__((target(mic)))
 #endif
 
+/* Thread local storage, for numpy versions that do not define it */
+#ifndef NPY_TLS
+#ifdef NPY_OS_WIN32
+#define NPY_TLS __declspec(thread)
+#else
+#define NPY_TLS __thread
+#endif
+#endif
+
+/*
+ * Whether the micpy devices live in host memory: without offload devices
+ * they are the host NUMA nodes (see numa.h), or there are none at all
+ * when that mode is off.
+ */
+static NPY_INLINE int
+mpy_host_devices(void)
+{
+    static int host_only = -1;
+
+    if (host_only < 0) {
+        host_only = (omp_get_num_devices() == 0);
+    }
+    return host_only;
+}
+
+/*
+ * OpenMP device number of a micpy device, for the memory routines and
+ * the device clause of every target region. On host devices it is the
+ * initial device, as the micpy device number may not be a valid OpenMP
+ * one.
+ */
+static NPY_INLINE int
+mpy_omp_device(int device)
+{
+    return mpy_host_devices() ? omp_get_initial_device() : device;
+}
+
+/*
+ * Device clause of a kernel launch: mpy_omp_device, after pinning the
+ * team that runs the kernel on host devices to the node of device.
+ */
+#define mpy_omp_launch(device) \
+        (PyMicArray_BindTeam(device), mpy_omp_device(device))
+
 /* Memset on target */
 static NPY_INLINE void *
 target_memset(void *ptr, int value, size_t num, int device_num)
 {
-    #pragma omp target device(device_num) map(to: ptr, value, num)
+    #pragma omp target device(mpy_omp_device(device_num)) \
+                       map(to: ptr, value, num)
     memset(ptr, value, num);
     return ptr;
 }
 
-#define target_alloc omp_target_alloc
-#define target_malloc omp_target_alloc
-#define target_free omp_target_free
+#define target_alloc(size, dev) omp_target_alloc(size, mpy_omp_device(dev))
+#define target_malloc target_alloc
+#define target_free(ptr, dev) omp_target_free(ptr, mpy_omp_device(dev))
 #define target_memcpy(dst, src, len, dst_dev, src_dev) \
-                omp_target_memcpy(dst, src, len, 0, 0, dst_dev, src_dev)
+                omp_target_memcpy(dst, src, len, 0, 0, \
+                        mpy_omp_device(dst_dev), mpy_omp_device(src_dev))
 
 
 #ifdef NPY_ALLOW_THREADS
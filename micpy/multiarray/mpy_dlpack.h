@@ -0,0 +1,20 @@
+#ifndef _MPY_DLPACK_H_
+#define _MPY_DLPACK_H_
+
+/* name of the capsule holding the DLManagedTensor of an export */
+#define MPY_DLPACK_CAPSULE_NAME "dltensor"
+#define MPY_DLPACK_USED_CAPSULE_NAME "used_dltensor"
+
+/* name of the capsule keeping an imported DLManagedTensor alive */
+#define MPY_DLPACK_INTERNAL_CAPSULE_NAME "micpy_dltensor"
+
+NPY_NO_EXPORT PyObject *
+array_dlpack(PyMicArrayObject *self, PyObject *args, PyObject *kwds);
+
+NPY_NO_EXPORT PyObject *
+array_dlpack_device(PyMicArrayObject *self, PyObject *NPY_UNUSED(args));
+
+NPY_NO_EXPORT PyObject *
+from_dlpack(PyObject *NPY_UNUSED(self), PyObject *obj);
+
+#endif
@@ -116,6 +116,28 @@ PyMicArray_GetStridedNumericCastFn(int aligned,
                             npy_intp src_stride, npy_intp dst_stride,
                             int src_type_num, int dst_type_num);
 
+/* side of the square tiles of PyMicArray_TransposeCopy, in items */
+#define MPY_TRANSPOSE_TILE 32
+
+/*
+ * Transposing copy on the device: for each of nbatch pairs of matrices,
+ * the rows x cols matrix at src goes to the cols x rows matrix at dst.
+ * The items of a row are contiguous on both sides; the row and batch
+ * strides are in bytes. The copy is done tile by tile, see
+ * MPY_TRANSPOSE_TILE.
+ *
+ * Returns 0 on success, -1 if itemsize is not 1, 2, 4, 8 or 16, or if
+ * the pointers and strides are not multiples of the smaller of itemsize
+ * and 8; nothing is copied then.
+ */
+NPY_NO_EXPORT int
+PyMicArray_TransposeCopy(int device, npy_intp itemsize, npy_intp nbatch,
+                         npy_intp rows, npy_intp cols,
+                         char *dst, npy_intp dst_row_stride,
+                         npy_intp dst_batch_stride,
+                         char *src, npy_intp src_row_stride,
+                         npy_intp src_batch_stride);
+
 /*
  * These two functions copy or convert the data of an n-dimensional array
  * to/from a 1-dimensional strided buffer.  These functions will only call
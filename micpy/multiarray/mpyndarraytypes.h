@@ -10,6 +10,24 @@
 
 typedef int (PyMicArray_CompareFunc)(const void *, const void *, void *);
 typedef int (PyMicArray_ArgFunc)(void*, npy_intp, npy_intp*, int);
+/*
+ * argmax or argmin of nrows strided rows at once:
+ * (data, n, stride, nrows, row_stride, out, scratch, device), strides in
+ * bytes, scratch of the size given by PyMicArray_ArgReduceScratch
+ */
+typedef void (PyMicArray_ArgReduceFunc)(char *, npy_intp, npy_intp,
+                                        npy_intp, npy_intp, npy_intp *,
+                                        void *, int);
+/*
+ * both extremes of nrows strided rows and their indices, any output
+ * may be NULL: (data, n, stride, nrows, row_stride,
+ *               min, argmin, max, argmax, scratch, device),
+ * scratch of the size given by PyMicArray_MinMaxScratch
+ */
+typedef void (PyMicArray_MinMaxFunc)(char *, npy_intp, npy_intp,
+                                     npy_intp, npy_intp,
+                                     char *, npy_intp *, char *, npy_intp *,
+                                     void *, int);
 
 typedef void (PyMicArray_DotFunc)(void *, npy_intp, void *, npy_intp, void *,
                                   npy_intp, int);
@@ -32,7 +50,7 @@ typedef int (PyMicArray_ArgPartitionFunc)(void *, npy_intp *, npy_intp, npy_intp
                                        npy_intp *, npy_intp *,
                                        void *);
 
-typedef int (PyMicArray_FillWithScalarFunc)(void *, npy_intp, void *, void *);
+typedef int (PyMicArray_FillWithScalarFunc)(void *, npy_intp, void *, int);
 
 typedef int (PyMicArray_ScalarKindFunc)(void *);
 
@@ -138,6 +156,25 @@ typedef struct {
 
 } PyMicArray_ArrFuncs;
 
+/*
+ * The C side of the __mic_array_interface__ protocol, held in a
+ * PyCapsule named "mic_array_struct" returned by __mic_array_struct__.
+ * Like PyArrayInterface, with the device owning data added.
+ */
+typedef struct {
+        int two;              /* contains the integer 2 -- simple sanity check */
+        int nd;               /* number of dimensions */
+        char typekind;        /* kind in array --- character code of typestr */
+        int itemsize;         /* size of each element */
+        int flags;            /* flags indicating how the data should be
+                                 interpreted, see PyArrayInterface */
+        npy_intp *shape;      /* A length-nd array of shape information */
+        npy_intp *strides;    /* A length-nd array of stride information */
+        void *data;           /* A pointer to the first element, in memory
+                                 of device */
+        int device;           /* device holding data */
+} PyMicArrayInterface;
+
 #define PyMicArray_ISBOOL(obj) PyTypeNum_ISBOOL(PyMicArray_TYPE(obj))
 #define PyMicArray_ISUNSIGNED(obj) PyTypeNum_ISUNSIGNED(PyMicArray_TYPE(obj))
 #define PyMicArray_ISSIGNED(obj) PyTypeNum_ISSIGNED(PyMicArray_TYPE(obj))
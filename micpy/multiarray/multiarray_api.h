@@ -253,4 +253,13 @@ static int _import_pymicarray() {
 #define PyMicArray_OutputConverter \
     ((int (*)(PyObject *, PyMicArrayObject **)) \
      PyMicArray_API[58])
+#define PyMicArray_Pin \
+    (*(int (*)(PyMicArrayObject *)) \
+     PyMicArray_API[59])
+#define PyMicArray_Unpin \
+    (*(void (*)(PyMicArrayObject *)) \
+     PyMicArray_API[60])
+#define PyMicArray_BindTeam \
+    (*(void (*)(int)) \
+     PyMicArray_API[61])
 #endif
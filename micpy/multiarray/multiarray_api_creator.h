@@ -69,6 +69,9 @@
         (void *) &PyMicArray_SetBaseObject,\
         (void *) &PyMicArray_SetUpdateIfCopyBase,\
         (void *) &PyMicArray_OutputConverter,\
+        (void *) &PyMicArray_Pin,\
+        (void *) &PyMicArray_Unpin,\
+        (void *) &PyMicArray_BindTeam,\
         NULL\
     }
 
@@ -31,7 +31,7 @@
 #define _MICARRAYMODULE
 /* Internal APIs */
 #include "arrayobject.h"
-//#include "calculation.h"
+#include "calculation.h"
 #include "number.h"
 //#include "numpymemoryview.h"
 #include "mpyndarraytypes.h"
@@ -50,15 +50,59 @@
 #include "cblasfuncs.h"
 #include "mpymem_overlap.h"
 #include "convert_datatype.h"
+#include "staging.h"
+#include "mpy_dlpack.h"
+#include "numa.h"
+#include "residency.h"
+#include "item_selection.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include <mkl_service.h>
 
-static int num_devices;
-static int current_device;
+/*
+ * Querying the devices starts the offload runtime, which is slow. It is
+ * done on first use rather than at import, see _init_devices.
+ * Without offload devices, the devices are the NUMA nodes of the host.
+ */
+static int num_devices = -1;
+static int default_device = -1;
+
+/*
+ * Every thread has its own current device, so that threads driving
+ * different devices do not race on it. It starts at the default device
+ * the first time the thread asks for it.
+ */
+static NPY_TLS int current_device = -1;
+
+static NPY_INLINE void
+_init_devices(void)
+{
+    if (num_devices < 0) {
+        int ndevices = omp_get_num_devices();
+
+        default_device = omp_get_default_device();
+        if (ndevices == 0) {
+            ndevices = mpy_numa_init();
+            default_device = 0;
+        }
+        num_devices = ndevices;
+    }
+}
 
 NPY_NO_EXPORT int PyMicArray_GetCurrentDevice(void){
+    if (current_device < 0) {
+        _init_devices();
+        current_device = default_device;
+    }
     return current_device;
 }
 
 NPY_NO_EXPORT int PyMicArray_SetCurrentDevice(int device_id){
+    _init_devices();
     if (device_id >= 0 && device_id < num_devices) {
         current_device = device_id;
         return 0;
@@ -67,12 +111,18 @@ NPY_NO_EXPORT int PyMicArray_SetCurrentDevice(int device_id){
 }
 
 NPY_NO_EXPORT int PyMicArray_GetNumDevices(void){
+    _init_devices();
     return num_devices;
 }
 
 static PyObject *
 get_current_device(PyObject *NPY_UNUSED(ignored), PyObject *args){
-    return (PyObject *) PyInt_FromLong(current_device);
+    return (PyObject *) PyInt_FromLong(PyMicArray_GetCurrentDevice());
+}
+
+static PyObject *
+get_num_devices(PyObject *NPY_UNUSED(ignored), PyObject *args){
+    return (PyObject *) PyInt_FromLong(PyMicArray_GetNumDevices());
 }
 
 static PyObject *
@@ -80,14 +130,357 @@ set_current_device(PyObject *NPY_UNUSED(ignored), PyObject *device_id)
 {
     int device = -1;
 
+    if (device_id == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "device must be an integer");
+        return NULL;
+    }
     if (!PyMicArray_DeviceConverter(device_id, &device)) {
         return NULL;
     }
+    if (PyMicArray_SetCurrentDevice(device) < 0) {
+        PyErr_Format(PyExc_ValueError, "device must be in range [%d,%d)",
+                     0, PyMicArray_GetNumDevices());
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/*
+ * Thread team and affinity of the devices.
+ *
+ * The settings are pushed to the device once: omp_set_num_threads and
+ * mkl_set_num_threads change the ICVs of the offload thread running the
+ * region, and the kmp affinity masks stay bound to the threads of the
+ * device thread pool. Later target regions, BLAS and VSL calls start
+ * from that team only because the Intel offload runtime keeps the ICVs
+ * of its threads from one region to the next. With a runtime giving
+ * every region fresh ICVs the masks still hold, but the team size falls
+ * back to the default.
+ */
+
+/* largest number of procs of a device handled */
+#define MPY_MAXPROCS 1024
+
+/*
+ * The procs the calling thread may run on, grouped by core: the procs of
+ * core c are procs[first[c]] to procs[first[c + 1] - 1]. Cores are told
+ * apart by the sibling lists of sysfs, which covers the 4-way cores of
+ * the coprocessor as well as the host NUMA nodes; where they cannot be
+ * read, every proc is a core of its own.
+ */
+typedef struct {
+    int ncores;
+    int nprocs;
+    int first[MPY_MAXPROCS + 1];
+    int procs[MPY_MAXPROCS];
+} mpy_topology;
+
+typedef enum {
+    MPY_AFFINITY_NONE = 0,
+    MPY_AFFINITY_COMPACT,
+    MPY_AFFINITY_SCATTER,
+    MPY_AFFINITY_BALANCED
+} MPY_AFFINITY;
+
+static const char *affinity_names[] = {"none", "compact", "scatter",
+                                       "balanced"};
+
+/* set_device_threads was called, and not undone by reset_device_threads */
+static int device_configured[NMAXDEVICES];
+static int device_nthreads[NMAXDEVICES];
+static int device_affinity[NMAXDEVICES];
+static int device_core_offset[NMAXDEVICES];
+/* team sizes of the runtime, read before the first change */
+static int device_default_omp[NMAXDEVICES];
+static int device_default_mkl[NMAXDEVICES];
+
+#pragma omp declare target
+static void
+_read_topology(mpy_topology *topo)
+{
+    int key[MPY_MAXPROCS];
+    int cpu, i, n = 0;
+#ifdef __linux__
+    cpu_set_t allowed;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        for (cpu = 0; cpu < omp_get_num_procs() && cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &allowed);
+        }
+    }
+    for (cpu = 0; cpu < CPU_SETSIZE && n < MPY_MAXPROCS; ++cpu) {
+        char path[96];
+        FILE *f;
+        int k;
+
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        /* the lowest sibling names the core */
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+                 cpu);
+        f = fopen(path, "r");
+        if (f == NULL || fscanf(f, "%d", &k) != 1) {
+            k = cpu;
+        }
+        if (f != NULL) {
+            fclose(f);
+        }
+        /* insertion by core, keeping the procs of a core in order */
+        for (i = n; i > 0 && key[i - 1] > k; --i) {
+            key[i] = key[i - 1];
+            topo->procs[i] = topo->procs[i - 1];
+        }
+        key[i] = k;
+        topo->procs[i] = cpu;
+        ++n;
+    }
+#else
+    for (cpu = 0; cpu < omp_get_num_procs() && n < MPY_MAXPROCS; ++cpu) {
+        key[n] = cpu;
+        topo->procs[n++] = cpu;
+    }
+#endif
+    topo->nprocs = n;
+    topo->ncores = 0;
+    for (i = 0; i < n; ++i) {
+        if (i == 0 || key[i] != key[i - 1]) {
+            topo->first[topo->ncores++] = i;
+        }
+    }
+    topo->first[topo->ncores] = n;
+}
+
+static void
+_apply_device_threads(int nthreads, int affinity, int core_offset)
+{
+    mpy_topology topo;
+
+    omp_set_num_threads(nthreads);
+    mkl_set_num_threads(nthreads);
+    _read_topology(&topo);
+
+    #pragma omp parallel num_threads(nthreads) shared(topo)
+    {
+        int tid = omp_get_thread_num();
+        int ncores = topo.ncores - core_offset;
+        int base = topo.first[core_offset];
+        int core, ht, size, i;
+        kmp_affinity_mask_t mask;
+
+        kmp_create_affinity_mask(&mask);
+        switch (affinity) {
+            case MPY_AFFINITY_COMPACT:
+                /* fill the cores one after the other */
+                kmp_set_affinity_mask_proc(
+                    topo.procs[base + tid % (topo.nprocs - base)], &mask);
+                break;
+            case MPY_AFFINITY_SCATTER:
+                core = core_offset + tid % ncores;
+                ht = tid / ncores;
+                size = topo.first[core + 1] - topo.first[core];
+                kmp_set_affinity_mask_proc(
+                    topo.procs[topo.first[core] + ht % size], &mask);
+                break;
+            case MPY_AFFINITY_BALANCED:
+                /*
+                 * consecutive threads share a core, and the thread counts
+                 * of any two cores differ by one at most
+                 */
+                core = (int)((npy_int64)tid * ncores / nthreads);
+                ht = tid - (int)(((npy_int64)core * nthreads + ncores - 1)
+                                 / ncores);
+                core += core_offset;
+                size = topo.first[core + 1] - topo.first[core];
+                kmp_set_affinity_mask_proc(
+                    topo.procs[topo.first[core] + ht % size], &mask);
+                break;
+            default:
+                /* unpinned: any proc of the device */
+                for (i = 0; i < topo.nprocs; ++i) {
+                    kmp_set_affinity_mask_proc(topo.procs[i], &mask);
+                }
+                break;
+        }
+        kmp_set_affinity(&mask);
+        kmp_destroy_affinity_mask(&mask);
+    }
+}
+
+/*
+ * Number of cores of the device, and of procs from core core_offset on,
+ * with the current team sizes of OpenMP and MKL.
+ */
+static void
+_query_device_threads(int core_offset, int *ncores, int *nprocs,
+                      int *omp_threads, int *mkl_threads)
+{
+    mpy_topology topo;
+
+    _read_topology(&topo);
+    *ncores = topo.ncores;
+    *nprocs = core_offset >= 0 && core_offset < topo.ncores ?
+              topo.nprocs - topo.first[core_offset] : 0;
+    *omp_threads = omp_get_max_threads();
+    *mkl_threads = mkl_get_max_threads();
+}
+#pragma omp end declare target
+
+static int
+_affinity_converter(PyObject *object, int *affinity)
+{
+    char *str = NULL;
+    PyObject *tmp = NULL;
+    int i;
+
+    if (object == Py_None) {
+        *affinity = MPY_AFFINITY_NONE;
+        return NPY_SUCCEED;
+    }
+    if (PyUnicode_Check(object)) {
+        tmp = PyUnicode_AsASCIIString(object);
+        if (tmp == NULL) {
+            return NPY_FAIL;
+        }
+        str = PyBytes_AS_STRING(tmp);
+    }
+    else if (PyBytes_Check(object)) {
+        str = PyBytes_AS_STRING(object);
+    }
+
+    if (str != NULL) {
+        for (i = 0; i < 4; ++i) {
+            if (strcmp(str, affinity_names[i]) == 0) {
+                *affinity = i;
+                Py_XDECREF(tmp);
+                return NPY_SUCCEED;
+            }
+        }
+    }
+    Py_XDECREF(tmp);
+    PyErr_SetString(PyExc_ValueError,
+                    "affinity must be one of 'compact', 'scatter', "
+                    "'balanced' or None");
+    return NPY_FAIL;
+}
+
+static PyObject *
+set_device_threads(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"device", "n", "affinity", "core_offset", NULL};
+    int device = -1, nthreads = 0, affinity = MPY_AFFINITY_NONE;
+    int core_offset = 0, ncores = 0, nprocs = 0;
+    int omp_threads = 0, mkl_threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&i|O&i:set_device_threads",
+                                     kwlist,
+                                     PyMicArray_DeviceConverter, &device,
+                                     &nthreads,
+                                     _affinity_converter, &affinity,
+                                     &core_offset)) {
+        return NULL;
+    }
+    if (device < 0) {
+        PyErr_SetString(PyExc_ValueError, "device must be given");
+        return NULL;
+    }
 
-    current_device = device;
+    #pragma omp target device(mpy_omp_launch(mpy_omp_device(device))) \
+            map(to: core_offset) \
+            map(from: ncores, nprocs, omp_threads, mkl_threads)
+    _query_device_threads(core_offset, &ncores, &nprocs,
+                          &omp_threads, &mkl_threads);
+
+    if (core_offset < 0 || core_offset >= ncores) {
+        PyErr_Format(PyExc_ValueError,
+                     "core_offset must be within [0, %d)", ncores);
+        return NULL;
+    }
+    if (nthreads < 0 || nthreads > nprocs) {
+        PyErr_Format(PyExc_ValueError,
+                     "n must be within [0, %d] on device %d",
+                     nprocs, device);
+        return NULL;
+    }
+    if (nthreads == 0) {
+        nthreads = nprocs;
+    }
+    if (!device_configured[device]) {
+        device_default_omp[device] = omp_threads;
+        device_default_mkl[device] = mkl_threads;
+    }
+
+    #pragma omp target device(mpy_omp_launch(mpy_omp_device(device))) \
+            map(to: nthreads, affinity, core_offset)
+    _apply_device_threads(nthreads, affinity, core_offset);
+
+    device_configured[device] = 1;
+    device_nthreads[device] = nthreads;
+    device_affinity[device] = affinity;
+    device_core_offset[device] = core_offset;
+    Py_RETURN_NONE;
+}
+
+/*
+ * Undo set_device_threads: the team sizes of the runtime come back and
+ * the threads are unpinned.
+ */
+static PyObject *
+reset_device_threads(PyObject *NPY_UNUSED(ignored), PyObject *args,
+                     PyObject *kwds)
+{
+    static char *kwlist[] = {"device", NULL};
+    int device = CURRENT_DEVICE;
+    int omp_threads, mkl_threads;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&:reset_device_threads",
+                                     kwlist,
+                                     PyMicArray_DeviceConverter, &device)) {
+        return NULL;
+    }
+    if (!device_configured[device]) {
+        Py_RETURN_NONE;
+    }
+    omp_threads = device_default_omp[device];
+    mkl_threads = device_default_mkl[device];
+
+    #pragma omp target device(mpy_omp_launch(mpy_omp_device(device))) \
+            map(to: omp_threads, mkl_threads)
+    {
+        _apply_device_threads(omp_threads, MPY_AFFINITY_NONE, 0);
+        mkl_set_num_threads(mkl_threads);
+    }
+
+    device_configured[device] = 0;
+    device_nthreads[device] = 0;
+    device_affinity[device] = MPY_AFFINITY_NONE;
+    device_core_offset[device] = 0;
     Py_RETURN_NONE;
 }
 
+/* (n, affinity, core_offset) of the device, None if never set */
+static PyObject *
+get_device_threads(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"device", NULL};
+    int device = CURRENT_DEVICE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&:get_device_threads",
+                                     kwlist,
+                                     PyMicArray_DeviceConverter, &device)) {
+        return NULL;
+    }
+    if (!device_configured[device]) {
+        Py_RETURN_NONE;
+    }
+
+    return Py_BuildValue("(isi)", device_nthreads[device],
+                         affinity_names[device_affinity[device]],
+                         device_core_offset[device]);
+}
+
 static int
 _signbit_set(PyArrayObject *arr)
 {
@@ -296,6 +689,11 @@ PyMicArray_MatrixProduct2(PyObject *op1, PyObject *op2, PyMicArrayObject* out)
     if (out_buf == NULL) {
         goto fail;
     }
+    /* the iterators pin ap1 and ap2, out_buf is written through op */
+    if (mpy_residency_pin(out_buf) < 0) {
+        Py_CLEAR(out_buf);
+        goto fail;
+    }
     /* Ensure that multiarray.dot(<Nx0>,<0xM>) -> zeros((N,M)) */
     if (PyMicArray_SIZE(ap1) == 0 && PyMicArray_SIZE(ap2) == 0) {
         target_memset(PyMicArray_DATA(out_buf), 0, PyMicArray_NBYTES(out_buf),
@@ -355,7 +753,7 @@ PyMicArray_MatrixProduct2(PyObject *op1, PyObject *op2, PyMicArrayObject* out)
         copyn = PyMicArray_GetArrFuncs(typenum)->copyswapn;
         if (copyn != NULL) {
             usecache = 1;
-            cache = (char *) omp_target_alloc(elesize*l, device);
+            cache = (char *) target_alloc(elesize*l, device);
         }
     }
 
@@ -387,7 +785,7 @@ PyMicArray_MatrixProduct2(PyObject *op1, PyObject *op2, PyMicArrayObject* out)
     MpyIter_Deallocate(it1);
     MpyIter_Deallocate(it2);
     if (usecache) {
-        omp_target_free(cache, device);
+        target_free(cache, device);
         cache = NULL;
     }
     if (PyErr_Occurred()) {
@@ -398,6 +796,7 @@ PyMicArray_MatrixProduct2(PyObject *op1, PyObject *op2, PyMicArrayObject* out)
     Py_DECREF(ap2);
 
     /* Trigger possible copy-back into `result` */
+    mpy_residency_unpin(out_buf);
     Py_DECREF(out_buf);
 
     return (PyObject *)result;
@@ -405,6 +804,9 @@ PyMicArray_MatrixProduct2(PyObject *op1, PyObject *op2, PyMicArrayObject* out)
 fail:
     Py_XDECREF(ap1);
     Py_XDECREF(ap2);
+    if (out_buf != NULL) {
+        mpy_residency_unpin(out_buf);
+    }
     Py_XDECREF(out_buf);
     Py_XDECREF(result);
     return NULL;
@@ -419,8 +821,31 @@ fail:
 NPY_NO_EXPORT PyObject *
 PyMicArray_CopyAndTranspose(PyObject *op)
 {
-    //TODO: implement
-    return NULL;
+    PyMicArrayObject *arr, *tmp;
+    PyObject *ret;
+    int device = PyMicArray_Check(op) ? PyMicArray_DEVICE(op)
+                                      : CURRENT_DEVICE;
+
+    arr = (PyMicArrayObject *)PyMicArray_FromAny(device, op, NULL,
+                                                 0, 0, 0, NULL);
+    if (arr == NULL) {
+        return NULL;
+    }
+    if (PyMicArray_NDIM(arr) > 2) {
+        PyErr_SetString(PyExc_ValueError, "only 2-d arrays are allowed");
+        Py_DECREF(arr);
+        return NULL;
+    }
+
+    /* The copy of the transposed view is done by tiles on the device */
+    tmp = (PyMicArrayObject *)PyMicArray_Transpose(arr, NULL);
+    Py_DECREF(arr);
+    if (tmp == NULL) {
+        return NULL;
+    }
+    ret = PyMicArray_NewCopy(tmp, NPY_CORDER);
+    Py_DECREF(tmp);
+    return ret;
 }
 
 
@@ -469,6 +894,10 @@ _prepend_ones(PyMicArrayObject *arr, int nd, int ndmin, NPY_ORDER order)
         newdims[i] = PyMicArray_DIMS(arr)[k];
         newstrides[i] = PyMicArray_STRIDES(arr)[k];
     }
+    if (mpy_residency_pin(arr) < 0) {
+        Py_DECREF(arr);
+        return NULL;
+    }
     dtype = PyMicArray_DESCR(arr);
     Py_INCREF(dtype);
     ret = (PyMicArrayObject *)PyMicArray_NewFromDescr(
@@ -478,6 +907,8 @@ _prepend_ones(PyMicArrayObject *arr, int nd, int ndmin, NPY_ORDER order)
                         PyMicArray_DATA(arr),
                         PyMicArray_FLAGS(arr),
                         (PyObject *)arr);
+    /* from here the base pins arr for the view */
+    mpy_residency_unpin(arr);
     if (ret == NULL) {
         Py_DECREF(arr);
         return NULL;
@@ -957,6 +1388,93 @@ array_ones_like(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
     return (PyObject *)ret;
 }
 
+static PyObject *
+array_arange(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kws)
+{
+    PyObject *o_start = NULL, *o_stop = NULL, *o_step = NULL, *range = NULL;
+    static char *kwd[] = {"start", "stop", "step", "dtype", "device", NULL};
+    PyArray_Descr *typecode = NULL;
+    int device = DEFAULT_DEVICE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kws, "O|OOO&O&:arange", kwd,
+                &o_start, &o_stop, &o_step,
+                PyArray_DescrConverter2, &typecode,
+                PyMicArray_DeviceConverter, &device)) {
+        Py_XDECREF(typecode);
+        return NULL;
+    }
+    range = PyMicArray_ArangeObj(device, o_start, o_stop, o_step, typecode);
+    Py_XDECREF(typecode);
+    return range;
+}
+
+static PyObject *
+array_linspace(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kws)
+{
+    static char *kwd[] = {"start", "stop", "num", "endpoint", "retstep",
+                          "dtype", "device", NULL};
+    PyObject *start, *stop, *ret, *step = NULL;
+    PyArray_Descr *typecode = NULL;
+    Py_ssize_t num = 50;
+    npy_bool endpoint = NPY_TRUE, retstep = NPY_FALSE;
+    int device = DEFAULT_DEVICE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kws, "OO|nO&O&O&O&:linspace", kwd,
+                &start, &stop, &num,
+                PyArray_BoolConverter, &endpoint,
+                PyArray_BoolConverter, &retstep,
+                PyArray_DescrConverter2, &typecode,
+                PyMicArray_DeviceConverter, &device)) {
+        Py_XDECREF(typecode);
+        return NULL;
+    }
+    ret = PyMicArray_Linspace(device, start, stop, num, endpoint, typecode,
+                              retstep ? &step : NULL);
+    if (ret == NULL || !retstep) {
+        return ret;
+    }
+    return Py_BuildValue("(NN)", ret, step);
+}
+
+static PyObject *
+array_eye(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kws)
+{
+    static char *kwd[] = {"N", "M", "k", "dtype", "order", "device", NULL};
+    PyObject *o_m = Py_None;
+    PyArray_Descr *typecode = NULL;
+    Py_ssize_t n, m, k = 0;
+    NPY_ORDER order = NPY_CORDER;
+    int device = DEFAULT_DEVICE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kws, "n|OnO&O&O&:eye", kwd,
+                &n, &o_m, &k,
+                PyArray_DescrConverter, &typecode,
+                PyArray_OrderConverter, &order,
+                PyMicArray_DeviceConverter, &device)) {
+        goto fail;
+    }
+    if (o_m == Py_None) {
+        m = n;
+    }
+    else {
+        m = PyArray_PyIntAsIntp(o_m);
+        if (error_converting(m)) {
+            goto fail;
+        }
+    }
+    if (order != NPY_CORDER && order != NPY_FORTRANORDER) {
+        PyErr_SetString(PyExc_ValueError,
+                        "only 'C' or 'F' order is permitted");
+        goto fail;
+    }
+    return PyMicArray_Eye(device, n, m, k, typecode,
+                          order == NPY_FORTRANORDER);
+
+fail:
+    Py_XDECREF(typecode);
+    return NULL;
+}
+
 static PyObject *
 array_count_nonzero(PyObject *NPY_UNUSED(self), PyObject *args, PyObject *kwds)
 {
@@ -997,7 +1515,7 @@ array_vdot(PyObject *NPY_UNUSED(dummy), PyObject *args)
     PyObject *op1, *op2;
     npy_intp newdimptr[1] = {-1};
     PyArray_Dims newdims = {newdimptr, 1};
-    PyMicArrayObject *ap1 = NULL, *ap2  = NULL, *ret = NULL;
+    PyMicArrayObject *ap1 = NULL, *ap2  = NULL, *ret = NULL, *pinned[3];
     PyArray_Descr *type;
     PyMicArray_DotFunc *vdot;
     NPY_BEGIN_THREADS_DEF;
@@ -1056,6 +1574,12 @@ array_vdot(PyObject *NPY_UNUSED(dummy), PyObject *args)
         goto fail;
     }
 
+    pinned[0] = ap1;
+    pinned[1] = ap2;
+    pinned[2] = ret;
+    if (mpy_residency_pin_all(pinned, 3) < 0) {
+        goto fail;
+    }
     n = PyMicArray_DIM(ap1, 0);
     stride1 = PyMicArray_STRIDE(ap1, 0);
     stride2 = PyMicArray_STRIDE(ap2, 0);
@@ -1078,6 +1602,7 @@ array_vdot(PyObject *NPY_UNUSED(dummy), PyObject *args)
             if (vdot == NULL) {
                 PyErr_SetString(PyExc_ValueError,
                         "function not available for this data type");
+                mpy_residency_unpin_all(pinned, 3);
                 goto fail;
             }
     }
@@ -1090,6 +1615,7 @@ array_vdot(PyObject *NPY_UNUSED(dummy), PyObject *args)
         vdot(ip1, stride1, ip2, stride2, op, n, device);
         NPY_END_THREADS_DESCR(type);
     }
+    mpy_residency_unpin_all(pinned, 3);
 
     Py_XDECREF(ap1);
     Py_XDECREF(ap2);
@@ -1104,29 +1630,52 @@ fail:
 static PyObject *
 array_fastCopyAndTranspose(PyObject *NPY_UNUSED(dummy), PyObject *args)
 {
-    //TODO: implement this
-    return NULL;
+    PyObject *a0;
+
+    if (!PyArg_ParseTuple(args, "O:_fastCopyAndTranspose", &a0)) {
+        return NULL;
+    }
+    return PyMicArray_Return(
+                (PyMicArrayObject *)PyMicArray_CopyAndTranspose(a0));
 }
 
 
+/*
+ * With a dtype, the elements are cast during the copy, see
+ * mpy_cast_copy.
+ */
 static PyObject *
-array_tohost(PyObject *NPY_UNUSED(ignored), PyObject *args)
+array_tohost(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
 {
+    static char *kwlist[] = {"arr","dtype",NULL};
     PyObject *array = NULL;
+    PyArray_Descr *dtype = NULL;
     PyArrayObject *ret = NULL;
 
-    if (!PyArg_ParseTuple(args, "O&",
-                &PyMicArray_GeneralConverter, &array)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&", kwlist,
+                &PyMicArray_GeneralConverter, &array,
+                &PyArray_DescrConverter2, &dtype)) {
         goto fail;
     }
 
     /* If array is numpy ndarray, return itself */
     if (PyArray_Check(array)) {
+        if (dtype != NULL) {
+            ret = (PyArrayObject *)PyArray_FromArray((PyArrayObject *)array,
+                                                     dtype, 0);
+            Py_DECREF(array);
+            return (PyObject *)ret;
+        }
         return array;
     }
 
+    /* steals the reference to dtype */
     ret = (PyArrayObject *) PyArray_NewLikeArray((PyArrayObject *) array,
-                                            NPY_KEEPORDER, NULL, 0);
+                                            NPY_KEEPORDER, dtype, 0);
+    dtype = NULL;
+    if (ret == NULL) {
+        goto fail;
+    }
     if (PyMicArray_CopyIntoHost(ret, (PyMicArrayObject * ) array) < 0){
         Py_XDECREF(ret);
         goto fail;
@@ -1137,26 +1686,152 @@ array_tohost(PyObject *NPY_UNUSED(ignored), PyObject *args)
 
 fail:
     Py_XDECREF(array);
+    Py_XDECREF(dtype);
     return NULL;
 }
 
 
+/*
+ * Copy a device array into an existing host array of the same shape,
+ * the counterpart of copyto for the other direction.
+ */
+static PyObject *
+array_copyto_host(PyObject *NPY_UNUSED(ignored), PyObject *args)
+{
+    PyArrayObject *dst;
+    PyMicArrayObject *src;
+
+    if (!PyArg_ParseTuple(args, "O!O!:_copyto_host",
+                          &PyArray_Type, &dst, &PyMicArray_Type, &src)) {
+        return NULL;
+    }
+    if (PyMicArray_CopyIntoHost(dst, src) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/*
+ * Mean and standard deviation of an array from the same single pass over
+ * the data, see PyMicArray_MeanVar.
+ */
+static PyObject *
+array_mean_std(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"a", "axis", "dtype", "ddof", "keepdims", NULL};
+    PyMicArrayObject *arr, *mean = NULL, *std = NULL;
+    PyObject *axis_in = Py_None;
+    PyArray_Descr *dtype = NULL;
+    npy_bool axis_flags[NPY_MAXDIMS];
+    int ddof = 0, keepdims = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|OO&ii:mean_std", kwlist,
+                                     &PyMicArray_Type, &arr, &axis_in,
+                                     PyArray_DescrConverter2, &dtype,
+                                     &ddof, &keepdims)) {
+        Py_XDECREF(dtype);
+        return NULL;
+    }
+    if (PyMicArray_ConvertMultiAxis(axis_in, PyMicArray_NDIM(arr),
+                                    axis_flags) != NPY_SUCCEED) {
+        Py_XDECREF(dtype);
+        return NULL;
+    }
+    if (PyMicArray_MeanVar(arr, axis_flags, dtype, ddof, keepdims, 1,
+                           &mean, &std) < 0) {
+        return NULL;
+    }
+    return Py_BuildValue("NN", PyMicArray_Return(mean),
+                         PyMicArray_Return(std));
+}
+
+/*
+ * minmax, max_with_index and min_with_index: the results first and
+ * second of one pass of PyMicArray_MinMax, numbered as its outputs.
+ */
+static PyObject *
+_minmax_pair(PyObject *args, PyObject *kwds, const char *fmt,
+             int first, int second)
+{
+    static char *kwlist[] = {"a", "axis", NULL};
+    PyMicArrayObject *arr, *res[4] = {NULL, NULL, NULL, NULL};
+    PyMicArrayObject **outs[4] = {NULL, NULL, NULL, NULL};
+    int axis = NPY_MAXDIMS;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, fmt, kwlist,
+                                     &PyMicArray_Type, &arr,
+                                     PyArray_AxisConverter, &axis)) {
+        return NULL;
+    }
+    outs[first] = &res[first];
+    outs[second] = &res[second];
+    if (PyMicArray_MinMax(arr, axis, outs[0], outs[1],
+                          outs[2], outs[3]) < 0) {
+        return NULL;
+    }
+    return Py_BuildValue("NN", PyMicArray_Return(res[first]),
+                         PyMicArray_Return(res[second]));
+}
+
+static PyObject *
+array_minmax(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
+{
+    return _minmax_pair(args, kwds, "O!|O&:minmax", 0, 2);
+}
+
+static PyObject *
+array_max_with_index(PyObject *NPY_UNUSED(ignored), PyObject *args,
+                     PyObject *kwds)
+{
+    return _minmax_pair(args, kwds, "O!|O&:max_with_index", 2, 3);
+}
+
+static PyObject *
+array_min_with_index(PyObject *NPY_UNUSED(ignored), PyObject *args,
+                     PyObject *kwds)
+{
+    return _minmax_pair(args, kwds, "O!|O&:min_with_index", 0, 1);
+}
+
+/* Items of a device array at flat indices, as a host array */
+static PyObject *
+array_take_items(PyObject *NPY_UNUSED(ignored), PyObject *args)
+{
+    PyMicArrayObject *arr;
+    PyObject *indices;
+
+    if (!PyArg_ParseTuple(args, "O!O:_take_items",
+                          &PyMicArray_Type, &arr, &indices)) {
+        return NULL;
+    }
+    return PyMicArray_TakeItems(arr, indices);
+}
+
+
 static PyObject *
 array_todevice(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
 {
-    static char *kwlist[] = {"arr","device",NULL};
+    static char *kwlist[] = {"arr","device","dtype",NULL};
     PyArrayObject *array = NULL;
+    PyArray_Descr *dtype = NULL;
     PyMicArrayObject *ret = NULL;
     int device = DEFAULT_DEVICE;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&", kwlist,
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&O&", kwlist,
                 &PyArray_Converter, &array,
-                &PyMicArray_DeviceConverter, &device)) {
+                &PyMicArray_DeviceConverter, &device,
+                &PyArray_DescrConverter2, &dtype)) {
         goto fail;
     }
 
+    /* steals the reference to dtype */
     ret = (PyMicArrayObject *)PyMicArray_NewLikeArray(device, array,
-                                            NPY_KEEPORDER, NULL, 0);
+                                            NPY_KEEPORDER, dtype, 0);
+    dtype = NULL;
+    if (ret == NULL) {
+        goto fail;
+    }
     if (PyMicArray_CopyIntoFromHost(ret, array) < 0){
         Py_XDECREF(ret);
         goto fail;
@@ -1167,9 +1842,288 @@ array_todevice(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
 
 fail:
     Py_XDECREF(array);
+    Py_XDECREF(dtype);
     return NULL;
 }
 
+/*
+ * Size, duration and bandwidth of the last device to device copy done
+ * by the calling thread.
+ */
+static PyObject *
+peer_copy_stats(PyObject *NPY_UNUSED(ignored), PyObject *NPY_UNUSED(args))
+{
+    MpyPeerStats stats;
+    double bandwidth;
+
+    mpy_peer_last_stats(&stats);
+    bandwidth = stats.seconds > 0 ? stats.nbytes / stats.seconds : 0.0;
+    return Py_BuildValue("{s:n,s:d,s:d,s:s}",
+                         "nbytes", stats.nbytes,
+                         "seconds", stats.seconds,
+                         "bandwidth", bandwidth,
+                         "mode", stats.mode == MPY_PEER_STAGED ? "staged"
+                                                               : "direct");
+}
+
+/*
+ * Turn the residency manager on or off, see residency.h. Only arrays
+ * allocated while it is on are evicted. Returns the previous state.
+ */
+static PyObject *
+set_residency(PyObject *NPY_UNUSED(ignored), PyObject *args)
+{
+    PyObject *enabled = Py_True;
+    int previous, on;
+
+    if (!PyArg_ParseTuple(args, "|O:set_residency", &enabled)) {
+        return NULL;
+    }
+    on = PyObject_IsTrue(enabled);
+    if (on < 0) {
+        return NULL;
+    }
+    previous = mpy_residency_enable(on);
+    if (previous < 0) {
+        return NULL;
+    }
+    return PyBool_FromLong(previous);
+}
+
+/*
+ * Keep 0-d results on the device for the calling thread, see
+ * mpy_set_device_scalars. Returns the previous setting.
+ */
+static PyObject *
+set_device_scalars(PyObject *NPY_UNUSED(ignored), PyObject *args)
+{
+    PyObject *enabled = Py_True;
+    int on;
+
+    if (!PyArg_ParseTuple(args, "|O:set_device_scalars", &enabled)) {
+        return NULL;
+    }
+    on = PyObject_IsTrue(enabled);
+    if (on < 0) {
+        return NULL;
+    }
+    return PyBool_FromLong(mpy_set_device_scalars(on));
+}
+
+/* Bring an evicted array back to its device, see micpy.device.prefetch */
+static PyObject *
+array_fetch(PyObject *NPY_UNUSED(ignored), PyObject *args)
+{
+    PyMicArrayObject *arr;
+
+    if (!PyArg_ParseTuple(args, "O!:_fetch", &PyMicArray_Type, &arr)) {
+        return NULL;
+    }
+    if (mpy_residency_fetch(arr) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+residency_stats(PyObject *NPY_UNUSED(ignored), PyObject *NPY_UNUSED(args))
+{
+    MpyResidencyStats stats;
+
+    mpy_residency_stats(&stats);
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n,s:n}",
+                         "evictions", stats.evictions,
+                         "fetches", stats.fetches,
+                         "evicted_bytes", stats.evicted_bytes,
+                         "fetched_bytes", stats.fetched_bytes,
+                         "resident", stats.resident,
+                         "on_host", stats.on_host);
+}
+
+/*
+ * 1-d view of the elements [start, stop) of a C contiguous array, in
+ * flat order. Used to cut arrays into segments, see micpy.comm.
+ */
+static PyObject *
+array_flat_chunk(PyObject *NPY_UNUSED(ignored), PyObject *args)
+{
+    PyMicArrayObject *arr, *ret;
+    PyArray_Descr *descr;
+    npy_intp start, stop, n;
+
+    if (!PyArg_ParseTuple(args, "O!nn:_flat_chunk",
+                          &PyMicArray_Type, &arr, &start, &stop)) {
+        return NULL;
+    }
+    if (!PyMicArray_IS_C_CONTIGUOUS(arr)) {
+        PyErr_SetString(PyExc_ValueError, "array must be C contiguous");
+        return NULL;
+    }
+    if (start < 0 || stop < start || stop > PyMicArray_SIZE(arr)) {
+        PyErr_Format(PyExc_ValueError,
+                     "chunk [%"NPY_INTP_FMT", %"NPY_INTP_FMT") out of "
+                     "bounds for size %"NPY_INTP_FMT,
+                     start, stop, PyMicArray_SIZE(arr));
+        return NULL;
+    }
+
+    n = stop - start;
+    if (mpy_residency_pin(arr) < 0) {
+        return NULL;
+    }
+    descr = PyMicArray_DESCR(arr);
+    Py_INCREF(descr);
+    ret = (PyMicArrayObject *)PyMicArray_NewFromDescr(
+                        PyMicArray_DEVICE(arr), &PyMicArray_Type, descr,
+                        1, &n, NULL,
+                        PyMicArray_BYTES(arr) + start * descr->elsize,
+                        PyMicArray_FLAGS(arr) & NPY_ARRAY_WRITEABLE,
+                        NULL);
+    /* from here the base pins arr for the view */
+    mpy_residency_unpin(arr);
+    if (ret == NULL) {
+        return NULL;
+    }
+    Py_INCREF(arr);
+    if (PyMicArray_SetBaseObject(ret, (PyObject *)arr) < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return (PyObject *)ret;
+}
+
+/*
+ * Create the empty array that __setstate__ fills when unpickling.
+ */
+static PyObject *
+array__reconstruct(PyObject *NPY_UNUSED(dummy), PyObject *args)
+{
+    PyTypeObject *subtype;
+    int device;
+    npy_intp shape = 0;
+
+    if (!PyArg_ParseTuple(args, "O!i:_reconstruct",
+                          &PyType_Type, &subtype, &device)) {
+        return NULL;
+    }
+    if (!PyType_IsSubtype(subtype, &PyMicArray_Type)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "_reconstruct: First argument must be a sub-type "
+                        "of micpy.ndarray");
+        return NULL;
+    }
+    /* the pickle may come from a machine with more devices */
+    if (device < 0 || device >= N_DEVICES) {
+        device = CURRENT_DEVICE;
+    }
+    return PyMicArray_NewFromDescr(device, subtype,
+                                   PyArray_DescrFromType(NPY_BYTE),
+                                   1, &shape, NULL, NULL, 0, NULL);
+}
+
+/*
+ * Encode a str or bytes path to a bytes object, NULL if file is not a path.
+ */
+static PyObject *
+_path_as_bytes(PyObject *file)
+{
+    if (PyBytes_Check(file)) {
+        Py_INCREF(file);
+        return file;
+    }
+    if (PyUnicode_Check(file)) {
+#if defined(NPY_PY3K)
+        return PyUnicode_EncodeFSDefault(file);
+#else
+        return PyUnicode_AsEncodedString(file, NULL, NULL);
+#endif
+    }
+    return NULL;
+}
+
+static PyObject *
+array_fromfile(PyObject *NPY_UNUSED(ignored), PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"file", "dtype", "count", "sep", "offset",
+                             "device", NULL};
+    PyObject *file = NULL, *path = NULL, *ret = NULL, *res;
+    PyArray_Descr *type = NULL;
+    npy_intp num = -1;
+    Py_ssize_t nsep = 0;
+    char *sep = "";
+    npy_off_t offset = 0, pos = 0;
+    npy_longlong loffset = 0;
+    int device = DEFAULT_DEVICE;
+    int fd, direct = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&ns#LO&:fromfile",
+                kwlist, &file,
+                PyArray_DescrConverter, &type,
+                &num, &sep, &nsep, &loffset,
+                PyMicArray_DeviceConverter, &device)) {
+        Py_XDECREF(type);
+        return NULL;
+    }
+    if (nsep != 0) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "micpy only reads binary files, sep must be ''");
+        Py_XDECREF(type);
+        return NULL;
+    }
+    if (type == NULL) {
+        type = PyArray_DescrFromType(NPY_DEFAULT_TYPE);
+    }
+    offset = (npy_off_t)loffset;
+
+    path = _path_as_bytes(file);
+    if (path != NULL) {
+        fd = mpy_open_direct(PyBytes_AS_STRING(path), &direct);
+        Py_DECREF(path);
+        if (fd < 0) {
+            Py_DECREF(type);
+            return NULL;
+        }
+        ret = PyMicArray_FromFile(device, fd, offset, type, num, direct);
+        close(fd);
+        return ret;
+    }
+    if (PyErr_Occurred()) {
+        Py_DECREF(type);
+        return NULL;
+    }
+
+    /* An open file: read from its current position and move past the data */
+    fd = PyObject_AsFileDescriptor(file);
+    if (fd < 0) {
+        Py_DECREF(type);
+        return NULL;
+    }
+    res = PyObject_CallMethod(file, "tell", NULL);
+    if (res == NULL) {
+        Py_DECREF(type);
+        return NULL;
+    }
+    pos = (npy_off_t)PyLong_AsLongLong(res);
+    Py_DECREF(res);
+    if (pos == -1 && PyErr_Occurred()) {
+        Py_DECREF(type);
+        return NULL;
+    }
+
+    ret = PyMicArray_FromFile(device, fd, pos + offset, type, num, 0);
+    if (ret == NULL) {
+        return NULL;
+    }
+    pos += offset + PyMicArray_NBYTES((PyMicArrayObject *)ret);
+    res = PyObject_CallMethod(file, "seek", "Li", (npy_longlong)pos, 0);
+    if (res == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    Py_DECREF(res);
+    return ret;
+}
+
 
 static PyObject *
 format_longfloat(PyObject *NPY_UNUSED(dummy), PyObject *args, PyObject *kwds)
@@ -1225,10 +2179,15 @@ static struct PyMethodDef array_module_methods[] = {
     {"copyto",
         (PyCFunction)array_copyto,
         METH_VARARGS|METH_KEYWORDS, NULL},
-    /*{"arange",
+    {"arange",
         (PyCFunction)array_arange,
         METH_VARARGS|METH_KEYWORDS, NULL},
-    */
+    {"linspace",
+        (PyCFunction)array_linspace,
+        METH_VARARGS|METH_KEYWORDS, NULL},
+    {"eye",
+        (PyCFunction)array_eye,
+        METH_VARARGS|METH_KEYWORDS, NULL},
     {"ones",
         (PyCFunction)array_ones,
         METH_VARARGS|METH_KEYWORDS, NULL},
@@ -1289,9 +2248,6 @@ static struct PyMethodDef array_module_methods[] = {
     {"frombuffer",
         (PyCFunction)array_frombuffer,
         METH_VARARGS | METH_KEYWORDS, NULL},
-    {"fromfile",
-        (PyCFunction)array_fromfile,
-        METH_VARARGS | METH_KEYWORDS, NULL},
     {"can_cast",
         (PyCFunction)array_can_cast_safely,
         METH_VARARGS | METH_KEYWORDS, NULL},
@@ -1303,16 +2259,73 @@ static struct PyMethodDef array_module_methods[] = {
         METH_VARARGS, NULL},*/
     {"to_cpu",
         (PyCFunction)array_tohost,
-        METH_VARARGS, NULL},
+        METH_VARARGS | METH_KEYWORDS, NULL},
     {"to_mic",
         (PyCFunction)array_todevice,
         METH_VARARGS | METH_KEYWORDS, NULL},
+    {"_copyto_host",
+        (PyCFunction)array_copyto_host,
+        METH_VARARGS, NULL},
+    {"_take_items",
+        (PyCFunction)array_take_items,
+        METH_VARARGS, NULL},
+    {"mean_std",
+        (PyCFunction)array_mean_std,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"minmax",
+        (PyCFunction)array_minmax,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"max_with_index",
+        (PyCFunction)array_max_with_index,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"min_with_index",
+        (PyCFunction)array_min_with_index,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"fromfile",
+        (PyCFunction)array_fromfile,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"_reconstruct",
+        (PyCFunction)array__reconstruct,
+        METH_VARARGS, NULL},
+    {"from_dlpack",
+        (PyCFunction)from_dlpack,
+        METH_O, NULL},
+    {"peer_copy_stats",
+        (PyCFunction)peer_copy_stats,
+        METH_NOARGS, NULL},
+    {"_flat_chunk",
+        (PyCFunction)array_flat_chunk,
+        METH_VARARGS, NULL},
+    {"set_device_scalars",
+        (PyCFunction)set_device_scalars,
+        METH_VARARGS, NULL},
+    {"set_residency",
+        (PyCFunction)set_residency,
+        METH_VARARGS, NULL},
+    {"residency_stats",
+        (PyCFunction)residency_stats,
+        METH_NOARGS, NULL},
+    {"_fetch",
+        (PyCFunction)array_fetch,
+        METH_VARARGS, NULL},
     {"device",
         (PyCFunction)get_current_device,
         METH_NOARGS, NULL},
     {"set_device",
         (PyCFunction)set_current_device,
         METH_O, NULL},
+    {"get_ndevices",
+        (PyCFunction)get_num_devices,
+        METH_NOARGS, NULL},
+    {"set_device_threads",
+        (PyCFunction)set_device_threads,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"get_device_threads",
+        (PyCFunction)get_device_threads,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"reset_device_threads",
+        (PyCFunction)reset_device_threads,
+        METH_VARARGS | METH_KEYWORDS, NULL},
     {NULL, NULL, 0, NULL}                /* sentinel */
 };
 
@@ -1326,6 +2339,9 @@ NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_order = NULL;
 NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_copy = NULL;
 NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_dtype = NULL;
 NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_ndmin = NULL;
+NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_mic_array = NULL;
+NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_mic_array_interface = NULL;
+NPY_VISIBILITY_HIDDEN PyObject * mpy_ma_str_mic_array_struct = NULL;
 
 static int
 intern_strings(void)
@@ -1340,12 +2356,18 @@ intern_strings(void)
     mpy_ma_str_copy = PyUString_InternFromString("copy");
     mpy_ma_str_dtype = PyUString_InternFromString("dtype");
     mpy_ma_str_ndmin = PyUString_InternFromString("ndmin");
+    mpy_ma_str_mic_array = PyUString_InternFromString("__mic_array__");
+    mpy_ma_str_mic_array_interface =
+            PyUString_InternFromString("__mic_array_interface__");
+    mpy_ma_str_mic_array_struct =
+            PyUString_InternFromString("__mic_array_struct__");
 
     return mpy_ma_str_array && mpy_ma_str_array_prepare &&
            mpy_ma_str_array_wrap && mpy_ma_str_array_finalize &&
            mpy_ma_str_buffer && mpy_ma_str_ufunc &&
            mpy_ma_str_order && mpy_ma_str_copy && mpy_ma_str_dtype &&
-           mpy_ma_str_ndmin;
+           mpy_ma_str_ndmin && mpy_ma_str_mic_array &&
+           mpy_ma_str_mic_array_interface && mpy_ma_str_mic_array_struct;
 }
 
 #if defined(NPY_PY3K)
@@ -1370,13 +2392,9 @@ PyMODINIT_FUNC PyInit_multiarray(void) {
 #define RETVAL
 PyMODINIT_FUNC initmultiarray(void) {
 #endif
-    PyObject *m, *d, *s, *obj_ndevices;
+    PyObject *m, *d, *s;
     PyObject *c_api = NULL;
 
-    /* Init some variable */
-    num_devices = omp_get_num_devices();
-    current_device = omp_get_default_device();
-
     /* Create the module and add the functions */
 #if defined(NPY_PY3K)
     m = PyModule_Create(&moduledef);
@@ -1465,13 +2483,6 @@ PyMODINIT_FUNC initmultiarray(void) {
     //Py_INCREF(&PyMicArray_Type);
     PyDict_SetItemString(d, "ndarray", (PyObject *)&PyMicArray_Type);
 
-    /* Add some other constants */
-    obj_ndevices = (PyObject *) PyInt_FromLong(num_devices);
-    if (obj_ndevices != NULL) {
-        PyDict_SetItemString(d, "ndevices", obj_ndevices);
-        Py_DECREF(obj_ndevices);
-    }
-
     if (!intern_strings()) {
         goto err;
     }
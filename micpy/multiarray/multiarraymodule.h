@@ -11,6 +11,9 @@ NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_order;
 NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_copy;
 NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_dtype;
 NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_ndmin;
+NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_mic_array;
+NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_mic_array_interface;
+NPY_VISIBILITY_HIDDEN extern PyObject * mpy_ma_str_mic_array_struct;
 
 NPY_NO_EXPORT PyObject *
 PyMicArray_MatrixProduct2(PyObject *op1, PyObject *op2, PyMicArrayObject* out);
@@ -27,6 +27,7 @@
 #include "mem_overlap.h"
 #include "dtype_transfer.h"
 #include "nditer.h"
+#include "residency.h"
 
 #ifndef NPY_ITER_OVERLAP_ASSUME_ELEMENTWISE
 #define NPY_ITER_OVERLAP_ASSUME_ELEMENTWISE 0x40000000
@@ -224,7 +225,7 @@ MpyIter_AdvancedNew(int nop, PyMicArrayObject **op_in, npy_uint32 flags,
                 PyObject_Malloc(NIT_SIZEOF_ITERATOR(itflags, ndim, nop));
 
     /* Allocate on mic device */
-    offiter = omp_target_alloc(
+    offiter = target_alloc(
                     NIT_SIZEOF_ITERATOR(itflags, ndim, nop), device);
 
     NPY_IT_TIME_POINT(c_malloc);
@@ -250,7 +251,7 @@ MpyIter_AdvancedNew(int nop, PyMicArrayObject **op_in, npy_uint32 flags,
                         flags,
                         op_flags, op_itflags,
                         &NIT_MASKOP(iter))) {
-        omp_target_free((void *) offiter, device);
+        target_free((void *) offiter, device);
         PyObject_Free(iter);
         return NULL;
     }
@@ -607,6 +608,8 @@ MpyIter_Copy(MpyIter *iter)
     for (iop = 0; iop < nop; ++iop) {
         Py_INCREF(objects[iop]);
         Py_INCREF(dtypes[iop]);
+        /* pinned by iter already, this cannot fail */
+        mpy_residency_pin(objects[iop]);
     }
 
     /* Allocate buffers and make copies of the transfer data if necessary */
@@ -734,6 +737,9 @@ MpyIter_Deallocate(MpyIter *iter)
 
     /* Deallocate all the dtypes and objects that were iterated */
     for(iop = 0; iop < nop; ++iop, ++dtype, ++object) {
+        if (*object != NULL) {
+            mpy_residency_unpin(*object);
+        }
         Py_XDECREF(*dtype);
         Py_XDECREF(*object);
     }
@@ -1226,12 +1232,20 @@ npyiter_prepare_operands(int nop, PyMicArrayObject **op_in,
     int any_writemasked_ops = 0;
 
     /*
-     * Here we just prepare the provided operands.
+     * Here we just prepare the provided operands. The iterator holds
+     * their data pointers, so it pins them until it is deallocated,
+     * see residency.h.
      */
     for (iop = 0; iop < nop; ++iop) {
         op[iop] = op_in[iop];
-        Py_XINCREF(op[iop]);
         op_dtype[iop] = NULL;
+        if (op[iop] != NULL) {
+            if (mpy_residency_pin(op[iop]) < 0) {
+                op[iop] = NULL;
+                goto fail_iop;
+            }
+            Py_INCREF(op[iop]);
+        }
 
         /* Check the readonly/writeonly flags, and fill in op_itflags */
         if (!npyiter_check_per_op_flags(op_flags[iop], &op_itflags[iop])) {
@@ -1303,9 +1317,12 @@ npyiter_prepare_operands(int nop, PyMicArrayObject **op_in,
     return 1;
 
   fail_nop:
-    iop = nop;
+    iop = nop - 1;
   fail_iop:
-    for (i = 0; i < iop; ++i) {
+    for (i = 0; i <= iop; ++i) {
+        if (op[i] != NULL) {
+            mpy_residency_unpin(op[i]);
+        }
         Py_XDECREF(op[i]);
         Py_XDECREF(op_dtype[i]);
     }
@@ -2907,6 +2924,8 @@ npyiter_allocate_arrays(MpyIter *iter,
             if (out == NULL) {
                 return 0;
             }
+            /* just allocated, so on its device and this cannot fail */
+            mpy_residency_pin(out);
 
             op[iop] = out;
 
@@ -2939,10 +2958,13 @@ npyiter_allocate_arrays(MpyIter *iter,
             if (temp == NULL) {
                 return 0;
             }
+            mpy_residency_pin(temp);
             if (PyMicArray_CopyInto(temp, op[iop]) != 0) {
+                mpy_residency_unpin(temp);
                 Py_DECREF(temp);
                 return 0;
             }
+            mpy_residency_unpin(op[iop]);
             Py_DECREF(op[iop]);
             op[iop] = temp;
 
@@ -2987,6 +3009,8 @@ npyiter_allocate_arrays(MpyIter *iter,
             if (temp == NULL) {
                 return 0;
             }
+            /* just allocated, the copy below may allocate on the device */
+            mpy_residency_pin(temp);
 
             /*
              * If the data will be read, copy it into temp.
@@ -2995,6 +3019,7 @@ npyiter_allocate_arrays(MpyIter *iter,
              */
             if (op_itflags[iop] & NPY_OP_ITFLAG_READ) {
                 if (PyMicArray_CopyInto(temp, op[iop]) != 0) {
+                    mpy_residency_unpin(temp);
                     Py_DECREF(temp);
                     return 0;
                 }
@@ -3004,11 +3029,13 @@ npyiter_allocate_arrays(MpyIter *iter,
                 Py_INCREF(op[iop]);
                 if (PyArray_SetUpdateIfCopyBase((PyArrayObject *)temp,
                             (PyArrayObject *)op[iop]) < 0) {
+                    mpy_residency_unpin(temp);
                     Py_DECREF(temp);
                     return 0;
                 }
             }
 
+            mpy_residency_unpin(op[iop]);
             Py_DECREF(op[iop]);
             op[iop] = temp;
 
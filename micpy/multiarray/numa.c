@@ -0,0 +1,229 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_API_VERSION
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL MICPY_ARRAY_API
+#include <numpy/arrayobject.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#define _MICARRAYMODULE
+#include "common.h"
+#include "numa.h"
+
+/* largest node and cpu numbers read from sysfs */
+#define MPY_NUMA_MAXNODE 1024
+#define MPY_NUMA_MAXCPU 1024
+
+/* from linux/mempolicy.h */
+#define MPY_MPOL_PREFERRED 1
+#define MPY_MPOL_MF_MOVE (1 << 1)
+
+#define MPY_NUMA_LONG_BITS (8 * sizeof(unsigned long))
+
+static int numa_ndevices = 0;
+static int numa_nodes[NMAXDEVICES];
+
+/* set when the nodes were found, otherwise there is no binding at all */
+static int numa_bound = 0;
+#ifdef __linux__
+static cpu_set_t numa_cpus[NMAXDEVICES];
+#endif
+
+/*
+ * Read a sysfs list such as "0-3,8-11" from path, marking its members
+ * in set[0..n). Returns the number of members, or -1 if path cannot be
+ * read.
+ */
+static int
+_read_list(const char *path, char *set, int n)
+{
+    char buf[4096], *p, *end;
+    FILE *f;
+    int count = 0;
+
+    memset(set, 0, n);
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    if (fgets(buf, sizeof(buf), f) == NULL) {
+        buf[0] = '\0';
+    }
+    fclose(f);
+
+    p = buf;
+    while (*p >= '0' && *p <= '9') {
+        long lo, hi, i;
+
+        lo = hi = strtol(p, &end, 10);
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (i = lo; i <= hi && i < n; i++) {
+            if (!set[i]) {
+                set[i] = 1;
+                count++;
+            }
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return count;
+}
+
+NPY_NO_EXPORT int
+mpy_numa_init(void)
+{
+    const char *env = getenv("MICPY_HOST_NUMA");
+#ifdef __linux__
+    char nodes[MPY_NUMA_MAXNODE], cpus[MPY_NUMA_MAXCPU];
+    cpu_set_t allowed;
+    int node, cpu;
+#endif
+
+    if (env != NULL && strcmp(env, "0") == 0) {
+        return 0;
+    }
+
+#ifdef __linux__
+    /*
+     * Only the cores the process may run on count, so that taskset and
+     * cgroup limits are kept. Nodes left without cores, such as memory
+     * only nodes, are skipped since they cannot run the kernels.
+     */
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0 &&
+            _read_list("/sys/devices/system/node/online",
+                       nodes, MPY_NUMA_MAXNODE) > 0) {
+        for (node = 0; node < MPY_NUMA_MAXNODE &&
+                       numa_ndevices < NMAXDEVICES; node++) {
+            char path[64];
+            cpu_set_t *mask = &numa_cpus[numa_ndevices];
+
+            if (!nodes[node]) {
+                continue;
+            }
+            PyOS_snprintf(path, sizeof(path),
+                          "/sys/devices/system/node/node%d/cpulist", node);
+            if (_read_list(path, cpus, MPY_NUMA_MAXCPU) <= 0) {
+                continue;
+            }
+            CPU_ZERO(mask);
+            for (cpu = 0; cpu < MPY_NUMA_MAXCPU && cpu < CPU_SETSIZE; cpu++) {
+                if (cpus[cpu] && CPU_ISSET(cpu, &allowed)) {
+                    CPU_SET(cpu, mask);
+                }
+            }
+            if (CPU_COUNT(mask) > 0) {
+                numa_nodes[numa_ndevices++] = node;
+            }
+        }
+        numa_bound = numa_ndevices > 0;
+    }
+#endif
+
+    /* no topology information: the whole host is one device */
+    if (numa_ndevices == 0) {
+        numa_nodes[0] = 0;
+        numa_ndevices = 1;
+    }
+    return numa_ndevices;
+}
+
+NPY_NO_EXPORT int
+mpy_numa_enabled(void)
+{
+    return numa_ndevices > 0;
+}
+
+NPY_NO_EXPORT int
+mpy_numa_node(int device)
+{
+    return numa_nodes[device];
+}
+
+NPY_NO_EXPORT void *
+mpy_numa_alloc(size_t size, int device)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    void *ptr = NULL;
+    size_t len;
+
+    /*
+     * Blocks smaller than a page share their pages with other ones and
+     * cannot be bound; they land on the node of the thread touching them
+     * first, which is the pinned thread of the device.
+     */
+    if (!numa_bound || page <= 0 || size < (size_t)page) {
+        return malloc(size);
+    }
+
+    len = (size + page - 1) / page * page;
+    if (posix_memalign(&ptr, page, len) != 0) {
+        return NULL;
+    }
+#if defined(__linux__) && defined(SYS_mbind)
+    {
+        unsigned long mask[MPY_NUMA_MAXNODE / MPY_NUMA_LONG_BITS];
+        int node = numa_nodes[device];
+
+        memset(mask, 0, sizeof(mask));
+        mask[node / MPY_NUMA_LONG_BITS] |= 1UL << (node % MPY_NUMA_LONG_BITS);
+        /*
+         * Preferred rather than bound, so that a full node spills to the
+         * others instead of failing. If the call itself fails the pages
+         * are still placed by first touch.
+         */
+        syscall(SYS_mbind, ptr, (unsigned long)len, MPY_MPOL_PREFERRED,
+                mask, (unsigned long)MPY_NUMA_MAXNODE + 1, MPY_MPOL_MF_MOVE);
+    }
+#endif
+    return ptr;
+}
+
+/* node the workers of the team of this thread are pinned to, and how many */
+static NPY_TLS int team_device = -1;
+static NPY_TLS int team_size = 0;
+
+NPY_NO_EXPORT void
+PyMicArray_BindTeam(int device)
+{
+#ifdef __linux__
+    int nthreads;
+
+    if (!numa_bound || device < 0 || device >= numa_ndevices) {
+        return;
+    }
+    nthreads = omp_get_max_threads();
+    if (device == team_device && nthreads <= team_size) {
+        return;
+    }
+    /*
+     * The workers are kept from one parallel region to the next, so they
+     * keep the mask until a launch on another node. The calling thread,
+     * which may be any Python thread, keeps its own.
+     * OMP_PROC_BIND or KMP_AFFINITY override this.
+     */
+    {
+        cpu_set_t *mask = &numa_cpus[device];
+
+        #pragma omp parallel num_threads(nthreads)
+        if (omp_get_thread_num() != 0) {
+            sched_setaffinity(0, sizeof(cpu_set_t), mask);
+        }
+    }
+    team_device = device;
+    team_size = nthreads;
+#endif
+}
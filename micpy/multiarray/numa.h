@@ -0,0 +1,45 @@
+#ifndef _MPY_NUMA_H_
+#define _MPY_NUMA_H_
+
+/*
+ * Host NUMA nodes as logical devices.
+ *
+ * On a machine without offload devices, micpy device i is NUMA node i of
+ * the host: its arrays are allocated on the memory of that node, and
+ * the OpenMP team running a kernel on it is pinned to the cores of the
+ * node at launch (see PyMicArray_BindTeam). The kernels themselves are
+ * the usual target regions, launched on the initial device (see
+ * mpy_omp_launch in mpy_common.h).
+ *
+ * MICPY_HOST_NUMA=0 turns this off, leaving micpy without devices.
+ */
+
+/*
+ * Look up the NUMA nodes of the host. Returns the number of logical
+ * devices, at most NMAXDEVICES, or 0 if the mode is turned off.
+ * Must be called once, before any other function of this file.
+ */
+NPY_NO_EXPORT int
+mpy_numa_init(void);
+
+/* Whether the devices are host NUMA nodes */
+NPY_NO_EXPORT int
+mpy_numa_enabled(void);
+
+/* NUMA node of a logical device */
+NPY_NO_EXPORT int
+mpy_numa_node(int device);
+
+/*
+ * Allocate size bytes of host memory bound to the node of device.
+ * The memory is released with free.
+ */
+NPY_NO_EXPORT void *
+mpy_numa_alloc(size_t size, int device);
+
+/*
+ * PyMicArray_BindTeam, which pins the team of a kernel to the node of
+ * its device, is declared in common.h.
+ */
+
+#endif
@@ -0,0 +1,128 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_API_VERSION
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL MICPY_ARRAY_API
+#include <numpy/arrayobject.h>
+
+#include <stdlib.h>
+
+#include "ptrmap.h"
+
+#define PTRMAP_MIN_SIZE 64
+
+static NPY_INLINE npy_intp
+_hash(const void *key, npy_intp size)
+{
+    npy_uintp h = (npy_uintp)key;
+
+    /* objects are at least 16 bytes aligned, mix the high bits down */
+    h = (h >> 4) ^ (h >> 17) ^ (h >> 31);
+    return (npy_intp)(h & (npy_uintp)(size - 1));
+}
+
+static npy_intp
+_find(MpyPtrMap *map, const void *key)
+{
+    npy_intp i;
+
+    if (map->size == 0) {
+        return -1;
+    }
+    for (i = _hash(key, map->size); map->slots[i].key != NULL;
+                                    i = (i + 1) & (map->size - 1)) {
+        if (map->slots[i].key == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void
+_insert(MpyPtrMapSlot *slots, npy_intp size, const void *key, void *value)
+{
+    npy_intp i = _hash(key, size);
+
+    while (slots[i].key != NULL) {
+        i = (i + 1) & (size - 1);
+    }
+    slots[i].key = (void *)key;
+    slots[i].value = value;
+}
+
+static int
+_grow(MpyPtrMap *map)
+{
+    npy_intp size = map->size ? 2 * map->size : PTRMAP_MIN_SIZE, i;
+    MpyPtrMapSlot *slots = calloc(size, sizeof(MpyPtrMapSlot));
+
+    if (slots == NULL) {
+        return -1;
+    }
+    for (i = 0; i < map->size; ++i) {
+        if (map->slots[i].key != NULL) {
+            _insert(slots, size, map->slots[i].key, map->slots[i].value);
+        }
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->size = size;
+    return 0;
+}
+
+NPY_NO_EXPORT void *
+mpy_ptrmap_get(MpyPtrMap *map, const void *key)
+{
+    npy_intp i;
+
+    if (map->used == 0) {
+        return NULL;
+    }
+    i = _find(map, key);
+    return i < 0 ? NULL : map->slots[i].value;
+}
+
+NPY_NO_EXPORT int
+mpy_ptrmap_set(MpyPtrMap *map, const void *key, void *value)
+{
+    npy_intp i = _find(map, key);
+
+    if (i >= 0) {
+        map->slots[i].value = value;
+        return 0;
+    }
+    /* keep at least half of the slots free */
+    if (2 * (map->used + 1) > map->size && _grow(map) < 0) {
+        return -1;
+    }
+    _insert(map->slots, map->size, key, value);
+    map->used++;
+    return 0;
+}
+
+NPY_NO_EXPORT void *
+mpy_ptrmap_pop(MpyPtrMap *map, const void *key)
+{
+    npy_intp i = map->used ? _find(map, key) : -1, j, k;
+    npy_intp mask = map->size - 1;
+    void *value;
+
+    if (i < 0) {
+        return NULL;
+    }
+    value = map->slots[i].value;
+    map->slots[i].key = NULL;
+    map->used--;
+
+    /* move back the entries of the run after i that belong before it */
+    for (j = (i + 1) & mask; map->slots[j].key != NULL; j = (j + 1) & mask) {
+        k = _hash(map->slots[j].key, map->size);
+        if (((j - k) & mask) >= ((j - i) & mask)) {
+            map->slots[i] = map->slots[j];
+            map->slots[j].key = NULL;
+            i = j;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,39 @@
+#ifndef _MPY_PTRMAP_H_
+#define _MPY_PTRMAP_H_
+
+/*
+ * Small hash map from pointers to pointers, to attach data to arrays
+ * without adding fields to PyMicArrayObject. Open addressing with linear
+ * probing; the caller does the locking.
+ */
+
+typedef struct {
+    void *key;
+    void *value;
+} MpyPtrMapSlot;
+
+typedef struct {
+    /* number of slots, a power of two, 0 before the first insertion */
+    npy_intp size;
+    npy_intp used;
+    MpyPtrMapSlot *slots;
+} MpyPtrMap;
+
+#define MPY_PTRMAP_INIT {0, 0, NULL}
+
+/* The value of key, NULL if it has none */
+NPY_NO_EXPORT void *
+mpy_ptrmap_get(MpyPtrMap *map, const void *key);
+
+/*
+ * Set the value of key, which must not be NULL, nor value.
+ * Returns 0 on success, -1 if out of memory (no exception set).
+ */
+NPY_NO_EXPORT int
+mpy_ptrmap_set(MpyPtrMap *map, const void *key, void *value);
+
+/* Remove key, returns its value or NULL if it had none */
+NPY_NO_EXPORT void *
+mpy_ptrmap_pop(MpyPtrMap *map, const void *key);
+
+#endif
@@ -0,0 +1,598 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+
+#define NPY_NO_DEPRECATED_API NPY_API_VERSION
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL MICPY_ARRAY_API
+#include <numpy/arrayobject.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define _MICARRAYMODULE
+#include "common.h"
+#include "alloc.h"
+#include "residency.h"
+#include "ptrmap.h"
+
+/* alignment of the host copies of evicted arrays */
+#define MPY_RESIDENCY_HOST_ALIGN 4096
+
+struct MpyResident {
+    /* the array owning the data, NULL once it dropped it */
+    PyMicArrayObject *arr;
+    int device;
+    /* host copy of the data while evicted */
+    void *host;
+    npy_intp nbytes;
+    /* views, exports, iterators and operations using the data */
+    int pins;
+    /* pins taken by ndarray.pin_resident, part of pins */
+    int user_pins;
+    /* whether the data pointer was exported, which holds one pin */
+    int exported;
+    /* LRU list of the device, oldest first; evicted arrays are not in it */
+    MpyResident *prev, *next;
+};
+
+typedef struct {
+    MpyResident *head, *tail;
+} resident_list;
+
+static int residency_on = -1;
+static resident_list lru[NMAXDEVICES];
+static MpyResidencyStats residency_stats;
+
+/*
+ * Entry of each tracked array: the owner of the data and its views, which
+ * hold a pin on the entry of the owner.
+ */
+static MpyPtrMap residents = MPY_PTRMAP_INIT;
+
+/*
+ * Unpins come without the GIL too, from DLPack deleters, so the table
+ * and the lists have their own lock. It is created the first time the
+ * manager is turned on, and every tracked array comes after that: until
+ * then there is nothing to look up.
+ */
+static PyThread_type_lock residency_lock = NULL;
+
+#define RESIDENCY_LOCK() PyThread_acquire_lock(residency_lock, WAIT_LOCK)
+#define RESIDENCY_UNLOCK() PyThread_release_lock(residency_lock)
+
+static void
+_unlink(MpyResident *r)
+{
+    resident_list *list = &lru[r->device];
+
+    if (r->prev) {
+        r->prev->next = r->next;
+    }
+    else {
+        list->head = r->next;
+    }
+    if (r->next) {
+        r->next->prev = r->prev;
+    }
+    else {
+        list->tail = r->prev;
+    }
+    r->prev = r->next = NULL;
+}
+
+static void
+_append(MpyResident *r)
+{
+    resident_list *list = &lru[r->device];
+
+    r->prev = list->tail;
+    r->next = NULL;
+    if (list->tail) {
+        list->tail->next = r;
+    }
+    else {
+        list->head = r;
+    }
+    list->tail = r;
+}
+
+/* Make r the most recently used array of its device. Lock held. */
+static void
+_use_locked(MpyResident *r)
+{
+    if (r->arr != NULL && r->arr->data != NULL && r != lru[r->device].tail) {
+        _unlink(r);
+        _append(r);
+    }
+}
+
+/* Move the data of r to the host. Lock held. */
+static int
+_evict_locked(MpyResident *r)
+{
+    PyMicArrayObject *arr = r->arr;
+    npy_intp nbytes = PyMicArray_NBYTES(arr);
+    void *host = NULL;
+
+    if (posix_memalign(&host, MPY_RESIDENCY_HOST_ALIGN, nbytes) != 0) {
+        return -1;
+    }
+    if (target_memcpy(host, arr->data, nbytes, CPU_DEVICE, r->device) != 0) {
+        free(host);
+        return -1;
+    }
+    PyDataMemMic_FREE(arr->data, r->device);
+    arr->data = NULL;
+    /*
+     * Only the data are kept, not the room resize left after them. Done
+     * here as the fetch may run without the GIL, which guards the table.
+     */
+    mpy_array_set_capacity(arr, 0);
+    r->host = host;
+    r->nbytes = nbytes;
+    _unlink(r);
+
+    residency_stats.evictions++;
+    residency_stats.evicted_bytes += nbytes;
+    residency_stats.resident--;
+    residency_stats.on_host++;
+    return 0;
+}
+
+/*
+ * Evict the least recently used array of device that is not pinned.
+ * Lock and GIL held.
+ */
+static int
+_evict_lru_locked(int device)
+{
+    MpyResident *r;
+
+    if (device < 0 || device >= NMAXDEVICES) {
+        return -1;
+    }
+    for (r = lru[device].head; r != NULL; r = r->next) {
+        if (r->pins == 0 && _evict_locked(r) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Bring the data of r back to its device, evicting others to make room
+ * if may_evict, which needs the GIL. Lock held.
+ */
+static int
+_fetch_locked(MpyResident *r, int may_evict)
+{
+    PyMicArrayObject *arr = r->arr;
+    void *data;
+
+    while ((data = mpy_device_alloc(r->nbytes, r->device)) == NULL) {
+        if (!may_evict || _evict_lru_locked(r->device) < 0) {
+            return -1;
+        }
+    }
+    if (target_memcpy(data, r->host, r->nbytes, r->device, CPU_DEVICE) != 0) {
+        PyDataMemMic_FREE(data, r->device);
+        return -1;
+    }
+    free(r->host);
+    r->host = NULL;
+    arr->data = data;
+    _append(r);
+
+    residency_stats.fetches++;
+    residency_stats.fetched_bytes += r->nbytes;
+    residency_stats.on_host--;
+    residency_stats.resident++;
+    return 0;
+}
+
+/* Entry of arr, NULL if it is not tracked. Lock held. */
+static NPY_INLINE MpyResident *
+_lookup_locked(PyMicArrayObject *arr)
+{
+    return (MpyResident *)mpy_ptrmap_get(&residents, arr);
+}
+
+static void
+_drop_pin_locked(MpyResident *r)
+{
+    if (--r->pins == 0 && r->arr == NULL) {
+        free(r);
+    }
+}
+
+NPY_NO_EXPORT int
+mpy_residency_enabled(void)
+{
+    if (residency_on < 0) {
+        const char *env = getenv("MICPY_RESIDENCY");
+
+        residency_on = 0;
+        if (env != NULL && env[0] != '\0' && strcmp(env, "0") != 0) {
+            if (mpy_residency_enable(1) < 0) {
+                PyErr_Clear();
+            }
+        }
+    }
+    return residency_on;
+}
+
+NPY_NO_EXPORT int
+mpy_residency_enable(int enabled)
+{
+    int previous = mpy_residency_enabled();
+
+    if (enabled && residency_lock == NULL) {
+        residency_lock = PyThread_allocate_lock();
+        if (residency_lock == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
+    residency_on = enabled != 0;
+    return previous;
+}
+
+NPY_NO_EXPORT void
+mpy_residency_track(PyMicArrayObject *arr, npy_intp nbytes)
+{
+    MpyResident *r;
+
+    if (nbytes < MPY_RESIDENCY_MIN_BYTES ||
+            arr->device < 0 || arr->device >= NMAXDEVICES) {
+        return;
+    }
+    /* an untracked array is only never evicted */
+    r = calloc(1, sizeof(MpyResident));
+    if (r == NULL) {
+        return;
+    }
+    r->arr = arr;
+    r->device = arr->device;
+
+    RESIDENCY_LOCK();
+    if (mpy_ptrmap_set(&residents, arr, r) < 0) {
+        free(r);
+    }
+    else {
+        _append(r);
+        residency_stats.resident++;
+    }
+    RESIDENCY_UNLOCK();
+}
+
+NPY_NO_EXPORT void
+mpy_residency_set_base(PyMicArrayObject *arr)
+{
+    PyObject *base = PyMicArray_BASE(arr);
+    MpyResident *r;
+
+    if (residency_lock == NULL || base == NULL || !PyMicArray_Check(base)) {
+        return;
+    }
+    RESIDENCY_LOCK();
+    /* the base is the owner or a view of it, both map to its entry */
+    r = _lookup_locked((PyMicArrayObject *)base);
+    if (r != NULL && _lookup_locked(arr) == NULL) {
+        /*
+         * Without its own entry the view could not give the pin back;
+         * the data then stay on the device for good, which is safe.
+         */
+        r->pins++;
+        mpy_ptrmap_set(&residents, arr, r);
+    }
+    RESIDENCY_UNLOCK();
+}
+
+NPY_NO_EXPORT int
+mpy_residency_pin(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+    int ret = 0;
+
+    if (arr == NULL || residency_lock == NULL) {
+        return 0;
+    }
+    RESIDENCY_LOCK();
+    r = _lookup_locked(arr);
+    if (r != NULL) {
+        r->pins++;
+        if (r->arr != NULL && r->arr->data == NULL) {
+            if (_fetch_locked(r, 1) < 0) {
+                _drop_pin_locked(r);
+                ret = -1;
+            }
+        }
+        else {
+            _use_locked(r);
+        }
+    }
+    RESIDENCY_UNLOCK();
+    if (ret < 0) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "cannot bring an evicted array back to its device");
+    }
+    return ret;
+}
+
+NPY_NO_EXPORT void
+mpy_residency_unpin(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+
+    if (arr == NULL || residency_lock == NULL) {
+        return;
+    }
+    RESIDENCY_LOCK();
+    r = _lookup_locked(arr);
+    if (r != NULL) {
+        _drop_pin_locked(r);
+    }
+    RESIDENCY_UNLOCK();
+}
+
+NPY_NO_EXPORT int
+mpy_residency_pin_all(PyMicArrayObject **arrs, int n)
+{
+    int i;
+
+    for (i = 0; i < n; ++i) {
+        if (mpy_residency_pin(arrs[i]) < 0) {
+            mpy_residency_unpin_all(arrs, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+NPY_NO_EXPORT void
+mpy_residency_unpin_all(PyMicArrayObject **arrs, int n)
+{
+    int i;
+
+    for (i = 0; i < n; ++i) {
+        mpy_residency_unpin(arrs[i]);
+    }
+}
+
+NPY_NO_EXPORT int
+mpy_residency_export(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+
+    if (mpy_residency_pin(arr) < 0) {
+        return -1;
+    }
+    if (residency_lock != NULL) {
+        RESIDENCY_LOCK();
+        r = _lookup_locked(arr);
+        if (r != NULL) {
+            /* the first export keeps its pin */
+            if (r->exported) {
+                _drop_pin_locked(r);
+            }
+            r->exported = 1;
+        }
+        RESIDENCY_UNLOCK();
+    }
+    return 0;
+}
+
+NPY_NO_EXPORT void
+mpy_residency_release(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+
+    if (residency_lock == NULL) {
+        return;
+    }
+    RESIDENCY_LOCK();
+    r = mpy_ptrmap_pop(&residents, arr);
+    if (r != NULL && r->arr == arr) {
+        if (arr->data != NULL) {
+            _unlink(r);
+            residency_stats.resident--;
+        }
+        else {
+            free(r->host);
+            r->host = NULL;
+            residency_stats.on_host--;
+        }
+        r->arr = NULL;
+        if (r->exported) {
+            r->pins--;
+        }
+        if (r->pins == 0) {
+            free(r);
+        }
+    }
+    else if (r != NULL) {
+        _drop_pin_locked(r);
+    }
+    RESIDENCY_UNLOCK();
+}
+
+NPY_NO_EXPORT int
+mpy_residency_pin_user(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+
+    if (mpy_residency_pin(arr) < 0) {
+        return -1;
+    }
+    if (residency_lock != NULL) {
+        RESIDENCY_LOCK();
+        r = _lookup_locked(arr);
+        if (r != NULL) {
+            r->user_pins++;
+        }
+        RESIDENCY_UNLOCK();
+    }
+    return 0;
+}
+
+NPY_NO_EXPORT int
+mpy_residency_unpin_user(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+    int ret = 0;
+
+    if (residency_lock == NULL) {
+        return 0;
+    }
+    RESIDENCY_LOCK();
+    r = _lookup_locked(arr);
+    if (r != NULL) {
+        if (r->user_pins > 0) {
+            r->user_pins--;
+            _drop_pin_locked(r);
+        }
+        else {
+            ret = -1;
+        }
+    }
+    RESIDENCY_UNLOCK();
+    if (ret < 0) {
+        PyErr_SetString(PyExc_ValueError, "array is not pinned");
+    }
+    return ret;
+}
+
+NPY_NO_EXPORT int
+mpy_residency_fetch(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+    int ret = 0;
+
+    if (residency_lock == NULL) {
+        return 0;
+    }
+    RESIDENCY_LOCK();
+    r = _lookup_locked(arr);
+    if (r == NULL || r->arr == NULL) {
+        RESIDENCY_UNLOCK();
+        return 0;
+    }
+    if (r->arr->data != NULL) {
+        _use_locked(r);
+        RESIDENCY_UNLOCK();
+        return 0;
+    }
+    /* the pin keeps r alive while the lock is dropped */
+    r->pins++;
+    RESIDENCY_UNLOCK();
+
+    /* first without the GIL, which only works if the data fit as is */
+    NPY_BEGIN_ALLOW_THREADS;
+    RESIDENCY_LOCK();
+    if (r->arr != NULL && r->arr->data == NULL) {
+        ret = _fetch_locked(r, 0);
+    }
+    RESIDENCY_UNLOCK();
+    NPY_END_ALLOW_THREADS;
+
+    RESIDENCY_LOCK();
+    if (ret < 0 && r->arr != NULL && r->arr->data == NULL) {
+        ret = _fetch_locked(r, 1);
+    }
+    else {
+        ret = 0;
+        _use_locked(r);
+    }
+    _drop_pin_locked(r);
+    RESIDENCY_UNLOCK();
+    if (ret < 0) {
+        PyErr_SetString(PyExc_MemoryError,
+                        "cannot bring an evicted array back to its device");
+    }
+    return ret;
+}
+
+NPY_NO_EXPORT int
+mpy_residency_evict_array(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+    int ret = 0;
+
+    if (residency_lock == NULL) {
+        return 0;
+    }
+    RESIDENCY_LOCK();
+    r = _lookup_locked(arr);
+    if (r != NULL && r->arr == arr && arr->data != NULL && r->pins == 0) {
+        ret = _evict_locked(r) == 0 ? 1 : -1;
+    }
+    RESIDENCY_UNLOCK();
+    if (ret < 0) {
+        PyErr_NoMemory();
+    }
+    return ret;
+}
+
+NPY_NO_EXPORT int
+mpy_residency_is_resident(PyMicArrayObject *arr)
+{
+    MpyResident *r;
+    int ret;
+
+    if (residency_lock == NULL) {
+        return 1;
+    }
+    RESIDENCY_LOCK();
+    r = _lookup_locked(arr);
+    ret = r == NULL || r->arr == NULL || r->arr->data != NULL;
+    RESIDENCY_UNLOCK();
+    return ret;
+}
+
+NPY_NO_EXPORT int
+mpy_residency_evict(int device)
+{
+    int ret;
+
+    if (residency_on <= 0) {
+        return -1;
+    }
+    RESIDENCY_LOCK();
+    ret = _evict_lru_locked(device);
+    RESIDENCY_UNLOCK();
+    return ret;
+}
+
+NPY_NO_EXPORT void
+mpy_residency_stats(MpyResidencyStats *stats)
+{
+    if (residency_lock == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    RESIDENCY_LOCK();
+    *stats = residency_stats;
+    RESIDENCY_UNLOCK();
+}
+
+/*NUMPY_API
+ * Keep the data of arr on its device until PyMicArray_Unpin, bringing
+ * them back first if the residency manager moved them to the host. Code
+ * outside this module pins the arrays whose data pointer it uses, see
+ * residency.h. Returns 0 on success, -1 with a MemoryError set on failure.
+ */
+NPY_NO_EXPORT int
+PyMicArray_Pin(PyMicArrayObject *arr)
+{
+    return mpy_residency_pin(arr);
+}
+
+/*NUMPY_API
+ * Undo PyMicArray_Pin.
+ */
+NPY_NO_EXPORT void
+PyMicArray_Unpin(PyMicArrayObject *arr)
+{
+    mpy_residency_unpin(arr);
+}
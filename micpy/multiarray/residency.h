@@ -0,0 +1,144 @@
+#ifndef _MPY_RESIDENCY_H_
+#define _MPY_RESIDENCY_H_
+
+/*
+ * Residency manager, for working sets larger than device memory.
+ *
+ * When enabled, the arrays allocated from then on are kept in one LRU
+ * list per device. If a device allocation fails, the least recently used
+ * arrays of the device are copied to host memory and their device memory
+ * released until the allocation succeeds. An evicted array has a NULL
+ * data pointer until it is pinned again.
+ *
+ * The entries live in a table keyed by array, PyMicArrayObject has no
+ * field for them. Two rules make the data pointers safe:
+ *
+ * 1. Arrays are only evicted with the GIL held: by a device allocation,
+ *    by a pin that brings an array back, or by ndarray.evict.
+ *
+ * 2. Code pins every array before reading its data pointer, and keeps the
+ *    pin for as long as it uses the pointer across device allocations or
+ *    with the GIL released: from iterator construction or conversion to
+ *    the release of the operands. Iterators pin their operands; views,
+ *    DLPack and __mic_array_interface__ exports pin the data they share.
+ *    The pin is what brings an evicted array back, PyMicArray_DATA only
+ *    reads the field. An array just allocated needs no pin until the
+ *    next device allocation or release of the GIL.
+ *
+ * Only arrays owning their data are evicted. It is off by default;
+ * MICPY_RESIDENCY=1 turns it on from the start.
+ */
+
+/* arrays smaller than this are not tracked */
+#define MPY_RESIDENCY_MIN_BYTES (64 * 1024)
+
+typedef struct MpyResident MpyResident;
+
+typedef struct {
+    npy_intp evictions;
+    npy_intp fetches;
+    npy_intp evicted_bytes;
+    npy_intp fetched_bytes;
+    /* arrays tracked on the devices, and currently on the host */
+    npy_intp resident;
+    npy_intp on_host;
+} MpyResidencyStats;
+
+NPY_NO_EXPORT int
+mpy_residency_enabled(void);
+
+/* Turn the manager on or off, returns the previous state or -1 on error */
+NPY_NO_EXPORT int
+mpy_residency_enable(int enabled);
+
+/* Start tracking arr, which has just allocated nbytes of data */
+NPY_NO_EXPORT void
+mpy_residency_track(PyMicArrayObject *arr, npy_intp nbytes);
+
+/* arr now has a base; if it shares the data of a tracked array, pin it */
+NPY_NO_EXPORT void
+mpy_residency_set_base(PyMicArrayObject *arr);
+
+/*
+ * Keep the data of arr, or of the array it is a view of, on the device
+ * until the matching unpin, and mark them as the most recently used.
+ * Brings them back first if they were evicted. arr may be NULL.
+ * Returns 0 on success, -1 with a MemoryError set on failure.
+ */
+NPY_NO_EXPORT int
+mpy_residency_pin(PyMicArrayObject *arr);
+
+NPY_NO_EXPORT void
+mpy_residency_unpin(PyMicArrayObject *arr);
+
+/*
+ * Pin the n arrays of arrs, NULL entries are skipped. On failure none
+ * stays pinned.
+ */
+NPY_NO_EXPORT int
+mpy_residency_pin_all(PyMicArrayObject **arrs, int n);
+
+NPY_NO_EXPORT void
+mpy_residency_unpin_all(PyMicArrayObject **arrs, int n);
+
+/*
+ * The data pointer of arr is handed out with no end of use, as by
+ * __mic_array_interface__: pin the data until their owner goes away.
+ */
+NPY_NO_EXPORT int
+mpy_residency_export(PyMicArrayObject *arr);
+
+/*
+ * Pins asked for by the user, with ndarray.pin_resident and
+ * ndarray.unpin_resident. Unpinning an array that is not pinned is a
+ * ValueError.
+ */
+NPY_NO_EXPORT int
+mpy_residency_pin_user(PyMicArrayObject *arr);
+
+NPY_NO_EXPORT int
+mpy_residency_unpin_user(PyMicArrayObject *arr);
+
+/*
+ * Bring arr back to its device if it was evicted, and mark it as the most
+ * recently used. The copy runs with the GIL released if the data fit
+ * without evicting others. Returns 0 on success, -1 with a MemoryError
+ * set on failure.
+ */
+NPY_NO_EXPORT int
+mpy_residency_fetch(PyMicArrayObject *arr);
+
+/*
+ * Evict arr now. Returns 1 if it was, 0 if it cannot be (it is not
+ * tracked, already evicted, or pinned) and -1 with an exception set on
+ * failure.
+ */
+NPY_NO_EXPORT int
+mpy_residency_evict_array(PyMicArrayObject *arr);
+
+/* Whether the data of arr are on its device */
+NPY_NO_EXPORT int
+mpy_residency_is_resident(PyMicArrayObject *arr);
+
+/* arr goes away or drops its data: stop tracking it */
+NPY_NO_EXPORT void
+mpy_residency_release(PyMicArrayObject *arr);
+
+/*
+ * Evict the least recently used array of device that is not pinned.
+ * Returns 0 if one was, -1 otherwise. The GIL must be held.
+ */
+NPY_NO_EXPORT int
+mpy_residency_evict(int device);
+
+NPY_NO_EXPORT void
+mpy_residency_stats(MpyResidencyStats *stats);
+
+/* mpy_residency_pin and unpin, for the other modules */
+NPY_NO_EXPORT int
+PyMicArray_Pin(PyMicArrayObject *arr);
+
+NPY_NO_EXPORT void
+PyMicArray_Unpin(PyMicArrayObject *arr);
+
+#endif
@@ -160,7 +160,7 @@ PyMicArray_ToScalar(void *data, PyMicArrayObject *obj)
     char host_data[elsize];
 
     /* Transfer scalar from device to host */
-    if (omp_target_memcpy(host_data, data, elsize, 0, 0,
+    if (target_memcpy(host_data, data, elsize,
                 CPU_DEVICE, PyMicArray_DEVICE(obj)) != 0) {
         return NULL;
     }
@@ -168,9 +168,25 @@ PyMicArray_ToScalar(void *data, PyMicArrayObject *obj)
     return PyArray_Scalar(host_data, descr, NULL);
 }
 
+/*
+ * Whether 0-d results stay on the device, per thread like the current
+ * device. See mpy_set_device_scalars.
+ */
+static NPY_TLS int device_scalars = 0;
+
+NPY_NO_EXPORT int
+mpy_set_device_scalars(int enabled)
+{
+    int previous = device_scalars;
+
+    device_scalars = enabled != 0;
+    return previous;
+}
+
  /*
  * Return either an array or the appropriate Python object if the array
- * is 0d and matches a Python type.
+ * is 0d and matches a Python type. With device scalars on, 0-d arrays
+ * are returned as they are.
  * steals reference to mp
  */
 NPY_NO_EXPORT PyObject *
@@ -187,7 +203,7 @@ PyMicArray_Return(PyMicArrayObject *mp)
     if (!PyMicArray_Check(mp)) {
         return (PyObject *)mp;
     }
-    if (PyMicArray_NDIM(mp) == 0) {
+    if (PyMicArray_NDIM(mp) == 0 && !device_scalars) {
         PyObject *ret;
         ret = PyMicArray_ToScalar(PyMicArray_DATA(mp), mp);
         Py_DECREF(mp);
@@ -4,6 +4,15 @@
 NPY_NO_EXPORT void *
 scalar_value(PyObject *scalar, PyArray_Descr *descr);
 
+/*
+ * Keep the 0-d results of reductions, dot and the like on the device for
+ * the calling thread, instead of reading them back as scalars. They are
+ * only read when converted with float(), int(), bool() or used as an
+ * index. Returns the previous setting.
+ */
+NPY_NO_EXPORT int
+mpy_set_device_scalars(int enabled);
+
 NPY_NO_EXPORT PyObject *
 PyMicArray_Return(PyMicArrayObject *mp);
 
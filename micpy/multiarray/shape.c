@@ -19,6 +19,7 @@
 #include "creators.h"
 #include "shape.h"
 #include "convert.h"
+#include "residency.h"
 
 #include "templ_common.h" /* for npy_mul_with_overflow_intp */
 #include "common.h" /* for convert_shape_to_string */
@@ -48,7 +49,7 @@ PyMicArray_Resize(PyMicArrayObject *self, PyArray_Dims *newshape, int refcheck,
     int refcnt;
     npy_intp* new_dimensions=newshape->ptr;
     npy_intp new_strides[NPY_MAXDIMS];
-    size_t sd;
+    size_t sd, capacity, oldcapacity;
     npy_intp *dimptr;
     char *new_data;
     npy_intp largest;
@@ -119,15 +120,40 @@ PyMicArray_Resize(PyMicArrayObject *self, PyArray_Dims *newshape, int refcheck,
         else {
             sd = newsize*PyMicArray_DESCR(self)->elsize;
         }
-        /* Reallocate space if needed */
-        new_data = PyDataMemMic_RENEW(PyMicArray_DATA(self), sd,
-                                        PyMicArray_DEVICE(self));
-        if (new_data == NULL) {
-            PyErr_SetString(PyExc_MemoryError,
-                    "cannot allocate memory for array");
-            return NULL;
+        oldcapacity = PyMicArray_CAPACITY(self);
+        if (oldcapacity < (size_t)PyMicArray_DESCR(self)->elsize) {
+            /* an empty array still has one element allocated */
+            oldcapacity = PyMicArray_DESCR(self)->elsize;
         }
-        ((PyMicArrayObject *)self)->data = new_data;
+        capacity = oldcapacity;
+
+        /*
+         * Reallocate space if needed. Arrays grown a little at a time
+         * are append buffers: their capacity doubles so that n appends
+         * cost O(n) copying. The room is given back once less than a
+         * quarter of it is used.
+         */
+        if (sd > oldcapacity || sd < oldcapacity / 4) {
+            capacity = sd;
+            if (sd > oldcapacity && sd < 2 * oldcapacity) {
+                capacity = 2 * oldcapacity;
+            }
+            /* keep the data on the device while the new block is made */
+            if (mpy_residency_pin(self) < 0) {
+                return NULL;
+            }
+            new_data = PyDataMemMic_RENEW(PyMicArray_DATA(self),
+                                    oldsize * PyMicArray_DESCR(self)->elsize,
+                                    capacity, PyMicArray_DEVICE(self));
+            mpy_residency_unpin(self);
+            if (new_data == NULL) {
+                PyErr_SetString(PyExc_MemoryError,
+                        "cannot allocate memory for array");
+                return NULL;
+            }
+            ((PyMicArrayObject *)self)->data = new_data;
+        }
+        mpy_array_set_capacity(self, capacity == sd ? 0 : capacity);
     }
 
     if ((newsize > oldsize) && PyMicArray_ISWRITEABLE(self)) {
@@ -148,8 +174,10 @@ PyMicArray_Resize(PyMicArrayObject *self, PyArray_Dims *newshape, int refcheck,
         else{
             void *addr = (void *) PyMicArray_BYTES(self) + oldsize * elsize;
             npy_intp fill_size = (newsize - oldsize) * elsize;
-            #pragma omp target device(self->device) map(to:addr,fill_size)
-            memset(addr, 0, fill_size);
+
+            NPY_BEGIN_ALLOW_THREADS;
+            mpy_device_zero(addr, fill_size, PyMicArray_DEVICE(self));
+            NPY_END_ALLOW_THREADS;
         }
     }
 
@@ -270,6 +298,9 @@ PyMicArray_Newshape(PyMicArrayObject *self, PyArray_Dims *newdims,
         }
     }
 
+    if (mpy_residency_pin(self) < 0) {
+        goto fail;
+    }
     Py_INCREF(PyMicArray_DESCR(self));
     ret = (PyMicArrayObject *)PyMicArray_NewFromDescr_int(
                                        PyMicArray_DEVICE(self),
@@ -279,6 +310,8 @@ PyMicArray_Newshape(PyMicArrayObject *self, PyArray_Dims *newdims,
                                        strides,
                                        PyMicArray_DATA(self),
                                        flags, (PyObject *)self, 0, 1);
+    /* from here the base pins self for the view */
+    mpy_residency_unpin(self);
 
     if (ret == NULL) {
         goto fail;
@@ -729,6 +762,9 @@ PyMicArray_Transpose(PyMicArrayObject *ap, PyArray_Dims *permute)
      * this allocates memory for dimensions and strides (but fills them
      * incorrectly), sets up descr, and points data at PyArray_DATA(ap).
      */
+    if (mpy_residency_pin(ap) < 0) {
+        return NULL;
+    }
     Py_INCREF(PyMicArray_DESCR(ap));
     ret = (PyMicArrayObject *)
         PyMicArray_NewFromDescr(PyMicArray_DEVICE(ap),
@@ -738,6 +774,8 @@ PyMicArray_Transpose(PyMicArrayObject *ap, PyArray_Dims *permute)
                              NULL, PyMicArray_DATA(ap),
                              flags,
                              (PyObject *)ap);
+    /* from here the base pins ap for the view */
+    mpy_residency_unpin(ap);
     if (ret == NULL) {
         return NULL;
     }
@@ -852,6 +890,9 @@ PyMicArray_Ravel(PyMicArrayObject *arr, NPY_ORDER order)
             stride = PyMicArray_ITEMSIZE(arr);
             val[0] = PyMicArray_SIZE(arr);
 
+            if (mpy_residency_pin(arr) < 0) {
+                return NULL;
+            }
             Py_INCREF(PyMicArray_DESCR(arr));
             ret = (PyMicArrayObject *)PyMicArray_NewFromDescr(
                                PyMicArray_DEVICE(arr),
@@ -862,6 +903,8 @@ PyMicArray_Ravel(PyMicArrayObject *arr, NPY_ORDER order)
                                PyMicArray_BYTES(arr),
                                PyMicArray_FLAGS(arr),
                                (PyObject *)arr);
+            /* from here the base pins arr for the view */
+            mpy_residency_unpin(arr);
             if (ret == NULL) {
                 return NULL;
             }
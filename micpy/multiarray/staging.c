@@ -0,0 +1,707 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_API_VERSION
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL MICPY_ARRAY_API
+#include <numpy/arrayobject.h>
+#include <numpy/npy_3kcompat.h>
+
+#include "npy_config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define _MICARRAYMODULE
+#include "common.h"
+#include "arrayobject.h"
+#include "mpy_lowlevel_strided_loops.h"
+#include "dtype_transfer.h"
+#include "staging.h"
+#include "alloc.h"
+
+/*
+ * The two staging buffers are allocated once and reused by every
+ * transfer. A transfer that finds them busy (another thread is in the
+ * middle of one with the GIL released) allocates its own pair.
+ */
+static char *staging_buffers[2] = {NULL, NULL};
+static int staging_in_use = 0;
+
+static void
+_free_staging(char **bufs)
+{
+    free(bufs[0]);
+    free(bufs[1]);
+    bufs[0] = bufs[1] = NULL;
+}
+
+static int
+_alloc_staging(char **bufs)
+{
+    bufs[0] = bufs[1] = NULL;
+    if (posix_memalign((void **)&bufs[0], MPY_STAGING_ALIGN,
+                       MPY_STAGING_CHUNK) != 0 ||
+            posix_memalign((void **)&bufs[1], MPY_STAGING_ALIGN,
+                           MPY_STAGING_CHUNK) != 0) {
+        _free_staging(bufs);
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Get a pair of staging buffers. Returns 1 if the shared pair was
+ * handed out, 0 for a private pair and -1 on failure.
+ * Must be called with the GIL held.
+ */
+static int
+_acquire_staging(char **bufs)
+{
+    if (!staging_in_use) {
+        if (staging_buffers[0] == NULL &&
+                _alloc_staging(staging_buffers) < 0) {
+            return -1;
+        }
+        staging_in_use = 1;
+        bufs[0] = staging_buffers[0];
+        bufs[1] = staging_buffers[1];
+        return 1;
+    }
+    return _alloc_staging(bufs) < 0 ? -1 : 0;
+}
+
+static void
+_release_staging(char **bufs, int shared)
+{
+    if (shared) {
+        staging_in_use = 0;
+    }
+    else {
+        _free_staging(bufs);
+    }
+}
+
+/*
+ * Read up to len bytes at pos, retrying short reads.
+ * Returns the number of bytes read, or -1 with errno set.
+ */
+static npy_intp
+_pread_full(int fd, char *buf, npy_intp len, npy_off_t pos)
+{
+    npy_intp done = 0;
+
+    while (done < len) {
+        ssize_t r = pread(fd, buf + done, len - done, pos + done);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (r == 0) {
+            break;
+        }
+        done += r;
+    }
+    return done;
+}
+
+/*
+ * Write len bytes at pos, retrying short writes.
+ * Returns 0, or -1 with errno set.
+ */
+static int
+_pwrite_full(int fd, const char *buf, npy_intp len, npy_off_t pos)
+{
+    npy_intp done = 0;
+
+    while (done < len) {
+        ssize_t r = pwrite(fd, buf + done, len - done, pos + done);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += r;
+    }
+    return 0;
+}
+
+/*
+ * Copy path chosen for each pair of devices, indexed [src][dst].
+ * Written with the GIL held.
+ */
+static MpyPeerMode peer_mode[NMAXDEVICES][NMAXDEVICES];
+static int peer_mode_forced = -1;
+
+static NPY_TLS MpyPeerStats peer_last_stats;
+
+static MpyPeerMode
+_get_peer_mode(int src_device, int dst_device)
+{
+    if (peer_mode_forced < 0) {
+        const char *env = getenv("MICPY_PEER_COPY");
+
+        peer_mode_forced = MPY_PEER_AUTO;
+        if (env != NULL && strcmp(env, "direct") == 0) {
+            peer_mode_forced = MPY_PEER_DIRECT;
+        }
+        else if (env != NULL && strcmp(env, "staged") == 0) {
+            peer_mode_forced = MPY_PEER_STAGED;
+        }
+    }
+    if (peer_mode_forced != MPY_PEER_AUTO) {
+        return (MpyPeerMode)peer_mode_forced;
+    }
+    if (src_device < 0 || src_device >= NMAXDEVICES ||
+            dst_device < 0 || dst_device >= NMAXDEVICES) {
+        return MPY_PEER_DIRECT;
+    }
+    return peer_mode[src_device][dst_device];
+}
+
+/*
+ * Copy through the staging buffers, overlapping the copy of chunk k to
+ * dst with the copy of chunk k+1 from src. Runs without the GIL.
+ * Returns 0 or -1.
+ */
+static int
+_peer_copy_staged(char *dst, int dst_device, char *src, int src_device,
+                  npy_intp nbytes, char **bufs)
+{
+    npy_intp nchunks = (nbytes + MPY_STAGING_CHUNK - 1) / MPY_STAGING_CHUNK;
+    npy_intp k;
+    int cur = 0, err = 0;
+
+    if (nbytes == 0) {
+        return 0;
+    }
+    if (target_memcpy(bufs[0], src,
+                      nbytes < MPY_STAGING_CHUNK ? nbytes : MPY_STAGING_CHUNK,
+                      CPU_DEVICE, src_device) != 0) {
+        return -1;
+    }
+
+    for (k = 0; k < nchunks && !err; ++k) {
+        npy_intp lo = k * MPY_STAGING_CHUNK;
+        npy_intp len = nbytes - lo < MPY_STAGING_CHUNK ?
+                                    nbytes - lo : MPY_STAGING_CHUNK;
+        int put_err = 0, get_err = 0;
+
+        #pragma omp parallel sections num_threads(2)
+        {
+            #pragma omp section
+            {
+                put_err = target_memcpy(dst + lo, bufs[cur], len,
+                                        dst_device, CPU_DEVICE);
+            }
+            #pragma omp section
+            {
+                npy_intp next = lo + MPY_STAGING_CHUNK;
+                if (next < nbytes) {
+                    get_err = target_memcpy(bufs[1 - cur], src + next,
+                                  nbytes - next < MPY_STAGING_CHUNK ?
+                                        nbytes - next : MPY_STAGING_CHUNK,
+                                  CPU_DEVICE, src_device);
+                }
+            }
+        }
+        err = put_err || get_err;
+        cur = 1 - cur;
+    }
+    return err ? -1 : 0;
+}
+
+NPY_NO_EXPORT int
+mpy_peer_copy(void *dst, int dst_device, void *src, int src_device,
+              npy_intp nbytes)
+{
+    char *bufs[2] = {NULL, NULL};
+    char *d = (char *)dst, *s = (char *)src;
+    MpyPeerMode mode;
+    int shared = -1, err = 0;
+    double start, t_direct = 0, t_staged = 0;
+    npy_intp done = 0;
+
+    if (nbytes == 0) {
+        return 0;
+    }
+
+    /* one end on the host: there is nothing to choose */
+    if (dst_device == CPU_DEVICE || src_device == CPU_DEVICE) {
+        mode = MPY_PEER_DIRECT;
+    }
+    else {
+        mode = _get_peer_mode(src_device, dst_device);
+        if (mode == MPY_PEER_AUTO && nbytes < 2 * MPY_PEER_PROBE) {
+            mode = MPY_PEER_DIRECT;
+        }
+    }
+
+    if (mode != MPY_PEER_DIRECT) {
+        shared = _acquire_staging(bufs);
+        if (shared < 0) {
+            return -1;
+        }
+    }
+
+    NPY_BEGIN_ALLOW_THREADS;
+    start = omp_get_wtime();
+
+    if (mode == MPY_PEER_AUTO) {
+        double t0 = omp_get_wtime();
+
+        err = target_memcpy(d, s, MPY_PEER_PROBE, dst_device, src_device);
+        t_direct = omp_get_wtime() - t0;
+        if (!err) {
+            t0 = omp_get_wtime();
+            err = _peer_copy_staged(d + MPY_PEER_PROBE, dst_device,
+                                    s + MPY_PEER_PROBE, src_device,
+                                    MPY_PEER_PROBE, bufs);
+            t_staged = omp_get_wtime() - t0;
+        }
+        done = 2 * MPY_PEER_PROBE;
+        mode = t_staged < t_direct ? MPY_PEER_STAGED : MPY_PEER_DIRECT;
+    }
+
+    if (!err && done < nbytes) {
+        if (mode == MPY_PEER_DIRECT) {
+            err = target_memcpy(d + done, s + done, nbytes - done,
+                                dst_device, src_device);
+        }
+        else {
+            err = _peer_copy_staged(d + done, dst_device, s + done,
+                                    src_device, nbytes - done, bufs);
+        }
+    }
+
+    peer_last_stats.nbytes = nbytes;
+    peer_last_stats.seconds = omp_get_wtime() - start;
+    peer_last_stats.mode = mode;
+    NPY_END_ALLOW_THREADS;
+
+    /* a failed probe says nothing about the link, probe again next time */
+    if (!err && t_direct > 0 &&
+            src_device < NMAXDEVICES && dst_device < NMAXDEVICES) {
+        peer_mode[src_device][dst_device] = mode;
+    }
+    if (shared >= 0) {
+        _release_staging(bufs, shared);
+    }
+
+    if (err) {
+        PyErr_Format(PyExc_RuntimeError,
+                     "copy of %"NPY_INTP_FMT" bytes from device %d to "
+                     "device %d failed", nbytes, src_device, dst_device);
+        return -1;
+    }
+    return 0;
+}
+
+NPY_NO_EXPORT void
+mpy_peer_last_stats(MpyPeerStats *stats)
+{
+    *stats = peer_last_stats;
+}
+
+NPY_NO_EXPORT int
+mpy_open_direct(const char *path, int *direct)
+{
+    int fd = -1;
+
+#ifdef O_DIRECT
+    fd = open(path, O_RDONLY | O_DIRECT);
+    if (fd >= 0) {
+        *direct = 1;
+        return fd;
+    }
+#endif
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)path);
+        return -1;
+    }
+    *direct = 0;
+    return fd;
+}
+
+NPY_NO_EXPORT int
+mpy_read_to_device(int fd, npy_off_t offset, npy_intp nbytes,
+                   void *dst, int device, int direct)
+{
+    char *bufs[2];
+    npy_intp head, nchunks, k;
+    npy_off_t start;
+    int shared, cur = 0, err = 0, copy_failed = 0;
+    struct stat st;
+
+    if (nbytes == 0) {
+        return 0;
+    }
+
+    if (fstat(fd, &st) == 0 && st.st_size < offset + nbytes) {
+        PyErr_Format(PyExc_ValueError,
+                     "file is too short: expected %"NPY_INTP_FMT" bytes "
+                     "at offset %lld", nbytes, (long long)offset);
+        return -1;
+    }
+
+    shared = _acquire_staging(bufs);
+    if (shared < 0) {
+        return -1;
+    }
+
+    /*
+     * With O_DIRECT the file position and length of every read must be
+     * aligned, so reads start at the aligned block holding offset and
+     * the first head bytes of the staged data are skipped.
+     */
+    head = direct ? (npy_intp)(offset % MPY_STAGING_ALIGN) : 0;
+    start = offset - head;
+    nchunks = (head + nbytes + MPY_STAGING_CHUNK - 1) / MPY_STAGING_CHUNK;
+
+    NPY_BEGIN_ALLOW_THREADS;
+
+    if (_pread_full(fd, bufs[0], MPY_STAGING_CHUNK, start) < 0) {
+        err = errno;
+    }
+
+    for (k = 0; k < nchunks && !err; ++k) {
+        /* byte range of the payload held by chunk k */
+        npy_intp lo = k * MPY_STAGING_CHUNK;
+        npy_intp hi = lo + MPY_STAGING_CHUNK;
+        npy_intp skip = (k == 0) ? head : 0;
+        npy_intp len;
+        int next_err = 0, copy_err = 0;
+
+        if (hi > head + nbytes) {
+            hi = head + nbytes;
+        }
+        len = hi - lo - skip;
+
+        #pragma omp parallel sections num_threads(2)
+        {
+            #pragma omp section
+            {
+                if (k + 1 < nchunks &&
+                        _pread_full(fd, bufs[1 - cur], MPY_STAGING_CHUNK,
+                                    start + lo + MPY_STAGING_CHUNK) < 0) {
+                    next_err = errno;
+                }
+            }
+            #pragma omp section
+            {
+                copy_err = target_memcpy((char *)dst + lo + skip - head,
+                                         bufs[cur] + skip, len,
+                                         device, CPU_DEVICE) != 0;
+            }
+        }
+        if (copy_err) {
+            copy_failed = 1;
+            break;
+        }
+        err = next_err;
+        cur = 1 - cur;
+    }
+
+    NPY_END_ALLOW_THREADS;
+
+    _release_staging(bufs, shared);
+
+    if (copy_failed) {
+        PyErr_Format(PyExc_RuntimeError,
+                     "copy of %"NPY_INTP_FMT" bytes to device %d failed",
+                     nbytes, device);
+        return -1;
+    }
+    if (err) {
+        errno = err;
+        PyErr_SetFromErrno(PyExc_IOError);
+        return -1;
+    }
+    return 0;
+}
+
+NPY_NO_EXPORT int
+mpy_write_from_device(int fd, npy_off_t offset, npy_intp nbytes,
+                      void *src, int device)
+{
+    char *bufs[2];
+    npy_intp nchunks, k;
+    int shared, cur = 0, err = 0, copy_failed = 0;
+
+    if (nbytes == 0) {
+        return 0;
+    }
+
+    shared = _acquire_staging(bufs);
+    if (shared < 0) {
+        return -1;
+    }
+
+    nchunks = (nbytes + MPY_STAGING_CHUNK - 1) / MPY_STAGING_CHUNK;
+
+    NPY_BEGIN_ALLOW_THREADS;
+
+    copy_failed = target_memcpy(bufs[0], src,
+                        nbytes < MPY_STAGING_CHUNK ? nbytes : MPY_STAGING_CHUNK,
+                        CPU_DEVICE, device) != 0;
+
+    for (k = 0; k < nchunks && !err && !copy_failed; ++k) {
+        npy_intp lo = k * MPY_STAGING_CHUNK;
+        npy_intp len = nbytes - lo < MPY_STAGING_CHUNK ?
+                                    nbytes - lo : MPY_STAGING_CHUNK;
+        int write_err = 0, copy_err = 0;
+
+        /* write chunk k while chunk k+1 comes from the device */
+        #pragma omp parallel sections num_threads(2)
+        {
+            #pragma omp section
+            {
+                if (_pwrite_full(fd, bufs[cur], len, offset + lo) < 0) {
+                    write_err = errno;
+                }
+            }
+            #pragma omp section
+            {
+                npy_intp next = lo + MPY_STAGING_CHUNK;
+                if (next < nbytes) {
+                    copy_err = target_memcpy(bufs[1 - cur], (char *)src + next,
+                                    nbytes - next < MPY_STAGING_CHUNK ?
+                                            nbytes - next : MPY_STAGING_CHUNK,
+                                    CPU_DEVICE, device) != 0;
+                }
+            }
+        }
+        err = write_err;
+        copy_failed = copy_err;
+        cur = 1 - cur;
+    }
+
+    NPY_END_ALLOW_THREADS;
+
+    _release_staging(bufs, shared);
+
+    if (copy_failed && !err) {
+        PyErr_Format(PyExc_RuntimeError,
+                     "copy of %"NPY_INTP_FMT" bytes from device %d failed",
+                     nbytes, device);
+        return -1;
+    }
+
+    if (err) {
+        errno = err;
+        PyErr_SetFromErrno(PyExc_IOError);
+        return -1;
+    }
+    return 0;
+}
+
+#define _CASTABLE(dtype) \
+        ((PyTypeNum_ISNUMBER((dtype)->type_num) || \
+          PyTypeNum_ISBOOL((dtype)->type_num)) && \
+         PyArray_ISNBO((dtype)->byteorder))
+
+NPY_NO_EXPORT int
+mpy_cast_copy_supported(PyArray_Descr *src_dtype, PyArray_Descr *dst_dtype)
+{
+    return _CASTABLE(src_dtype) && _CASTABLE(dst_dtype);
+}
+
+#undef _CASTABLE
+
+/* How a cast copy is carried out, see mpy_cast_copy */
+typedef struct {
+    PyArray_Descr *src_dtype, *dst_dtype;
+    /* device casting the elements, and their casting function there */
+    int cast_device;
+    PyArray_VectorUnaryFunc *host_cast;
+    PyMicArray_StridedUnaryOp *stransfer;
+    NpyAuxData *transferdata;
+} cast_plan;
+
+/* Elements a host thread casts at a time */
+#define CAST_BLOCK 16384
+
+/*
+ * Number of blocks _plan_cast_block splits a cast of count elements in.
+ * The device casts in one go, the host in blocks so that its threads
+ * share the work.
+ */
+static npy_intp
+_plan_cast_blocks(cast_plan *plan, npy_intp count)
+{
+    if (plan->host_cast == NULL) {
+        return count > 0;
+    }
+    return (count + CAST_BLOCK - 1) / CAST_BLOCK;
+}
+
+/* Cast block b of count elements from to to, on the casting device of plan */
+static void
+_plan_cast_block(cast_plan *plan, char *to, char *from, npy_intp count,
+                 npy_intp b)
+{
+    npy_intp src_size = plan->src_dtype->elsize;
+    npy_intp dst_size = plan->dst_dtype->elsize;
+
+    if (plan->host_cast != NULL) {
+        npy_intp lo = b * CAST_BLOCK;
+        npy_intp len = count - lo < CAST_BLOCK ? count - lo : CAST_BLOCK;
+
+        plan->host_cast(from + lo * src_size, to + lo * dst_size,
+                        len, NULL, NULL);
+    }
+    else {
+        plan->stransfer(to, dst_size, from, src_size, count, src_size,
+                        plan->transferdata, plan->cast_device);
+    }
+}
+
+NPY_NO_EXPORT int
+mpy_cast_copy(void *dst, int dst_device, PyArray_Descr *dst_dtype,
+              void *src, int src_device, PyArray_Descr *src_dtype,
+              npy_intp n)
+{
+    cast_plan plan = {src_dtype, dst_dtype, 0, NULL, NULL, NULL};
+    char *bufs[2] = {NULL, NULL};
+    char *d = (char *)dst, *s = (char *)src;
+    npy_intp src_size = src_dtype->elsize, dst_size = dst_dtype->elsize;
+    /* narrowing casts are done before sending, widening ones after */
+    int cast_on_src = dst_size < src_size;
+    npy_intp mid_size = cast_on_src ? dst_size : src_size;
+    npy_intp chunk = MPY_CAST_CHUNK / mid_size;
+    npy_intp nchunks, k;
+    int shared = -1, needs_api = 0, cur = 0, err = 0;
+
+    if (n == 0) {
+        return 0;
+    }
+    if (n < chunk) {
+        chunk = n;
+    }
+    nchunks = (n + chunk - 1) / chunk;
+
+    plan.cast_device = cast_on_src ? src_device : dst_device;
+    if (plan.cast_device == CPU_DEVICE) {
+        plan.host_cast = PyArray_GetCastFunc(src_dtype, dst_dtype->type_num);
+        if (plan.host_cast == NULL) {
+            return -1;
+        }
+        shared = _acquire_staging(bufs);
+        if (shared < 0) {
+            return -1;
+        }
+    }
+    else {
+        if (PyMicArray_GetDTypeTransferFunction(plan.cast_device, 1,
+                        src_size, dst_size, src_dtype, dst_dtype, 0,
+                        &plan.stransfer, &plan.transferdata,
+                        &needs_api) != NPY_SUCCEED) {
+            return -1;
+        }
+        /* with the GIL held, so that a full device can evict */
+        bufs[0] = PyDataMemMic_NEW(chunk * mid_size, plan.cast_device);
+        bufs[1] = PyDataMemMic_NEW(chunk * mid_size, plan.cast_device);
+        if (bufs[0] == NULL || bufs[1] == NULL) {
+            PyErr_NoMemory();
+            err = 1;
+            goto finish;
+        }
+    }
+
+    NPY_BEGIN_ALLOW_THREADS;
+
+    /*
+     * Stage one of chunk k casts it into bufs[k % 2] (cast_on_src) or
+     * receives it there; stage two sends it to dst or casts it into dst.
+     * Stage two of chunk k runs alongside stage one of chunk k+1.
+     */
+    if (cast_on_src) {
+        npy_intp b, nblocks = _plan_cast_blocks(&plan, chunk);
+
+        #pragma omp parallel for
+        for (b = 0; b < nblocks; b++) {
+            _plan_cast_block(&plan, bufs[0], s, chunk, b);
+        }
+    }
+    else {
+        err = target_memcpy(bufs[0], s, chunk * src_size,
+                            plan.cast_device, src_device) != 0;
+    }
+
+    for (k = 0; k < nchunks && !err; ++k) {
+        npy_intp lo = k * chunk;
+        npy_intp len = n - lo < chunk ? n - lo : chunk;
+        npy_intp next = lo + chunk;
+        npy_intp next_len = n - next < chunk ? n - next : chunk;
+        /* the cast of this step: chunk k+1 into bufs, or chunk k into dst */
+        char *cast_to = cast_on_src ? bufs[1 - cur] : d + lo * dst_size;
+        char *cast_from = cast_on_src ? s + next * src_size : bufs[cur];
+        npy_intp cast_len = cast_on_src ? (next < n ? next_len : 0) : len;
+        npy_intp b, nblocks = _plan_cast_blocks(&plan, cast_len);
+        int put_err = 0, get_err = 0;
+
+        /*
+         * Thread 0 moves a chunk while the rest of the team casts; it
+         * joins the cast when done. The cast is a worksharing loop of
+         * this team rather than a parallel region nested in a section,
+         * which would run on a single thread.
+         */
+        #pragma omp parallel private(b)
+        {
+            if (omp_get_thread_num() == 0) {
+                if (cast_on_src) {
+                    put_err = target_memcpy(d + lo * dst_size, bufs[cur],
+                                            len * dst_size,
+                                            dst_device, plan.cast_device);
+                }
+                else if (next < n) {
+                    get_err = target_memcpy(bufs[1 - cur],
+                                            s + next * src_size,
+                                            next_len * src_size,
+                                            plan.cast_device, src_device);
+                }
+            }
+            #pragma omp for schedule(dynamic)
+            for (b = 0; b < nblocks; b++) {
+                _plan_cast_block(&plan, cast_to, cast_from, cast_len, b);
+            }
+        }
+        err = put_err || get_err;
+        cur = 1 - cur;
+    }
+
+    NPY_END_ALLOW_THREADS;
+
+finish:
+    if (shared >= 0) {
+        _release_staging(bufs, shared);
+    }
+    else {
+        if (bufs[0] != NULL) {
+            PyDataMemMic_FREE(bufs[0], plan.cast_device);
+        }
+        if (bufs[1] != NULL) {
+            PyDataMemMic_FREE(bufs[1], plan.cast_device);
+        }
+        NPY_AUXDATA_FREE(plan.transferdata);
+    }
+
+    if (err) {
+        if (!PyErr_Occurred()) {
+            PyErr_Format(PyExc_RuntimeError,
+                         "copy of %"NPY_INTP_FMT" elements from device %d "
+                         "to device %d failed", n, src_device, dst_device);
+        }
+        return -1;
+    }
+    return (needs_api && PyErr_Occurred()) ? -1 : 0;
+}
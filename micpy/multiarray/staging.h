@@ -0,0 +1,112 @@
+#ifndef _MPY_STAGING_H_
+#define _MPY_STAGING_H_
+
+/*
+ * Chunked transfers between files and device memory through a pair of
+ * host staging buffers, so that the file I/O of one chunk overlaps the
+ * DMA of the previous one.
+ */
+
+/* size in bytes of one staging buffer */
+#define MPY_STAGING_CHUNK (64 * 1024 * 1024)
+
+/* alignment of the staging buffers, enough for O_DIRECT */
+#define MPY_STAGING_ALIGN 4096
+
+/*
+ * Read nbytes at offset of fd into device memory dst.
+ * If direct is set, fd was opened with O_DIRECT and only aligned reads
+ * are issued. Returns 0 on success, -1 with an exception set on failure.
+ * Releases the GIL while the transfer runs.
+ */
+NPY_NO_EXPORT int
+mpy_read_to_device(int fd, npy_off_t offset, npy_intp nbytes,
+                   void *dst, int device, int direct);
+
+/*
+ * Write nbytes of device memory src to fd at offset.
+ * Returns 0 on success, -1 with an exception set on failure.
+ * Releases the GIL while the transfer runs.
+ */
+NPY_NO_EXPORT int
+mpy_write_from_device(int fd, npy_off_t offset, npy_intp nbytes,
+                      void *src, int device);
+
+/*
+ * Device to device copies.
+ *
+ * A copy between two devices is either a direct omp_target_memcpy
+ * between them, or goes through the staging buffers: chunk k+1 comes off
+ * the source device while chunk k goes to the destination device.
+ * Which one is faster depends on the runtime, so the first large copy
+ * between two devices times both on its first chunks and the winner is
+ * kept for that pair. MICPY_PEER_COPY=direct|staged forces a path.
+ */
+typedef enum {
+    MPY_PEER_AUTO = 0,
+    MPY_PEER_DIRECT,
+    MPY_PEER_STAGED
+} MpyPeerMode;
+
+/* size of the chunks timed to choose the copy path */
+#define MPY_PEER_PROBE (8 * 1024 * 1024)
+
+/* bytes, time and path of the last peer copy of the calling thread */
+typedef struct {
+    npy_intp nbytes;
+    double seconds;
+    MpyPeerMode mode;
+} MpyPeerStats;
+
+/*
+ * Copy nbytes of contiguous memory from src on src_device to dst on
+ * dst_device. Returns 0 on success, -1 with an exception set on failure.
+ * Releases the GIL while the copy runs.
+ */
+NPY_NO_EXPORT int
+mpy_peer_copy(void *dst, int dst_device, void *src, int src_device,
+              npy_intp nbytes);
+
+NPY_NO_EXPORT void
+mpy_peer_last_stats(MpyPeerStats *stats);
+
+/*
+ * Host <-> device copies with a change of type.
+ *
+ * The elements are cast on whichever side makes the transfer smaller:
+ * before sending when the destination type is narrower, after receiving
+ * when it is wider. The cast and the transfer are pipelined chunk by
+ * chunk through two staging buffers on the casting side, so there is no
+ * temporary the size of the array.
+ */
+
+/* bytes of the transferred type held by one staging buffer */
+#define MPY_CAST_CHUNK (16 * 1024 * 1024)
+
+/*
+ * Whether mpy_cast_copy handles a cast from src_dtype to dst_dtype:
+ * numeric or boolean types in native byte order.
+ */
+NPY_NO_EXPORT int
+mpy_cast_copy_supported(PyArray_Descr *src_dtype, PyArray_Descr *dst_dtype);
+
+/*
+ * Copy n contiguous, aligned elements from src on src_device to dst on
+ * dst_device, casting them from src_dtype to dst_dtype. One of the two
+ * devices must be the host. Returns 0 on success, -1 with an exception
+ * set on failure. Releases the GIL while the copy runs.
+ */
+NPY_NO_EXPORT int
+mpy_cast_copy(void *dst, int dst_device, PyArray_Descr *dst_dtype,
+              void *src, int src_device, PyArray_Descr *src_dtype,
+              npy_intp n);
+
+/*
+ * Open path for reading, with O_DIRECT when the platform and the file
+ * system support it. Sets *direct accordingly.
+ * Returns the file descriptor, or -1 with an exception set.
+ */
+NPY_NO_EXPORT int
+mpy_open_direct(const char *path, int *direct);
+
+#endif
@@ -0,0 +1,219 @@
+"""
+Reading and writing .npy/.npz files directly from and to device memory.
+"""
+import os
+import struct
+import zipfile
+
+import numpy as np
+from numpy.lib import format as npformat
+
+from . import multiarray
+
+__all__ = ['load', 'save']
+
+_ZIP_LOCAL_HEADER_SIZE = 30
+
+
+def _is_path(file):
+    return isinstance(file, (str, bytes)) or hasattr(file, '__fspath__')
+
+
+def _read_npy_header(fp):
+    """Return (shape, fortran_order, dtype) and leave fp at the payload."""
+    version = npformat.read_magic(fp)
+    if version == (1, 0):
+        return npformat.read_array_header_1_0(fp)
+    return npformat.read_array_header_2_0(fp)
+
+
+def _check_dtype(dtype):
+    if dtype.hasobject:
+        raise ValueError("micpy cannot load object arrays")
+
+
+def _finish(arr, shape, fortran_order):
+    if len(shape) == 1 and not fortran_order:
+        return arr
+    return arr.reshape(shape, order='F' if fortran_order else 'C')
+
+
+def _load_npy(file, device):
+    if _is_path(file):
+        path = os.fspath(file) if hasattr(os, 'fspath') else file
+        with open(path, 'rb') as fp:
+            shape, fortran_order, dtype = _read_npy_header(fp)
+            offset = fp.tell()
+        _check_dtype(dtype)
+        count = int(np.prod(shape, dtype=np.intp))
+        arr = multiarray.fromfile(path, dtype=dtype, count=count,
+                                  offset=offset, device=device)
+    else:
+        shape, fortran_order, dtype = _read_npy_header(file)
+        _check_dtype(dtype)
+        count = int(np.prod(shape, dtype=np.intp))
+        arr = multiarray.fromfile(file, dtype=dtype, count=count,
+                                  device=device)
+    return _finish(arr, shape, fortran_order)
+
+
+class NpzFile(object):
+    """
+    Lazy dict-like view of a .npz archive, loading members to a device.
+
+    Members stored without compression are streamed from the archive
+    straight into device memory. Compressed members are inflated on the
+    host first.
+    """
+
+    def __init__(self, path, device=None):
+        self.path = path
+        self.device = device
+        self.zip = zipfile.ZipFile(path)
+        self.files = [name[:-4] if name.endswith('.npy') else name
+                      for name in self.zip.namelist()]
+
+    def close(self):
+        if self.zip is not None:
+            self.zip.close()
+            self.zip = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def __len__(self):
+        return len(self.files)
+
+    def __iter__(self):
+        return iter(self.files)
+
+    def __contains__(self, key):
+        return key in self.files
+
+    def keys(self):
+        return list(self.files)
+
+    def items(self):
+        return [(f, self[f]) for f in self.files]
+
+    def _member_offset(self, info):
+        """Offset of the data of a stored member within the archive."""
+        with open(self.path, 'rb') as fp:
+            fp.seek(info.header_offset)
+            header = fp.read(_ZIP_LOCAL_HEADER_SIZE)
+        namelen, extralen = struct.unpack('<HH', header[26:30])
+        return (info.header_offset + _ZIP_LOCAL_HEADER_SIZE +
+                namelen + extralen)
+
+    def __getitem__(self, key):
+        name = key if key in self.zip.namelist() else key + '.npy'
+        try:
+            info = self.zip.getinfo(name)
+        except KeyError:
+            raise KeyError("%s is not a file in the archive" % key)
+
+        if info.compress_type != zipfile.ZIP_STORED:
+            with self.zip.open(info) as fp:
+                host = npformat.read_array(fp)
+            return multiarray.to_mic(host, device=self.device)
+
+        with open(self.path, 'rb') as fp:
+            fp.seek(self._member_offset(info))
+            shape, fortran_order, dtype = _read_npy_header(fp)
+            offset = fp.tell()
+        _check_dtype(dtype)
+        count = int(np.prod(shape, dtype=np.intp))
+        arr = multiarray.fromfile(self.path, dtype=dtype, count=count,
+                                  offset=offset, device=self.device)
+        return _finish(arr, shape, fortran_order)
+
+
+def load(file, device=None):
+    """
+    Load an array from a .npy file, or the arrays of a .npz archive,
+    directly into device memory.
+
+    The payload is read in large aligned chunks (with O_DIRECT when the
+    file system allows it) into host staging buffers, and each chunk is
+    sent to the device while the next one is read. The host never holds
+    more than two chunks of the data.
+
+    Parameters
+    ----------
+    file : str or file
+        Path of the file, or an open binary file positioned at the start
+        of a .npy header.
+    device : int, optional
+        Target device, the current device by default.
+
+    Returns
+    -------
+    result : ndarray or NpzFile
+        The array for .npy files. For .npz archives a lazy dict-like
+        object loading each member on access.
+
+    See Also
+    --------
+    fromfile, save
+    """
+    if _is_path(file):
+        path = os.fspath(file) if hasattr(os, 'fspath') else file
+        with open(path, 'rb') as fp:
+            magic = fp.read(len(npformat.MAGIC_PREFIX))
+        if magic.startswith(b'PK\x03\x04'):
+            return NpzFile(path, device=device)
+    return _load_npy(file, device)
+
+
+def save(file, arr):
+    """
+    Save a device array to a binary file in .npy format.
+
+    The data is copied off the device chunk by chunk into host staging
+    buffers and each chunk is written while the next one is transferred,
+    so the host never holds a full copy of the array.
+
+    Parameters
+    ----------
+    file : str or file
+        Path of the file, to which ``.npy`` is appended if missing, or an
+        open binary file.
+    arr : ndarray
+        Array to save.
+
+    See Also
+    --------
+    load, ndarray.tofile
+    """
+    if arr.dtype.hasobject:
+        raise ValueError("micpy cannot save object arrays")
+
+    if _is_path(file):
+        path = os.fspath(file) if hasattr(os, 'fspath') else file
+        ext = b'.npy' if isinstance(path, bytes) else '.npy'
+        if not path.endswith(ext):
+            path = path + ext
+        with open(path, 'wb') as fp:
+            _save_npy(fp, arr)
+    else:
+        _save_npy(file, arr)
+
+
+def _save_npy(fp, arr):
+    # a Fortran ordered array is written as is, like numpy does
+    fortran_order = arr.flags.f_contiguous and not arr.flags.c_contiguous
+    header = {'descr': npformat.dtype_to_descr(arr.dtype),
+              'fortran_order': fortran_order,
+              'shape': arr.shape}
+    try:
+        npformat.write_array_header_1_0(fp, header)
+    except ValueError:
+        npformat.write_array_header_2_0(fp, header)
+    fp.flush()
+    (arr.T if fortran_order else arr).tofile(fp)
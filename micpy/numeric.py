@@ -1,3 +1,4 @@
+import numpy as np
 from numpy.core.multiarray import normalize_axis_index, array
 from numpy.core.numeric import normalize_axis_tuple
 from numpy import AxisError
@@ -21,6 +22,19 @@ def _wrapfunc(obj, method, *args, **kwds):
         return None
 
 
+def _fill(a, fill_value):
+    # scalars are written straight into the device memory by the fill
+    # kernel of the type, only arrays have to be broadcast
+    if isinstance(fill_value, multiarray.ndarray):
+        is_scalar = fill_value.ndim == 0
+    else:
+        is_scalar = np.ndim(fill_value) == 0
+    if is_scalar:
+        a.fill(fill_value)
+    else:
+        multiarray.copyto(a, fill_value, casting='unsafe')
+
+
 def full(shape, fill_value, dtype=None, order='C'):
     """
     Return a new array of given shape and type, filled with `fill_value`.
@@ -66,7 +80,7 @@ def full(shape, fill_value, dtype=None, order='C'):
     if dtype is None:
         dtype = array(fill_value).dtype
     a = empty(shape, dtype, order)
-    multiarray.copyto(a, fill_value, casting='unsafe')
+    _fill(a, fill_value)
     return a
 
 
@@ -126,10 +140,91 @@ def full_like(a, fill_value, dtype=None, order='K', subok=True):
 
     """
     res = empty_like(a, dtype=dtype, order=order, subok=subok)
-    multiarray.copyto(res, fill_value, casting='unsafe')
+    _fill(res, fill_value)
     return res
 
 
+def identity(n, dtype=None, device=None):
+    """
+    Return the identity array.
+
+    The identity array is a square array with ones on
+    the main diagonal. It is built on the device.
+
+    Parameters
+    ----------
+    n : int
+        Number of rows (and columns) in `n` x `n` output.
+    dtype : data-type, optional
+        Data-type of the output.  Defaults to ``float``.
+    device : int, optional
+        Device of the output, the current device by default.
+
+    Returns
+    -------
+    out : ndarray
+        `n` x `n` array with its main diagonal set to one,
+        and all other elements 0.
+
+    See Also
+    --------
+    eye : Ones on any diagonal of an array of any shape.
+
+    Examples
+    --------
+    >>> mp.identity(3)
+    micarray([[ 1.,  0.,  0.],
+           [ 0.,  1.,  0.],
+           [ 0.,  0.,  1.]])
+
+    """
+    return multiarray.eye(n, dtype=dtype, device=device)
+
+
+def items(a, indices):
+    """
+    Read the elements of a device array at the given indices.
+
+    The elements are gathered on the device and read back in one
+    transfer, instead of one transfer per element as with a loop over
+    `ndarray.item`.
+
+    Parameters
+    ----------
+    a : ndarray
+        Device array to read from.
+    indices : array_like of ints or tuple of array_like
+        Flat indices into `a`, in C order, or a tuple of index arrays,
+        one per dimension of `a`. Negative flat indices count from the
+        end.
+
+    Returns
+    -------
+    out : numpy.ndarray
+        Host array of the elements, with the shape of the indices.
+
+    Examples
+    --------
+    >>> a = mp.arange(12).reshape(3, 4)
+    >>> mp.items(a, [0, 5, -1])
+    array([ 0,  5, 11])
+    >>> mp.items(a, ([0, 2], [1, 3]))
+    array([ 1, 11])
+    """
+    if isinstance(indices, tuple):
+        indices = np.ravel_multi_index(
+            tuple(_to_host_indices(i) for i in indices), a.shape)
+    else:
+        indices = _to_host_indices(indices)
+    return multiarray._take_items(a, indices)
+
+
+def _to_host_indices(indices):
+    if isinstance(indices, multiarray.ndarray):
+        return indices.to_cpu()
+    return np.asarray(indices)
+
+
 def asarray(a, dtype=None, order=None):
     """Convert the input to an array.
 
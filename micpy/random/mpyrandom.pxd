@@ -20,7 +20,7 @@ cdef extern from "randomkit.h":
 
     char *rk_strerror[2]
 
-    void rk_init(rk_state *state, int ndevice) nogil
+    void rk_init(rk_state *state) nogil
     void rk_clean(rk_state *state) nogil
     void rk_seed(unsigned long seed, rk_state *state) nogil
     rk_error rk_randomseed(rk_state *state) nogil
@@ -65,4 +65,13 @@ cdef extern from "distributions.h":
     int rk_ifill_hypergeometric(rk_state *state, int device, long length,
                         void *data, int ngood, int nbad, int nsample) nogil
     int rk_ifill_bernoulli(rk_state *state, int device, long length,
-                        void *data, double p) nogil
\ No newline at end of file
+                        void *data, double p) nogil
+
+# The fills run without the GIL, so the arrays are pinned on their device
+# around them, see multiarray/residency.h. On host NUMA devices the team
+# running a fill is pinned to the node of the array first.
+cdef extern from "multiarray/multiarray_api.h":
+    int _import_pymicarray() except -1
+    int PyMicArray_Pin(ndarray arr) except -1
+    void PyMicArray_Unpin(ndarray arr)
+    void PyMicArray_BindTeam(int device) nogil
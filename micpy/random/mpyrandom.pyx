@@ -12,6 +12,8 @@ cimport mpyrandom
 
 ctypedef mpyrandom.ndarray micarray
 
+_import_pymicarray()
+
 cdef class RandomState:
     """
     RandomState(seed=None)
@@ -57,7 +59,7 @@ cdef class RandomState:
 
     def __init__(self, seed=None):
         cdef rk_state *state = <rk_state*>PyMem_Malloc(sizeof(rk_state))
-        rk_init(state, mp.ndevices)
+        rk_init(state)
         self.internal_state = state
         self.lock = Lock()
         self.seed(seed)
@@ -109,8 +111,11 @@ cdef class RandomState:
         arr = <micarray> mp.empty(length, np.ubyte)
         lsize = PyInt_AsLong(length)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_fill_bytes(self.internal_state, arr.device, lsize, arr.data)
+        PyMicArray_Unpin(arr)
         return arr
 
     def random_sample(self, size=None):
@@ -144,9 +149,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_uniform(self.internal_state, arr.device, lsize,
                 arr.data, ilow, ihigh)
+        PyMicArray_Unpin(arr)
         return arr
 
     def uniform(self, low=0.0, high=1.0, size=None):
@@ -162,9 +170,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_uniform(self.internal_state, arr.device, lsize,
                 arr.data, flow, fhigh)
+        PyMicArray_Unpin(arr)
         return arr
 
     # Complicated, continuous distributions:
@@ -189,9 +200,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_normal(self.internal_state, arr.device, lsize,
                 arr.data, floc, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     def beta(self, a, b, size=None):
@@ -210,9 +224,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_beta(self.internal_state, arr.device, lsize,
                 arr.data, fa, fb)
+        PyMicArray_Unpin(arr)
         return arr
 
     def standard_exponential(self, size=None):
@@ -230,9 +247,12 @@ cdef class RandomState:
         arr = mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_exponential(self.internal_state, arr.device, lsize,
                 arr.data, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     def standard_gamma(self, shape, size=None):
@@ -252,9 +272,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_gamma(self.internal_state, arr.device, lsize,
                 arr.data, fshape, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     def standard_cauchy(self, size=None):
@@ -271,9 +294,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_cauchy(self.internal_state, arr.device, lsize,
                 arr.data, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     def weibull(self, a, size=None):
@@ -288,9 +314,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_weibull(self.internal_state, arr.device, lsize,
                 arr.data, fa, 1.0)
+        PyMicArray_Unpin(arr)
         return arr
 
     def laplace(self, loc=0.0, scale=1.0, size=None):
@@ -305,9 +334,12 @@ cdef class RandomState:
 
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_laplace(self.internal_state, arr.device, lsize,
                 arr.data, floc, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     def gumbel(self, loc=0.0, scale=1.0, size=None):
@@ -322,9 +354,12 @@ cdef class RandomState:
 
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_gumbel(self.internal_state, arr.device, lsize,
                 arr.data, floc, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     def lognormal(self, mean=0.0, sigma=1.0, size=None):
@@ -340,9 +375,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_lognormal(self.internal_state, arr.device, lsize,
                 arr.data, fmean, fsigma)
+        PyMicArray_Unpin(arr)
         return arr
 
     def rayleigh(self, scale=1.0, size=None):
@@ -357,9 +395,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.float)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_dfill_rayleigh(self.internal_state, arr.device, lsize,
                 arr.data, fscale)
+        PyMicArray_Unpin(arr)
         return arr
 
     # Complicated, discrete distributions:
@@ -383,9 +424,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_binomial(self.internal_state, arr.device, lsize,
                 arr.data, <int> ln, fp)
+        PyMicArray_Unpin(arr)
         return arr
 
     def negative_binomial(self, n, p, size=None):
@@ -406,9 +450,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_negative_binomial(self.internal_state, arr.device, lsize,
                 arr.data, fn, fp)
+        PyMicArray_Unpin(arr)
         return arr
 
     def poisson(self, lam=1.0, size=None):
@@ -423,9 +470,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_poisson(self.internal_state, arr.device, lsize,
                 arr.data, flam)
+        PyMicArray_Unpin(arr)
         return arr
 
     def bernoulli(self, p, size=None):
@@ -442,9 +492,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_bernoulli(self.internal_state, arr.device, lsize,
                 arr.data, fp)
+        PyMicArray_Unpin(arr)
         return arr
 
     def geometric(self, p, size=None):
@@ -461,9 +514,12 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_geometric(self.internal_state, arr.device, lsize,
                 arr.data, fp)
+        PyMicArray_Unpin(arr)
         return arr
 
     def hypergeometric(self, ngood, nbad, nsample, size=None):
@@ -486,7 +542,10 @@ cdef class RandomState:
         arr = <micarray> mp.empty(size, dtype=np.int32)
         lsize = PyInt_AS_LONG(arr.size)
 
+        PyMicArray_Pin(arr)
         with self.lock, nogil:
+            PyMicArray_BindTeam(arr.device)
             rk_ifill_hypergeometric(self.internal_state, arr.device, lsize,
                 arr.data, <int> lngood, <int> lnbad, <int> lnsample)
+        PyMicArray_Unpin(arr)
         return arr
@@ -60,6 +60,7 @@
  * after windows timeb.h is included.
  */
 #include "randomkit.h"
+#include "multiarray/mpy_common.h"
 
 #define BRNG VSL_BRNG_MT2203
 
@@ -78,14 +79,15 @@ char *rk_strerror[RK_ERR_MAX] =
 };
 
 void
-rk_init(rk_state *state, int ndevice)
+rk_init(rk_state *state)
 {
     int i;
-    VSLStreamStatePtr stream;
 
-    state->num_device = ndevice;
-    for (i = 0; i < ndevice; ++i) {
+    state->num_device = NMAXDEVICES;
+    state->seed = 0;
+    for (i = 0; i < NMAXDEVICES; ++i) {
         state->rng_streams[i] = NULL;
+        state->stream_seeded[i] = 0;
     }
 
     //rk_randomseed(state);
@@ -99,10 +101,37 @@ rk_clean(rk_state *state)
 
     for (i = 0; i < state->num_device; ++i) {
         stream = state->rng_streams[i];
-        #pragma omp target device(i) map(to: stream)
+        if (stream == NULL) {
+            continue;
+        }
+        #pragma omp target device(mpy_omp_device(i)) map(to: stream)
         vslDeleteStream(&stream);
         state->rng_streams[i] = NULL;
+        state->stream_seeded[i] = 0;
+    }
+}
+
+void *
+rk_stream(rk_state *state, int device)
+{
+    unsigned long seed = state->seed;
+    VSLStreamStatePtr stream = state->rng_streams[device];
+
+    if (state->stream_seeded[device]) {
+        return stream;
     }
+
+    #pragma omp target device(mpy_omp_device(device)) \
+                       map(to:seed) map(tofrom: stream)
+    {
+        if (stream != NULL) {
+            vslDeleteStream(&stream);
+        }
+        vslNewStream(&stream, BRNG, seed);
+    }
+    state->rng_streams[device] = stream;
+    state->stream_seeded[device] = 1;
+    return stream;
 }
 
 /* static functions */
@@ -111,20 +140,12 @@ static unsigned long rk_hash(unsigned long key);
 void
 rk_seed(unsigned long seed, rk_state *state)
 {
-    int pos, i;
-    seed &= 0xffffffffUL;
-    VSLStreamStatePtr stream;
+    int i;
 
+    /* the streams pick up the new seed on their next use */
+    state->seed = seed & 0xffffffffUL;
     for (i = 0; i < state->num_device; ++i) {
-        stream = state->rng_streams[i];
-        #pragma omp target device(i) map(to:seed) map(tofrom: stream)
-        {
-            if (stream != NULL) {
-                vslDeleteStream(&stream);
-            }
-            vslNewStream(&stream, BRNG, seed);
-        }
-        state->rng_streams[i] = stream;
+        state->stream_seeded[i] = 0;
     }
 }
 
@@ -66,7 +66,10 @@
 typedef struct rk_state_
 {
     int num_device;
+    unsigned long seed;
+    /* streams are created on first use, see rk_stream */
     void *rng_streams[NMAXDEVICES];
+    int stream_seeded[NMAXDEVICES];
 }
 rk_state;
 
@@ -89,10 +92,16 @@ extern "C" {
 /*
  * Initialize the RNG state using the random seed.
  */
-void rk_init(rk_state *state, int ndevice);
+void rk_init(rk_state *state);
 
 void rk_clean(rk_state *state);
 
+/*
+ * Return the stream of device, creating or reseeding it if the seed
+ * changed since its last use.
+ */
+void *rk_stream(rk_state *state, int device);
+
 
 /*
  * Initialize the RNG state using the given seed.
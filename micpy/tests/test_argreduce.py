@@ -0,0 +1,134 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+
+# longer than MPY_ARG_BLOCK, so that few rows get cut into blocks
+LONG = 3 * 4096 + 17
+
+
+class TestArgReduce(object):
+
+    def _check(self, a, axis=None):
+        d = mp.to_mic(a)
+        assert_array_equal(mp.to_cpu(d.argmax(axis=axis)),
+                           a.argmax(axis=axis))
+        assert_array_equal(mp.to_cpu(d.argmin(axis=axis)),
+                           a.argmin(axis=axis))
+        if a.dtype.kind in 'biuf':
+            self._check_minmax(d, a, axis)
+
+    def _check_minmax(self, d, a, axis):
+        # the fused kernel, with the same blocks, lanes and tie rules
+        lo, hi = mp.minmax(d, axis)
+        assert_array_equal(mp.to_cpu(lo), np.min(a, axis=axis))
+        assert_array_equal(mp.to_cpu(hi), np.max(a, axis=axis))
+        hi, ihi = mp.max_with_index(d, axis)
+        assert_array_equal(mp.to_cpu(hi), np.max(a, axis=axis))
+        assert_array_equal(mp.to_cpu(ihi), np.argmax(a, axis=axis))
+        lo, ilo = mp.min_with_index(d, axis)
+        assert_array_equal(mp.to_cpu(lo), np.min(a, axis=axis))
+        assert_array_equal(mp.to_cpu(ilo), np.argmin(a, axis=axis))
+        if a.dtype.kind != 'b':
+            assert_array_equal(mp.to_cpu(d.ptp(axis=axis)),
+                               np.ptp(a, axis=axis))
+
+    def test_first_nan_wins(self):
+        a = np.array([1., np.nan, 5., np.nan, -np.inf, np.inf])
+        d = mp.to_mic(a)
+        assert_equal(int(mp.to_cpu(d.argmax())), 1)
+        assert_equal(int(mp.to_cpu(d.argmin())), 1)
+        # a nan is both extremes
+        hi, ihi = mp.max_with_index(d)
+        lo, ilo = mp.min_with_index(d)
+        assert np.isnan(mp.to_cpu(hi)) and np.isnan(mp.to_cpu(lo))
+        assert_equal(int(mp.to_cpu(ihi)), 1)
+        assert_equal(int(mp.to_cpu(ilo)), 1)
+        # in a later block than the extremes
+        for dtype in (np.float16, np.float32, np.float64):
+            a = np.arange(LONG).astype(dtype)
+            a[LONG - 5] = np.nan
+            a[LONG - 2] = np.nan
+            self._check(a)
+            a = np.arange(3 * 50, dtype=dtype).reshape(3, 50)
+            a[1, 20] = a[1, 40] = np.nan
+            self._check(a, 0)
+            self._check(a, 1)
+
+    def test_ties_go_to_the_first(self):
+        self._check(np.array([3, 7, 7, 1, 1]))
+        self._check(np.zeros(LONG))
+        # the same extreme in several blocks and lanes
+        a = np.zeros(LONG, dtype=np.int32)
+        a[[100, 4097, 9000]] = 5
+        a[[17, 4200, LONG - 1]] = -5
+        self._check(a)
+        self._check(a[::-1])
+
+    def test_rows_and_columns(self):
+        # lanes along a row, and lanes over neighbouring rows
+        rng = np.random.RandomState(3)
+        a = rng.randint(0, 10, size=(37, 45)).astype(np.float64)
+        for axis in (None, 0, 1):
+            self._check(a, axis)
+            self._check(a.T, axis)
+            self._check(np.asfortranarray(a), axis)
+            self._check(a[::2, 1::3], axis)
+            self._check(a[::-1], axis)
+        a[5, 7] = a[30, 7] = np.nan
+        self._check(a, 0)
+
+    def test_few_long_rows(self):
+        rng = np.random.RandomState(4)
+        a = rng.randint(0, 1000, size=(3, LONG))
+        self._check(a, 1)
+        self._check(a.T, 0)
+        a = a.astype(np.float64)
+        a[1, LONG // 2] = np.nan
+        self._check(a, 1)
+
+    def test_types(self):
+        a = np.array([[2, 9, 0, 9], [0, 1, 1, 0], [5, 5, 5, 5]])
+        for dtype in (np.int8, np.uint8, np.int16, np.uint16, np.int32,
+                      np.uint32, np.int64, np.uint64, np.float16,
+                      np.float32, np.longdouble, np.bool_):
+            for axis in (None, 0, 1):
+                self._check(a.astype(dtype), axis)
+        d = mp.to_mic(a.astype(np.bool_))
+        lo, hi = mp.minmax(d, 1)
+        assert_array_equal(mp.to_cpu(lo), [False, False, True])
+        assert_array_equal(mp.to_cpu(hi), [True, True, True])
+
+    def test_complex(self):
+        a = np.array([1 + 1j, 1 + 2j, 2 - 1j, 2 - 1j, 0j])
+        self._check(a)
+        self._check(np.array([[1j, 1 + 1j], [1 + 1j, 1j]]), 0)
+        # no fused kernel, but ptp goes through max and min
+        d = mp.to_mic(a)
+        assert_raises(TypeError, mp.minmax, d)
+        assert_raises(TypeError, mp.max_with_index, d)
+        assert_equal(complex(mp.to_cpu(d.ptp())), np.ptp(a))
+
+    def test_datetime(self):
+        nat = np.datetime64('NaT')
+        a = np.array([nat, '2001-01-05', '2001-01-02', nat,
+                      '2001-01-02'], dtype='M8[D]')
+        d = mp.to_mic(a)
+        # NaT is the smallest value, and argmin skips it, giving 0 when
+        # there is nothing else
+        assert_equal(int(mp.to_cpu(d.argmax())), 1)
+        assert_equal(int(mp.to_cpu(d.argmin())), 2)
+        d = mp.to_mic(np.array([nat, nat], dtype='M8[D]'))
+        assert_equal(int(mp.to_cpu(d.argmin())), 0)
+
+    def test_empty(self):
+        d = mp.to_mic(np.zeros((0, 4)))
+        assert_raises(ValueError, d.argmax)
+        assert_raises(ValueError, d.argmin, 0)
+        assert_equal(d.argmax(axis=1).shape, (0,))
+        assert_raises(ValueError, mp.minmax, d)
+        assert_raises(ValueError, mp.min_with_index, d, 0)
+        lo, hi = mp.minmax(d, 1)
+        assert_equal(lo.shape, (0,))
@@ -0,0 +1,116 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import (assert_equal, assert_array_equal,
+                           assert_allclose, assert_raises)
+
+import micpy as mp
+
+
+class TestComm(object):
+
+    def setup(self):
+        self.devices = list(range(mp.get_ndevices()))
+        self.n = len(self.devices)
+
+    def _on_devices(self, hosts):
+        return [mp.to_mic(h, device=d) for h, d in zip(hosts, self.devices)]
+
+    def _hosts(self, shape, dtype=np.float64):
+        size = int(np.prod(shape))
+        return [(np.arange(size) * (i + 1) + i).astype(dtype).reshape(shape)
+                for i in range(self.n)]
+
+    def test_allreduce_ops(self):
+        hosts = self._hosts((7, 5))
+        expected = {
+            'sum': np.sum(hosts, axis=0),
+            'mean': np.mean(hosts, axis=0),
+            'prod': np.prod(hosts, axis=0),
+            'max': np.max(hosts, axis=0),
+            'min': np.min(hosts, axis=0),
+        }
+        for op, want in expected.items():
+            arrays = self._on_devices(hosts)
+            res = mp.comm.allreduce(arrays, op=op)
+            assert_equal(len(res), self.n)
+            for r, d in zip(res, self.devices):
+                assert_equal(r.device, d)
+                assert_allclose(mp.to_cpu(r), want)
+            # the inputs are left alone
+            for a, h in zip(arrays, hosts):
+                assert_array_equal(mp.to_cpu(a), h)
+
+    def test_allreduce_segments(self):
+        # sizes that do not split evenly, and fewer items than devices
+        for size in (1, self.n - 1, self.n + 1, 3 * self.n + 2, 1000):
+            if size < 1:
+                continue
+            hosts = self._hosts((size,), np.int64)
+            res = mp.comm.allreduce(self._on_devices(hosts))
+            for r in res:
+                assert_array_equal(mp.to_cpu(r), np.sum(hosts, axis=0))
+
+    def test_allreduce_inplace(self):
+        hosts = self._hosts((4, 6))
+        arrays = self._on_devices(hosts)
+        res = mp.comm.allreduce(arrays, op='mean', inplace=True)
+        for a, r in zip(arrays, res):
+            assert r is a
+            assert_allclose(mp.to_cpu(a), np.mean(hosts, axis=0))
+
+    def test_allreduce_mean_integers(self):
+        # rejected before anything is reduced, the inputs stay as they were
+        hosts = self._hosts((3, 4), np.int32)
+        arrays = self._on_devices(hosts)
+        assert_raises(TypeError, mp.comm.allreduce, arrays, op='mean',
+                      inplace=True)
+        for a, h in zip(arrays, hosts):
+            assert_array_equal(mp.to_cpu(a), h)
+        res = mp.comm.allreduce(self._on_devices(hosts), op='sum')
+        assert_array_equal(mp.to_cpu(res[0]), np.sum(hosts, axis=0))
+
+    def test_allreduce_checks(self):
+        arrays = self._on_devices(self._hosts((4, 6)))
+        assert_raises(ValueError, mp.comm.allreduce, arrays, op='median')
+        assert_raises(ValueError, mp.comm.allreduce, [])
+        assert_raises(TypeError, mp.comm.allreduce, [np.zeros(3)])
+        assert_raises(ValueError, mp.comm.allreduce,
+                      [arrays[0][:, ::2]], inplace=True)
+        assert_raises(ValueError, mp.comm.allreduce,
+                      [arrays[0], arrays[0].copy()])
+        if self.n > 1:
+            assert_raises(ValueError, mp.comm.allreduce,
+                          [arrays[0], arrays[1][:2]])
+
+    def test_broadcast(self):
+        h = np.arange(24, dtype=np.float32).reshape(4, 6)
+        src = mp.to_mic(h, device=self.devices[-1])
+        res = mp.comm.broadcast(src, self.devices)
+        assert_equal([r.device for r in res], self.devices)
+        assert res[-1] is src
+        for r in res:
+            assert_array_equal(mp.to_cpu(r), h)
+
+    def test_scatter_gather(self):
+        for nrows in (self.n, 2 * self.n + 1, 1):
+            h = np.arange(nrows * 3, dtype=np.int32).reshape(nrows, 3)
+            parts = mp.comm.scatter(mp.to_mic(h), self.devices)
+            assert_equal([p.device for p in parts], self.devices)
+            assert_equal(sum(p.shape[0] for p in parts), nrows)
+            out = mp.comm.gather(parts, self.devices[0])
+            assert_equal(out.device, self.devices[0])
+            assert_array_equal(mp.to_cpu(out), h)
+        # a non contiguous source
+        h = np.arange(40, dtype=np.float64).reshape(8, 5)
+        parts = mp.comm.scatter(mp.to_mic(h)[:, ::2], self.devices)
+        assert_array_equal(mp.to_cpu(mp.comm.gather(parts, 0)), h[:, ::2])
+        assert_raises(ValueError, mp.comm.scatter,
+                      mp.to_mic(np.array(1.0)), self.devices)
+
+    def test_allgather(self):
+        hosts = self._hosts((2, 3))
+        res = mp.comm.allgather(self._on_devices(hosts))
+        for r, d in zip(res, self.devices):
+            assert_equal(r.device, d)
+            assert_array_equal(mp.to_cpu(r), np.concatenate(hosts))
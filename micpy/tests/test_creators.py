@@ -0,0 +1,88 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import (assert_, assert_equal, assert_array_equal,
+                           assert_allclose, assert_raises)
+
+import micpy as mp
+
+
+class TestArange(object):
+
+    def test_like_numpy(self):
+        for args in [(10,), (2, 10), (10, 2, -1), (0, 1, 0.1), (-3, 3, 0.5),
+                     (1, 1), (5, 1), (0, 10, 3)]:
+            assert_array_equal(mp.to_cpu(mp.arange(*args)), np.arange(*args))
+
+    def test_dtype(self):
+        for dtype in (np.int8, np.int32, np.int64, np.uint16,
+                      np.float32, np.float64, np.complex128):
+            d = mp.arange(0, 20, 3, dtype=dtype)
+            assert_equal(d.dtype, np.dtype(dtype))
+            assert_array_equal(mp.to_cpu(d), np.arange(0, 20, 3, dtype=dtype))
+
+    def test_empty_ranges(self):
+        for args in [(0,), (3, 3), (3, 1), (1, 3, -1)]:
+            d = mp.arange(*args)
+            assert_equal(d.shape, (0,))
+
+    def test_zero_step(self):
+        assert_raises(ValueError, mp.arange, 0, 10, 0)
+
+
+class TestLinspace(object):
+
+    def test_like_numpy(self):
+        for args in [(0, 1), (0, 1, 5), (-1, 1, 7), (1, 0, 4), (0, 1, 1),
+                     (0, 1, 0), (2.5, 2.5, 3)]:
+            assert_allclose(mp.to_cpu(mp.linspace(*args)),
+                            np.linspace(*args))
+
+    def test_endpoint(self):
+        assert_allclose(mp.to_cpu(mp.linspace(0, 1, 5, endpoint=False)),
+                        np.linspace(0, 1, 5, endpoint=False))
+        # the last value is stop exactly
+        assert_equal(mp.to_cpu(mp.linspace(0.1, 0.7, 7))[-1], 0.7)
+
+    def test_retstep(self):
+        d, step = mp.linspace(0, 1, 5, retstep=True)
+        assert_allclose(mp.to_cpu(d), np.linspace(0, 1, 5))
+        assert_equal(step, 0.25)
+        d, step = mp.linspace(0, 1, 1, retstep=True)
+        assert_(np.isnan(step))
+
+    def test_integer_dtype_floors(self):
+        # numpy floors before the cast, -0.5 becomes -1 and not 0
+        for args in [(-1, 1, 5), (-3, 2, 7), (0, 10, 4), (-2.5, 2.5, 6)]:
+            d = mp.linspace(*args, dtype=int)
+            assert_equal(d.dtype, np.dtype(int))
+            assert_array_equal(mp.to_cpu(d), np.linspace(*args, dtype=int))
+
+    def test_complex(self):
+        assert_allclose(mp.to_cpu(mp.linspace(0, 1 + 2j, 5)),
+                        np.linspace(0, 1 + 2j, 5))
+
+    def test_negative_num(self):
+        assert_raises(ValueError, mp.linspace, 0, 1, -1)
+
+
+class _Exporter(object):
+
+    def __init__(self, iface):
+        self.__mic_array_interface__ = iface
+
+
+class TestInterface(object):
+
+    def test_shares_the_data(self):
+        d = mp.to_mic(np.arange(12, dtype=np.float64).reshape(3, 4))
+        w = mp.asarray(_Exporter(d.__mic_array_interface__))
+        assert_equal(w.shape, (3, 4))
+        w[0, 0] = -1
+        assert_equal(float(mp.to_cpu(d)[0, 0]), -1)
+
+    def test_rejects_swapped_and_object_data(self):
+        d = mp.to_mic(np.arange(4, dtype=np.float64))
+        for typestr in ('>f8' if np.little_endian else '<f8', '|O'):
+            iface = dict(d.__mic_array_interface__, typestr=typestr)
+            assert_raises(ValueError, mp.asarray, _Exporter(iface))
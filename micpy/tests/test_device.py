@@ -0,0 +1,104 @@
+from __future__ import division, absolute_import, print_function
+
+import threading
+
+import numpy as np
+from numpy.testing import assert_equal, assert_allclose
+
+import micpy as mp
+
+
+class TestDevice(object):
+
+    def test_nesting_restores(self):
+        start = mp.device()
+        dev = mp.Device(start)
+        with dev:
+            with dev:
+                assert_equal(mp.device(), start)
+            assert_equal(mp.device(), start)
+        assert_equal(mp.device(), start)
+
+    def test_shared_between_threads(self):
+        # every thread enters the same Device from its own current device
+        ndev = mp.get_ndevices()
+        shared = mp.Device(0)
+        barrier = threading.Barrier(4) if hasattr(threading, 'Barrier') \
+                  else None
+        errors = []
+
+        def run(i):
+            try:
+                own = i % ndev
+                mp.set_device(own)
+                for _ in range(50):
+                    with shared:
+                        if barrier is not None and _ == 0:
+                            barrier.wait()
+                        assert_equal(mp.device(), 0)
+                    assert_equal(mp.device(), own)
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert_equal(errors, [])
+
+
+class TestDeviceScalars(object):
+
+    def setup(self):
+        self.a = np.arange(1, 11, dtype=np.float64)
+        self.d = mp.to_mic(self.a)
+
+    def test_zero_d_results(self):
+        with mp.device_scalars():
+            s = self.d.sum()
+            m = self.d.max()
+            v = mp.dot(self.d, self.d)
+            for x in (s, m, v):
+                assert isinstance(x, mp.ndarray)
+                assert_equal(x.shape, ())
+                assert_equal(x.device, self.d.device)
+            # they feed the next device operation as they are
+            norm = mp.sqrt(v)
+            assert isinstance(norm, mp.ndarray)
+        # read back on demand
+        assert_equal(float(s), 55.0)
+        assert_equal(int(m), 10)
+        assert_equal(bool(m), True)
+        assert_allclose(float(norm), np.sqrt(np.dot(self.a, self.a)))
+        with mp.device_scalars():
+            i = self.d.argmax()
+        assert_equal(list(range(20))[i], 9)
+
+    def test_off_by_default(self):
+        s = self.d.sum()
+        assert not isinstance(s, mp.ndarray)
+        assert_equal(s, 55.0)
+        with mp.device_scalars(False):
+            assert not isinstance(self.d.sum(), mp.ndarray)
+
+    def test_nesting_restores(self):
+        with mp.device_scalars():
+            with mp.device_scalars(False):
+                assert not isinstance(self.d.sum(), mp.ndarray)
+            assert isinstance(self.d.sum(), mp.ndarray)
+        assert_equal(mp.set_device_scalars(True), False)
+        assert_equal(mp.set_device_scalars(False), True)
+
+    def test_per_thread(self):
+        results = []
+
+        def run():
+            results.append(isinstance(self.d.sum(), mp.ndarray))
+
+        with mp.device_scalars():
+            t = threading.Thread(target=run)
+            t.start()
+            t.join()
+            assert isinstance(self.d.sum(), mp.ndarray)
+        assert_equal(results, [False])
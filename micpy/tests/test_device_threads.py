@@ -0,0 +1,53 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+from micpy import multiarray
+
+
+class TestDeviceThreads(object):
+
+    def setup(self):
+        self.dev = mp.device()
+        multiarray.reset_device_threads(self.dev)
+
+    def teardown(self):
+        multiarray.reset_device_threads(self.dev)
+
+    def test_unconfigured(self):
+        assert_equal(multiarray.get_device_threads(self.dev), None)
+
+    def test_set_and_get(self):
+        multiarray.set_device_threads(self.dev, 1, 'balanced', 0)
+        assert_equal(multiarray.get_device_threads(self.dev),
+                     (1, 'balanced', 0))
+
+    def test_context_restores_unconfigured(self):
+        with mp.device_threads(self.dev, 1, affinity='compact'):
+            assert_equal(multiarray.get_device_threads(self.dev),
+                         (1, 'compact', 0))
+        assert_equal(multiarray.get_device_threads(self.dev), None)
+
+    def test_context_restores_previous(self):
+        multiarray.set_device_threads(self.dev, 1, 'scatter', 0)
+        with mp.device_threads(self.dev, 1, affinity='balanced'):
+            pass
+        assert_equal(multiarray.get_device_threads(self.dev),
+                     (1, 'scatter', 0))
+
+    def test_all_affinities_compute(self):
+        a = np.arange(10000, dtype=np.float64)
+        for affinity in ('compact', 'scatter', 'balanced', None):
+            with mp.device_threads(self.dev, 0, affinity=affinity):
+                d = mp.to_mic(a)
+                assert_array_equal(mp.to_cpu(d * 2), a * 2)
+
+    def test_bad_arguments(self):
+        assert_raises(ValueError, multiarray.set_device_threads,
+                      self.dev, -1)
+        assert_raises(ValueError, multiarray.set_device_threads,
+                      self.dev, 0, 'spread')
+        assert_raises(ValueError, multiarray.set_device_threads,
+                      self.dev, 0, None, -1)
@@ -0,0 +1,70 @@
+from __future__ import division, absolute_import, print_function
+
+import warnings
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_allclose
+
+import micpy as mp
+from micpy import dispatch
+
+
+class TestDispatch(object):
+
+    def setup(self):
+        self.warn = mp.set_fallback_warning(True)
+
+    def teardown(self):
+        mp.set_fallback_warning(self.warn)
+
+    def _call(self, func, *args, **kwargs):
+        with warnings.catch_warnings(record=True) as w:
+            warnings.simplefilter('always', mp.FallbackWarning)
+            ret = func(*args, **kwargs)
+        fallbacks = [x for x in w
+                     if issubclass(x.category, mp.FallbackWarning)]
+        return ret, len(fallbacks)
+
+    def test_ufunc_on_device(self):
+        a = np.arange(10, dtype=np.float64)
+        ret, fallbacks = self._call(np.add, mp.to_mic(a), 1)
+        assert_equal(fallbacks, 0)
+        assert isinstance(ret, mp.ndarray)
+        assert_array_equal(mp.to_cpu(ret), a + 1)
+
+    def test_methods_on_device(self):
+        a = np.arange(24, dtype=np.float64).reshape(4, 6)
+        d = mp.to_mic(a)
+        for func, args in ((np.sum, (0,)), (np.mean, ()), (np.amax, (1,)),
+                           (np.transpose, ()), (np.reshape, ((6, 4),)),
+                           (np.ravel, ())):
+            ret, fallbacks = self._call(func, d, *args)
+            assert_equal(fallbacks, 0)
+            assert_allclose(mp.to_cpu(mp.asarray(ret)), func(a, *args))
+
+    def test_statistics_on_device(self):
+        a = np.arange(24, dtype=np.float64).reshape(4, 6) ** 2
+        d = mp.to_mic(a)
+        for func, kwargs in ((np.std, {}), (np.std, {'axis': 0, 'ddof': 1}),
+                             (np.var, {'axis': 1}), (np.var, {'ddof': 1}),
+                             (np.ptp, {}), (np.ptp, {'axis': 0})):
+            ret, fallbacks = self._call(func, d, **kwargs)
+            assert_equal(fallbacks, 0)
+            assert_allclose(mp.to_cpu(mp.asarray(ret)), func(a, **kwargs))
+
+    def test_resize_has_numpy_semantics(self):
+        # np.resize repeats the data, ndarray.resize pads with zeros
+        a = np.arange(4, dtype=np.int64)
+        ret, fallbacks = self._call(np.resize, mp.to_mic(a), (3, 3))
+        assert_equal(fallbacks, 1)
+        assert isinstance(ret, mp.ndarray)
+        assert_array_equal(mp.to_cpu(ret), np.resize(a, (3, 3)))
+
+    def test_no_stub_implementations(self):
+        impl = dispatch._get_implementations()
+        assert np.resize not in impl
+        assert np.count_nonzero not in impl
+        a = np.array([0, 1, 0, 3])
+        ret, fallbacks = self._call(np.count_nonzero, mp.to_mic(a))
+        assert_equal(fallbacks, 1)
+        assert_equal(int(ret), 2)
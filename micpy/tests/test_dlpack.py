@@ -0,0 +1,69 @@
+from __future__ import division, absolute_import, print_function
+
+import gc
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+
+
+class TestDLPack(object):
+
+    def setup(self):
+        self.residency = mp.set_residency(True)
+
+    def teardown(self):
+        mp.set_residency(self.residency)
+
+    def test_roundtrip(self):
+        a = np.arange(60, dtype=np.float32).reshape(3, 4, 5)
+        d = mp.to_mic(a)
+        for x in (d, d[:, ::2], d.T):
+            b = mp.from_dlpack(x)
+            assert_equal(b.shape, x.shape)
+            assert_array_equal(mp.to_cpu(b), mp.to_cpu(x))
+        # the import wraps the memory in place
+        b = mp.from_dlpack(d)
+        b[0, 0, 0] = -1
+        assert_equal(mp.to_cpu(d)[0, 0, 0], -1)
+
+    def test_export_pins_until_deleted(self):
+        d = mp.zeros(1 << 16, dtype=np.float64)
+        capsule = d.__dlpack__()
+        # the consumer holds the data pointer
+        assert_equal(d.evict(), False)
+        del capsule
+        gc.collect()
+        assert_equal(d.evict(), True)
+        assert_array_equal(mp.to_cpu(d), np.zeros(1 << 16))
+
+    def test_imported_array_releases_pin(self):
+        d = mp.zeros(1 << 16, dtype=np.float64)
+        b = mp.from_dlpack(d)
+        assert_equal(d.evict(), False)
+        del b
+        gc.collect()
+        assert_equal(d.evict(), True)
+
+    def test_failed_export_does_not_pin(self):
+        d = mp.zeros(1 << 16, dtype=np.bool_)
+        assert_raises(BufferError, d.__dlpack__)
+        assert_raises(RuntimeError, d.__dlpack__, stream=1)
+        assert_equal(d.evict(), True)
+
+    def test_every_device(self):
+        # kernels and exports work on each device, host NUMA nodes included
+        a = np.arange(1000, dtype=np.float64)
+        for dev in range(mp.get_ndevices()):
+            d = mp.to_mic(a, device=dev)
+            e = d * 2 + 1
+            assert_equal(e.device, dev)
+            assert_array_equal(mp.to_cpu(e), a * 2 + 1)
+            kind, dev_id = e.__dlpack_device__()
+            # host memory is exported as kDLCPU, device memory as kDLExtDev
+            assert kind in (1, 12)
+            if kind == 12:
+                assert_equal(dev_id, dev)
+            b = mp.from_dlpack(e)
+            assert_array_equal(mp.to_cpu(b), a * 2 + 1)
@@ -0,0 +1,64 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+
+
+class TestToList(object):
+
+    def test_like_numpy(self):
+        a = np.arange(24, dtype=np.int64).reshape(2, 3, 4)
+        d = mp.to_mic(a)
+        for x, y in ((d, a), (d.T, a.T), (d[:, ::2, 1::2], a[:, ::2, 1::2]),
+                     (d[1, 2], a[1, 2])):
+            assert_equal(x.tolist(), y.tolist())
+        assert_equal(mp.to_mic(np.array(2.5)).tolist(), 2.5)
+        assert_equal(mp.to_mic(np.zeros((0, 3))).tolist(), [])
+
+    def test_types(self):
+        for dtype in (np.bool_, np.int8, np.uint32, np.float32,
+                      np.complex128):
+            a = np.arange(6).reshape(2, 3).astype(dtype)
+            res = mp.to_mic(a).tolist()
+            assert_equal(res, a.tolist())
+            assert_equal(type(res[0][0]), type(a.tolist()[0][0]))
+
+
+class TestItems(object):
+
+    def setup(self):
+        self.a = np.arange(12, dtype=np.float64).reshape(3, 4) * 10
+        self.d = mp.to_mic(self.a)
+
+    def test_flat(self):
+        idx = [0, 5, -1, -12, 5]
+        assert_array_equal(mp.items(self.d, idx), self.a.ravel()[idx])
+        idx = np.array([[1, -2], [3, 0]])
+        res = mp.items(self.d, idx)
+        assert_equal(res.shape, (2, 2))
+        assert_array_equal(res, self.a.ravel()[idx])
+        assert_array_equal(mp.items(self.d, mp.to_mic(np.array([7, -3]))),
+                           self.a.ravel()[[7, -3]])
+
+    def test_tuple(self):
+        rows, cols = [0, 2, 2, 1], [1, 3, 0, 3]
+        assert_array_equal(mp.items(self.d, (rows, cols)),
+                           self.a[rows, cols])
+        # through a strided view, the offsets follow its strides
+        v = self.d[::2, ::-1]
+        assert_array_equal(mp.items(v, ([1, 0], [0, 3])),
+                           self.a[::2, ::-1][[1, 0], [0, 3]])
+        assert_raises(ValueError, mp.items, self.d, ([3], [0]))
+
+    def test_out_of_bounds(self):
+        assert_raises(IndexError, mp.items, self.d, [12])
+        assert_raises(IndexError, mp.items, self.d, [0, -13])
+        assert_equal(mp.items(self.d, np.array([], dtype=np.intp)).shape,
+                     (0,))
+
+    def test_item(self):
+        assert_equal(self.d.item(5), 50.0)
+        assert_equal(self.d.item(-1), 110.0)
+        assert_equal(self.d.item((2, 1)), 90.0)
@@ -0,0 +1,93 @@
+from __future__ import division, absolute_import, print_function
+
+import json
+import os
+import tempfile
+import threading
+import warnings
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal
+
+import micpy as mp
+from micpy import autotune, umath
+
+
+class TestLoopTuning(object):
+
+    def teardown(self):
+        umath._clear_loop_tuning()
+
+    def test_table_roundtrip(self):
+        dev = mp.device()
+        umath._set_loop_tuning('add', 'float64', 10, dev, 4, 1024, 100)
+        entries = umath._get_loop_tuning()
+        assert_equal(len(entries), 1)
+        name, dtype, bucket, device, nthreads, chunk, cutoff = entries[0]
+        assert_equal((name, np.dtype(dtype), bucket, device),
+                     ('add', np.dtype('float64'), 10, dev))
+        assert_equal((nthreads, chunk, cutoff), (4, 1024, 100))
+
+    def test_cutoff_and_chunk_keep_results(self):
+        dev = mp.device()
+        a = np.arange(5000, dtype=np.float64)
+        # every launch serial, then every launch with a tiny chunk
+        for nthreads, chunk, cutoff in ((0, 256, 1 << 40), (3, 8, 0)):
+            umath._clear_loop_tuning()
+            for bucket in range(64):
+                umath._set_loop_tuning('add', 'float64', bucket, dev,
+                                       nthreads, chunk, cutoff)
+            d = mp.to_mic(a)
+            assert_array_equal(mp.to_cpu(mp.add(d, d)), a + a)
+
+    def test_concurrent_launches(self):
+        # two threads launching on one device with different tunings
+        dev = mp.device()
+        umath._set_loop_tuning('add', 'float64', 12, dev, 1, 64, 1 << 40)
+        umath._set_loop_tuning('add', 'float64', 16, dev, 0, 4096, 0)
+        sizes = (1 << 12, 1 << 16)
+        errors = []
+
+        def run(n):
+            try:
+                a = np.arange(n, dtype=np.float64)
+                d = mp.to_mic(a)
+                for _ in range(20):
+                    assert_array_equal(mp.to_cpu(mp.add(d, d)), a + a)
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=run, args=(n,)) for n in sizes]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert_equal(errors, [])
+
+    def test_load_skips_bad_entries(self):
+        dev = mp.device()
+        good = dict(ufunc='add', dtype='<f8', bucket=10, device=dev,
+                    nthreads=4, chunk=1024, cutoff=100)
+        entries = [good,
+                   dict(good, dtype='not a dtype'),
+                   dict(good, bucket=1000),
+                   {'ufunc': 'add'},
+                   'garbage']
+        fd, path = tempfile.mkstemp(suffix='.json')
+        try:
+            with os.fdopen(fd, 'w') as f:
+                json.dump({'version': 1, 'entries': entries}, f)
+            with warnings.catch_warnings(record=True) as w:
+                warnings.simplefilter('always', RuntimeWarning)
+                assert_equal(autotune.load(path), 1)
+            assert_equal(len(w), 4)
+            assert_equal(len(umath._get_loop_tuning()), 1)
+
+            with open(path, 'w') as f:
+                json.dump({'version': 1, 'entries': 3}, f)
+            with warnings.catch_warnings(record=True) as w:
+                warnings.simplefilter('always', RuntimeWarning)
+                assert_equal(autotune.load(path), 0)
+            assert_equal(len(w), 1)
+        finally:
+            os.remove(path)
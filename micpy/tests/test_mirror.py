@@ -0,0 +1,82 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+
+# 10 float64 per chunk, the last of the 10 chunks holds 5
+N = 95
+CHUNK_BYTES = 80
+
+
+class TestMirroredArray(object):
+
+    def setup(self):
+        self.a = np.arange(N, dtype=np.float64)
+        self.m = mp.mirror(self.a.copy(), chunk_bytes=CHUNK_BYTES)
+
+    def test_copies_only_when_stale(self):
+        m = self.m
+        assert_array_equal(mp.to_cpu(m.device_view(write=False)), self.a)
+        assert_equal(m.bytes_to_device, N * 8)
+        m.device_view(write=False)
+        assert_equal(m.bytes_to_device, N * 8)
+        assert_equal(m.bytes_to_host, 0)
+        # a write on the device makes the whole host copy stale
+        d = m.device_view()
+        mp.add(d, 1, out=d)
+        assert_equal(m.host_valid, False)
+        assert_array_equal(m.host_view(write=False), self.a + 1)
+        assert_equal(m.bytes_to_host, N * 8)
+
+    def test_dirty_chunk_runs(self):
+        m = self.m
+        m.device_view(write=False)
+        sent = m.bytes_to_device
+        h = m.host_view(write=False)
+        # elements 15 to 35 lie in chunks 1 to 3, one run of 30 elements
+        h[15:35] = -1
+        m.mark_host_dirty(15, 35)
+        assert_equal(m.device_valid, False)
+        assert_array_equal(mp.to_cpu(m.device_view(write=False)), h)
+        assert_equal(m.bytes_to_device - sent, 30 * 8)
+        # the first and last chunks, two runs, the last one short
+        sent = m.bytes_to_device
+        h[0] = h[-1] = -2
+        m.mark_host_dirty(0, 1)
+        m.mark_host_dirty(N - 1)
+        assert_array_equal(mp.to_cpu(m.device_view(write=False)), h)
+        assert_equal(m.bytes_to_device - sent, (10 + 5) * 8)
+        # an empty range marks nothing
+        m.mark_host_dirty(40, 40)
+        assert_equal(m.device_valid, True)
+
+    def test_device_dirty(self):
+        m = self.m
+        d = m.device_view(write=False)
+        d[50:52] = 7
+        m.mark_device_dirty(50, 52)
+        h = m.host_view(write=False)
+        assert_array_equal(h[50:52], 7)
+        assert_equal(m.bytes_to_host, 10 * 8)
+
+    def test_mark_stale_chunks(self):
+        m = self.m
+        # the device copy was never written
+        assert_raises(ValueError, m.mark_device_dirty, 0, 10)
+        m.device_view()
+        # and now the host copy is stale everywhere
+        assert_raises(ValueError, m.mark_host_dirty, 20, 30)
+        m.host_view(write=False)
+        m.mark_host_dirty(20, 30)
+        assert_raises(ValueError, m.mark_host_dirty, 0, N + 1)
+        assert_raises(ValueError, m.mark_device_dirty, 5, 3)
+
+    def test_from_device(self):
+        d = mp.to_mic(self.a.reshape(5, 19))
+        m = mp.mirror(d)
+        assert_equal(m.host_valid, False)
+        assert m.device_view(write=False) is d
+        assert_array_equal(np.asarray(m), self.a.reshape(5, 19))
+        assert_equal(m.bytes_to_device, 0)
@@ -0,0 +1,96 @@
+from __future__ import division, absolute_import, print_function
+
+import os
+import shutil
+import tempfile
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+from micpy import multiarray
+
+
+class TestLoad(object):
+
+    def setup(self):
+        self.tmpdir = tempfile.mkdtemp()
+
+    def teardown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def test_npy(self):
+        path = os.path.join(self.tmpdir, 'a.npy')
+        for a in (np.arange(1000, dtype=np.float64).reshape(10, 100),
+                  np.asfortranarray(np.arange(60, dtype=np.int32)
+                                    .reshape(3, 4, 5)),
+                  np.zeros(0, dtype=np.float32)):
+            np.save(path, a)
+            d = mp.load(path)
+            assert_equal(d.shape, a.shape)
+            assert_array_equal(mp.to_cpu(d), a)
+
+    def test_npz(self):
+        path = os.path.join(self.tmpdir, 'a.npz')
+        a = np.arange(100, dtype=np.float32)
+        b = np.ones((4, 4), dtype=np.complex128)
+        np.savez(path, a=a, b=b)
+        with mp.load(path) as z:
+            assert_equal(sorted(z.keys()), ['a', 'b'])
+            assert_array_equal(mp.to_cpu(z['a']), a)
+            assert_array_equal(mp.to_cpu(z['b']), b)
+
+    def test_fromfile_offset_count(self):
+        path = os.path.join(self.tmpdir, 'a.bin')
+        a = np.arange(1 << 16, dtype=np.int64)
+        a.tofile(path)
+        d = multiarray.fromfile(path, dtype=np.int64, count=100,
+                                offset=8 * 5000)
+        assert_array_equal(mp.to_cpu(d), a[5000:5100])
+        # unaligned offset, to the end of the file
+        d = multiarray.fromfile(path, dtype=np.int8, offset=3)
+        assert_array_equal(mp.to_cpu(d), a.view(np.int8)[3:])
+
+    def test_short_file(self):
+        path = os.path.join(self.tmpdir, 'a.bin')
+        np.arange(10, dtype=np.float64).tofile(path)
+        assert_raises(ValueError, multiarray.fromfile, path,
+                      dtype=np.float64, count=11)
+
+
+class TestSave(object):
+
+    def setup(self):
+        self.tmpdir = tempfile.mkdtemp()
+
+    def teardown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def test_save_roundtrip(self):
+        path = os.path.join(self.tmpdir, 'a.npy')
+        for a in (np.arange(1000, dtype=np.float64).reshape(10, 100),
+                  np.asfortranarray(np.arange(60, dtype=np.int16)
+                                    .reshape(3, 4, 5)),
+                  np.zeros(0, dtype=np.float32)):
+            mp.save(path, mp.to_mic(a))
+            b = np.load(path)
+            assert_equal(b.flags.f_contiguous, a.flags.f_contiguous)
+            assert_array_equal(b, a)
+
+    def test_tofile_appends(self):
+        path = os.path.join(self.tmpdir, 'a.bin')
+        a = np.arange(3000, dtype=np.int32)
+        with open(path, 'wb') as fp:
+            fp.write(b'xyz')
+            mp.to_mic(a).tofile(fp)
+            mp.to_mic(a[::-3]).tofile(fp)
+        data = open(path, 'rb').read()
+        assert_equal(data[:3], b'xyz')
+        assert_equal(data[3:], a.tobytes() + a[::-3].tobytes())
+
+    def test_tobytes(self):
+        a = np.arange(24, dtype=np.float64).reshape(2, 3, 4)
+        d = mp.to_mic(a)
+        assert_equal(d.tobytes(), a.tobytes())
+        assert_equal(d.tobytes('F'), a.tobytes('F'))
+        assert_equal(d[:, ::2].tobytes(), a[:, ::2].tobytes())
@@ -0,0 +1,42 @@
+from __future__ import division, absolute_import, print_function
+
+import pickle
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal
+
+import micpy as mp
+
+
+def _arrays():
+    yield np.arange(100, dtype=np.float64).reshape(10, 10)
+    yield np.asfortranarray(np.arange(24, dtype=np.int32).reshape(2, 3, 4))
+    yield np.arange(30, dtype=np.complex64)[::3]
+    yield np.zeros((0, 5), dtype=np.float32)
+    yield np.array(7, dtype=np.int8)
+
+
+class TestPickle(object):
+
+    def test_roundtrip(self):
+        for proto in range(2, pickle.HIGHEST_PROTOCOL + 1):
+            for a in _arrays():
+                d = mp.to_mic(a)
+                b = pickle.loads(pickle.dumps(d, protocol=proto))
+                assert_equal(type(b), type(d))
+                assert_equal(b.dtype, a.dtype)
+                assert_equal(b.shape, a.shape)
+                assert_array_equal(mp.to_cpu(b), a)
+
+    def test_out_of_band(self):
+        if pickle.HIGHEST_PROTOCOL < 5:
+            return
+        a = np.arange(1000, dtype=np.float64)
+        buffers = []
+        data = pickle.dumps(mp.to_mic(a), protocol=5,
+                            buffer_callback=buffers.append)
+        assert_equal(len(buffers), 1)
+        # the payload does not travel in the pickle stream
+        assert len(data) < a.nbytes
+        b = pickle.loads(data, buffers=buffers)
+        assert_array_equal(mp.to_cpu(b), a)
@@ -0,0 +1,119 @@
+from __future__ import division, absolute_import, print_function
+
+import gc
+
+import numpy as np
+from numpy.testing import (assert_equal, assert_array_equal,
+                           assert_allclose, assert_raises)
+
+import micpy as mp
+
+# large enough to be tracked, see MPY_RESIDENCY_MIN_BYTES
+N = 1 << 14
+
+
+class TestResidency(object):
+
+    def setup(self):
+        self.residency = mp.set_residency(True)
+        self.a = np.arange(N, dtype=np.float64)
+        self.b = np.linspace(0, 1, N)
+
+    def teardown(self):
+        mp.set_residency(self.residency)
+
+    def test_evict_and_refetch(self):
+        d = mp.to_mic(self.a)
+        assert_equal(d.resident, True)
+        assert_equal(d.evict(), True)
+        assert_equal(d.resident, False)
+        # already on the host
+        assert_equal(d.evict(), False)
+        assert_array_equal(mp.to_cpu(d), self.a)
+        assert_equal(d.resident, True)
+
+    def test_small_arrays_are_not_tracked(self):
+        d = mp.to_mic(np.arange(10, dtype=np.float64))
+        assert_equal(d.evict(), False)
+        assert_equal(d.resident, True)
+
+    def test_ufunc_operands_come_back(self):
+        da, db = mp.to_mic(self.a), mp.to_mic(self.b)
+        out = mp.empty(N, dtype=np.float64)
+        for x in (da, db, out):
+            assert_equal(x.evict(), True)
+        # two inputs and an output, all evicted
+        mp.add(da, db, out=out)
+        assert_allclose(mp.to_cpu(out), self.a + self.b)
+        assert_equal(out.evict(), True)
+        res = da * 2 + db
+        assert_allclose(mp.to_cpu(res), self.a * 2 + self.b)
+
+    def test_iterator_operands_come_back(self):
+        da = mp.to_mic(self.a.reshape(128, -1))
+        assert_equal(da.evict(), True)
+        # strided operands take the iterator loop
+        res = da[:, ::2] + da.T[::2, :].T
+        assert_allclose(mp.to_cpu(res),
+                        self.a.reshape(128, -1)[:, ::2] * 2)
+
+    def test_reductions_and_dot(self):
+        da, db = mp.to_mic(self.a), mp.to_mic(self.b)
+        da.evict()
+        db.evict()
+        assert_allclose(mp.to_cpu(da.sum()), self.a.sum())
+        db.evict()
+        assert_allclose(mp.to_cpu(mp.dot(da, db)), np.dot(self.a, self.b))
+        da.evict()
+        assert_equal(int(mp.to_cpu(da.argmax())), N - 1)
+
+    def test_pinned_array_is_not_evicted(self):
+        d = mp.to_mic(self.a)
+        d.pin_resident()
+        assert_equal(d.evict(), False)
+        d.unpin_resident()
+        assert_equal(d.evict(), True)
+        # pinning brings it back
+        d.pin_resident()
+        assert_equal(d.resident, True)
+        d.unpin_resident()
+        assert_raises(ValueError, d.unpin_resident)
+
+    def test_views_block_eviction(self):
+        d = mp.to_mic(self.a)
+        v = d[::2]
+        assert_equal(d.evict(), False)
+        assert_array_equal(mp.to_cpu(v), self.a[::2])
+        del v
+        gc.collect()
+        assert_equal(d.evict(), True)
+        # a view of an evicted array brings it back
+        v = d.reshape(2, -1)
+        assert_equal(d.resident, True)
+        assert_array_equal(mp.to_cpu(v), self.a.reshape(2, -1))
+
+    def test_interface_export_stays_resident(self):
+        d = mp.to_mic(self.a)
+        d.__mic_array_interface__
+        # the consumer may hold the pointer for as long as d lives
+        assert_equal(d.evict(), False)
+        d.__mic_array_interface__
+        assert_equal(d.evict(), False)
+
+    def test_stats(self):
+        before = mp.residency_stats()
+        d = mp.to_mic(self.a)
+        d.evict()
+        mid = mp.residency_stats()
+        assert_equal(mid['evictions'] - before['evictions'], 1)
+        assert_equal(mid['evicted_bytes'] - before['evicted_bytes'],
+                     d.nbytes)
+        assert_equal(mid['on_host'] - before['on_host'], 1)
+        mp.to_cpu(d)
+        after = mp.residency_stats()
+        assert_equal(after['fetches'] - mid['fetches'], 1)
+        assert_equal(after['fetched_bytes'] - mid['fetched_bytes'], d.nbytes)
+        assert_equal(after['on_host'], before['on_host'])
+        del d
+        gc.collect()
+        assert_equal(mp.residency_stats()['resident'], before['resident'])
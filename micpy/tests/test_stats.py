@@ -0,0 +1,108 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import (assert_, assert_equal, assert_allclose,
+                           assert_raises)
+
+import micpy as mp
+
+# larger than MPY_STATS_BLOCK, so that every cell merges several blocks
+N = 10000
+
+
+class TestMeanVar(object):
+
+    def setup(self):
+        rng = np.random.RandomState(7)
+        self.a = rng.standard_normal(N) * 3 + 1e6
+
+    def _check(self, a, axis=None, ddof=0, rtol=1e-10):
+        d = mp.to_mic(a)
+        assert_allclose(mp.to_cpu(d.mean(axis=axis)),
+                        a.mean(axis=axis), rtol=rtol)
+        assert_allclose(mp.to_cpu(d.var(axis=axis, ddof=ddof)),
+                        a.var(axis=axis, ddof=ddof), rtol=rtol)
+        assert_allclose(mp.to_cpu(d.std(axis=axis, ddof=ddof)),
+                        a.std(axis=axis, ddof=ddof), rtol=rtol)
+
+    def test_blocks_merge(self):
+        # the large offset would cancel out in a sum of squares
+        for ddof in (0, 1, 2):
+            self._check(self.a, ddof=ddof, rtol=1e-7)
+            self._check(self.a[:4097], ddof=ddof, rtol=1e-7)
+
+    def test_rows_and_columns(self):
+        a = self.a[:300 * 30].reshape(300, 30) - 1e6
+        for ddof in (0, 1):
+            for axis in (None, 0, 1):
+                self._check(a, axis=axis, ddof=ddof)
+                self._check(a.T, axis=axis, ddof=ddof)
+                self._check(np.asfortranarray(a), axis=axis, ddof=ddof)
+
+    def test_column_tiles(self):
+        # cells side by side: a partial tile of them, and partial blocks
+        a = self.a[:70 * 130].reshape(70, 130) - 1e6
+        self._check(a, axis=0, ddof=1)
+        a = self.a[:N].reshape(25, 400) - 1e6
+        self._check(a, axis=0, ddof=1)
+
+    def test_strided_views(self):
+        a = self.a.reshape(40, 250) - 1e6
+        for v in (a[::2], a[:, 1::3], a[::-3, ::2],
+                  a.reshape(40, 10, 25)[:, ::2]):
+            for axis in range(v.ndim):
+                self._check(v, axis=axis, ddof=1)
+            self._check(v, ddof=1)
+
+    def test_multiple_axes(self):
+        a = self.a[:8 * 9 * 10].reshape(8, 9, 10) - 1e6
+        d = mp.to_mic(a)
+        for axis in ((0, 2), (1, 2), (0, 1)):
+            assert_allclose(mp.to_cpu(d.var(axis=axis, ddof=1)),
+                            a.var(axis=axis, ddof=1))
+            assert_allclose(mp.to_cpu(d[:, ::2].var(axis=axis)),
+                            a[:, ::2].var(axis=axis))
+        m = d.mean(axis=(0, 2), keepdims=True)
+        assert_equal(m.shape, (1, 9, 1))
+
+    def test_integers_and_bool(self):
+        a = np.abs((self.a[:1000].reshape(50, 20) - 1e6) * 10)
+        a = a.astype(np.int64)
+        for dtype in (np.int8, np.uint8, np.int16, np.uint32, np.int64,
+                      np.uint64, np.bool_):
+            x = a.astype(dtype)
+            for axis in (None, 0, 1):
+                self._check(x, axis=axis, ddof=1)
+            assert_equal(mp.to_mic(x).mean().dtype, np.float64)
+
+    def test_float32_and_half(self):
+        a = self.a[:1000].reshape(50, 20) - 1e6
+        for dtype in (np.float32, np.float16):
+            x = a.astype(dtype)
+            d = mp.to_mic(x)
+            assert_equal(d.var(axis=0).dtype, np.dtype(dtype))
+            assert_allclose(mp.to_cpu(d.var(axis=0, ddof=1)),
+                            x.astype(np.float64).var(axis=0, ddof=1),
+                            rtol=1e-3)
+
+    def test_ddof_not_below_count(self):
+        d = mp.to_mic(np.arange(6, dtype=np.float64).reshape(2, 3))
+        # as numpy, n - ddof is clipped to 0
+        for ddof in (2, 3):
+            assert_(np.all(np.isinf(mp.to_cpu(d.var(axis=0, ddof=ddof)))))
+
+    def test_empty(self):
+        d = mp.to_mic(np.zeros((0, 3)))
+        assert_(np.all(np.isnan(mp.to_cpu(d.mean(axis=0)))))
+        assert_(np.all(np.isnan(mp.to_cpu(d.var(axis=0)))))
+        assert_equal(d.var(axis=1).shape, (0,))
+
+    def test_mean_std(self):
+        a = self.a[:1200].reshape(40, 30)
+        mean, std = mp.mean_std(mp.to_mic(a), axis=0, ddof=1)
+        assert_allclose(mp.to_cpu(mean), a.mean(axis=0))
+        assert_allclose(mp.to_cpu(std), a.std(axis=0, ddof=1), rtol=1e-7)
+
+    def test_complex_raises(self):
+        d = mp.to_mic(np.ones(4, dtype=np.complex128))
+        assert_raises(TypeError, mp.mean_std, d)
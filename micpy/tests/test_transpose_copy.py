@@ -0,0 +1,68 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal
+
+import micpy as mp
+
+# side of the tiles, see MPY_TRANSPOSE_TILE
+TILE = 32
+
+
+class TestTransposeCopy(object):
+
+    def _check(self, a):
+        d = mp.to_mic(a)
+        for order in ('C', 'F'):
+            for x, y in ((d, a), (d.T, a.T)):
+                c = x.copy(order=order)
+                assert_equal(c.flags.c_contiguous, order == 'C')
+                assert_array_equal(mp.to_cpu(c), y)
+
+    def test_itemsizes(self):
+        # 16 bytes items are only 8 bytes aligned
+        for dtype in (np.int8, np.int16, np.float32, np.float64,
+                      np.complex64, np.complex128):
+            a = np.arange(3 * TILE * (2 * TILE + 5)).astype(dtype)
+            if a.dtype.kind == 'c':
+                a = a + 1j * a[::-1]
+            self._check(a.reshape(3 * TILE, -1))
+
+    def test_edge_tiles(self):
+        for shape in ((TILE, TILE), (TILE + 1, 2 * TILE - 1),
+                      (5 * TILE + 3, TILE + 7)):
+            self._check(np.arange(np.prod(shape), dtype=np.float64)
+                        .reshape(shape))
+
+    def test_below_tile(self):
+        # either axis shorter than a tile goes row by row
+        for shape in ((TILE - 1, 4 * TILE), (4 * TILE, TILE - 1), (1, 100)):
+            self._check(np.arange(np.prod(shape), dtype=np.float64)
+                        .reshape(shape))
+
+    def test_batches(self):
+        a = np.arange(4 * 40 * 50, dtype=np.float64).reshape(4, 40, 50)
+        d = mp.to_mic(a)
+        # a batch of transposes along the outer axis
+        c = d.transpose(0, 2, 1).copy()
+        assert_array_equal(mp.to_cpu(c), a.transpose(0, 2, 1))
+        # the batch axis inside
+        c = d.transpose(2, 0, 1).copy()
+        assert_array_equal(mp.to_cpu(c), a.transpose(2, 0, 1))
+        assert_array_equal(mp.to_cpu(d.copy(order='F')), a)
+
+    def test_strided_sides(self):
+        a = np.arange(100 * 90, dtype=np.int64).reshape(100, 90)
+        d = mp.to_mic(a)
+        # rows are not contiguous on the source
+        assert_array_equal(mp.to_cpu(d[::2, ::3].T.copy()),
+                           a[::2, ::3].T)
+        assert_array_equal(mp.to_cpu(d[:, 7:80].T.copy()), a[:, 7:80].T)
+
+    def test_with_cast(self):
+        # not the same type, the cast path does the copy
+        a = np.arange(64 * 64, dtype=np.int32).reshape(64, 64)
+        d = mp.to_mic(a)
+        c = mp.empty((64, 64), dtype=np.float64)
+        c[...] = d.T
+        assert_array_equal(mp.to_cpu(c), a.T.astype(np.float64))
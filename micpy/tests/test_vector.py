@@ -0,0 +1,80 @@
+from __future__ import division, absolute_import, print_function
+
+import numpy as np
+from numpy.testing import assert_equal, assert_array_equal, assert_raises
+
+import micpy as mp
+
+
+class TestDeviceVector(object):
+
+    def test_append_doubles(self):
+        v = mp.DeviceVector(np.int64, capacity=4)
+        capacities = []
+        for i in range(37):
+            v.append(i)
+            capacities.append(v.capacity)
+        assert_equal(len(v), 37)
+        assert_equal(sorted(set(capacities)), [4, 8, 16, 32, 64])
+        assert_array_equal(mp.to_cpu(v.array), np.arange(37))
+
+    def test_extend(self):
+        v = mp.DeviceVector(np.float32)
+        v.extend(np.arange(5))
+        v.extend(mp.to_mic(np.arange(5, 105, dtype=np.float32)))
+        v.extend([])
+        assert_array_equal(np.asarray(v), np.arange(105, dtype=np.float32))
+        v.pop(5)
+        v.append(-1)
+        assert_array_equal(mp.to_cpu(v.array)[-3:], [98, 99, -1])
+        assert_raises(IndexError, v.pop, 200)
+
+    def test_grow_with_a_view_alive(self):
+        v = mp.DeviceVector(np.int32, capacity=8)
+        v.extend(np.arange(8))
+        view = v.array
+        # the buffer cannot be resized in place, it moves
+        v.extend(np.arange(8, 20))
+        assert_array_equal(mp.to_cpu(v.array), np.arange(20))
+        assert_array_equal(mp.to_cpu(view), np.arange(8))
+
+    def test_shrink_to_fit(self):
+        v = mp.DeviceVector(np.float64, capacity=100)
+        v.extend(np.linspace(0, 1, 30))
+        v.shrink_to_fit()
+        assert_equal(v.capacity, 30)
+        assert_array_equal(mp.to_cpu(v.array), np.linspace(0, 1, 30))
+        v.clear()
+        v.shrink_to_fit()
+        assert_equal(v.capacity, 1)
+        assert_equal(len(v), 0)
+
+
+class TestResize(object):
+
+    def test_grow_and_shrink(self):
+        a = np.arange(100, dtype=np.float64)
+        d = mp.to_mic(a)
+        # grown a little, then with room to spare: the data are kept and
+        # the new elements are zero
+        d.resize(120)
+        assert_array_equal(mp.to_cpu(d)[:100], a)
+        assert_array_equal(mp.to_cpu(d)[100:], 0)
+        d.resize(150)
+        assert_array_equal(mp.to_cpu(d)[:100], a)
+        assert_array_equal(mp.to_cpu(d)[100:], 0)
+        # within the block, then below a quarter of it, which gives the
+        # room back
+        d.resize(60)
+        assert_array_equal(mp.to_cpu(d), a[:60])
+        d.resize(10)
+        assert_array_equal(mp.to_cpu(d), a[:10])
+        d.resize(50)
+        assert_array_equal(mp.to_cpu(d)[:10], a[:10])
+        assert_array_equal(mp.to_cpu(d)[10:], 0)
+
+    def test_referenced(self):
+        d = mp.to_mic(np.arange(10))
+        v = d[2:]
+        assert_raises(ValueError, d.resize, 20)
+        assert_raises(ValueError, v.resize, 20)
@@ -0,0 +1,236 @@
+/*
+ * Per (ufunc, dtype, size bucket, device) tuning of the OpenMP inner loops.
+ *
+ * The table is filled from python (see micpy/autotune.py) and looked up
+ * on the host right before an inner loop is launched. The chosen
+ * parameters are mapped into the target region and applied to it with
+ * mpy_loop_tuning_apply.
+ */
+#define NPY_NO_DEPRECATED_API NPY_API_VERSION
+
+#include "Python.h"
+
+#include "npy_config.h"
+#define PY_ARRAY_UNIQUE_SYMBOL _mpy_umathmodule_ARRAY_API
+#define NO_IMPORT_ARRAY
+
+#include <numpy/arrayobject.h>
+#include <numpy/ufuncobject.h>
+#include <numpy/npy_3kcompat.h>
+
+#define PyMicArray_API_UNIQUE_NAME _mpy_umathmodule_MICARRAY_API
+#define PyMicArray_NO_IMPORT
+#include <multiarray/arrayobject.h>
+#include <multiarray/multiarray_api.h>
+
+#define _MICARRAY_UMATHMODULE
+#include "loop_tuning.h"
+
+#define MPY_TUNING_MAXENTRIES 128
+#define MPY_TUNING_NAMELEN 32
+
+typedef struct {
+    char name[MPY_TUNING_NAMELEN];
+    int type_num;
+    int device;
+    npy_uint64 mask;    /* bit b set when params[b] is tuned */
+    MpyLoopTuning params[MPY_TUNING_NBUCKETS];
+} tuning_entry;
+
+static tuning_entry tuning_table[MPY_TUNING_MAXENTRIES];
+static int tuning_nentries = 0;
+
+static const MpyLoopTuning default_tuning = {0, OMP_CHUNKSIZE, 0};
+
+static NPY_INLINE int
+size_bucket(npy_intp n)
+{
+    int b = 0;
+    while (n > 1) {
+        n >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+static tuning_entry *
+find_entry(const char *name, int type_num, int device)
+{
+    int i;
+    for (i = 0; i < tuning_nentries; ++i) {
+        tuning_entry *e = &tuning_table[i];
+        if (e->type_num == type_num && e->device == device &&
+                strncmp(e->name, name, MPY_TUNING_NAMELEN) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Fill tuning with the parameters for running ufunc over n elements of
+ * type_num on device. The nearest tuned bucket not larger than n is
+ * preferred, then the smallest tuned one; untuned loops get defaults.
+ */
+NPY_NO_EXPORT void
+mpy_loop_tuning_get(PyUFuncObject *ufunc, int type_num,
+                    npy_intp n, int device, MpyLoopTuning *tuning)
+{
+    tuning_entry *e;
+    npy_uint64 below;
+    int b;
+
+    if (tuning_nentries == 0 || ufunc == NULL || ufunc->name == NULL ||
+            (e = find_entry(ufunc->name, type_num, device)) == NULL) {
+        *tuning = default_tuning;
+        return;
+    }
+
+    b = size_bucket(n);
+    below = (b >= MPY_TUNING_NBUCKETS - 1) ? e->mask
+                        : e->mask & ((((npy_uint64)1) << (b + 1)) - 1);
+    if (below) {
+        while (!(below & (((npy_uint64)1) << b))) {
+            --b;
+        }
+    }
+    else {
+        b = 0;
+        while (!(e->mask & (((npy_uint64)1) << b))) {
+            ++b;
+        }
+    }
+    *tuning = e->params[b];
+}
+
+NPY_NO_EXPORT PyObject *
+mpy_set_loop_tuning(PyObject *NPY_UNUSED(dummy), PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"ufunc", "dtype", "bucket", "device",
+                             "nthreads", "chunk", "cutoff", NULL};
+    const char *name;
+    PyArray_Descr *dtype = NULL;
+    int bucket, device, nthreads = 0, chunk = OMP_CHUNKSIZE;
+    npy_intp cutoff = 0;
+    tuning_entry *e;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "sO&ii|iin:_set_loop_tuning",
+                                     kwlist,
+                                     &name,
+                                     PyArray_DescrConverter, &dtype,
+                                     &bucket, &device,
+                                     &nthreads, &chunk, &cutoff)) {
+        Py_XDECREF(dtype);
+        return NULL;
+    }
+
+    if (bucket < 0 || bucket >= MPY_TUNING_NBUCKETS) {
+        PyErr_Format(PyExc_ValueError,
+                     "bucket must be within [0, %d)", MPY_TUNING_NBUCKETS);
+        goto fail;
+    }
+    /*
+     * Not checked against the number of devices: that would start the
+     * offload runtime while the cache is loaded at import. Entries of
+     * absent devices are never looked up.
+     */
+    if (device < 0) {
+        PyErr_SetString(PyExc_ValueError, "device must be non-negative");
+        goto fail;
+    }
+    if (nthreads < 0 || chunk <= 0 || cutoff < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "nthreads and cutoff must be non-negative "
+                        "and chunk must be positive");
+        goto fail;
+    }
+    if (strlen(name) >= MPY_TUNING_NAMELEN) {
+        PyErr_Format(PyExc_ValueError, "ufunc name '%s' is too long", name);
+        goto fail;
+    }
+
+    e = find_entry(name, dtype->type_num, device);
+    if (e == NULL) {
+        if (tuning_nentries == MPY_TUNING_MAXENTRIES) {
+            PyErr_SetString(PyExc_RuntimeError, "loop tuning table is full");
+            goto fail;
+        }
+        e = &tuning_table[tuning_nentries];
+        memset(e, 0, sizeof(*e));
+        strcpy(e->name, name);
+        e->type_num = dtype->type_num;
+        e->device = device;
+        ++tuning_nentries;
+    }
+    e->params[bucket].nthreads = nthreads;
+    e->params[bucket].chunk = chunk;
+    e->params[bucket].cutoff = cutoff;
+    e->mask |= ((npy_uint64)1) << bucket;
+
+    Py_DECREF(dtype);
+    Py_RETURN_NONE;
+
+fail:
+    Py_DECREF(dtype);
+    return NULL;
+}
+
+/*
+ * Return the tuning table as a list of
+ * (ufunc, dtype, bucket, device, nthreads, chunk, cutoff) tuples.
+ */
+NPY_NO_EXPORT PyObject *
+mpy_get_loop_tuning(PyObject *NPY_UNUSED(dummy), PyObject *args)
+{
+    PyObject *ret, *item;
+    PyArray_Descr *descr;
+    int i, b;
+
+    if (!PyArg_ParseTuple(args, ":_get_loop_tuning")) {
+        return NULL;
+    }
+
+    ret = PyList_New(0);
+    if (ret == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < tuning_nentries; ++i) {
+        tuning_entry *e = &tuning_table[i];
+        descr = PyArray_DescrFromType(e->type_num);
+        if (descr == NULL) {
+            goto fail;
+        }
+        for (b = 0; b < MPY_TUNING_NBUCKETS; ++b) {
+            if (!(e->mask & (((npy_uint64)1) << b))) {
+                continue;
+            }
+            item = Py_BuildValue("(sOiiiin)", e->name, (PyObject *)descr,
+                                 b, e->device,
+                                 e->params[b].nthreads,
+                                 e->params[b].chunk,
+                                 e->params[b].cutoff);
+            if (item == NULL || PyList_Append(ret, item) < 0) {
+                Py_XDECREF(item);
+                Py_DECREF(descr);
+                goto fail;
+            }
+            Py_DECREF(item);
+        }
+        Py_DECREF(descr);
+    }
+    return ret;
+
+fail:
+    Py_DECREF(ret);
+    return NULL;
+}
+
+NPY_NO_EXPORT PyObject *
+mpy_clear_loop_tuning(PyObject *NPY_UNUSED(dummy), PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":_clear_loop_tuning")) {
+        return NULL;
+    }
+    tuning_nentries = 0;
+    Py_RETURN_NONE;
+}
@@ -0,0 +1,99 @@
+#ifndef _MPY_UMATH_LOOP_TUNING_H_
+#define _MPY_UMATH_LOOP_TUNING_H_
+
+#include <omp.h>
+#include <numpy/npy_common.h>
+
+/*
+ * Runtime parameters of the OpenMP inner loops.
+ *
+ * nthreads : team size of the parallel loops, 0 means runtime default
+ * chunk    : static schedule chunk size in bytes
+ * cutoff   : number of elements below which the loops run serially
+ */
+typedef struct {
+    int nthreads;
+    int chunk;
+    npy_intp cutoff;
+} MpyLoopTuning;
+
+/* chunksize (in bytes) for OpenMP iteration scheduling when not tuned */
+#define OMP_CHUNKSIZE   256
+
+/* number of power-of-two size buckets */
+#define MPY_TUNING_NBUCKETS 64
+
+/* ICVs of a target region changed by mpy_loop_tuning_apply */
+typedef struct {
+    int nthreads;
+    omp_sched_t kind;
+    int chunk;
+} MpyLoopICVs;
+
+#pragma omp declare target
+/*
+ * Apply the tuning of a launch over n elements to the target region
+ * running it, before the inner loop is called. The team size and the
+ * chunk go into the nthreads-var and run-sched-var ICVs, which belong to
+ * the region: launches running at the same time on one device, or on
+ * the host, do not see each other's parameters. A launch of at most
+ * cutoff elements gets a team of one.
+ *
+ * The offload runtime may keep the ICVs of its threads from one region
+ * to the next (set_device_threads relies on it), so the previous values
+ * are saved and put back by mpy_loop_tuning_restore after the loop.
+ */
+static NPY_INLINE void
+mpy_loop_tuning_apply(MpyLoopTuning tuning, npy_intp n, MpyLoopICVs *saved)
+{
+    saved->nthreads = omp_get_max_threads();
+    omp_get_schedule(&saved->kind, &saved->chunk);
+
+    if (n <= tuning.cutoff) {
+        omp_set_num_threads(1);
+    }
+    else if (tuning.nthreads > 0) {
+        omp_set_num_threads(tuning.nthreads);
+    }
+    /* the chunk stays in bytes, MPY_LOOP_CHUNK scales it to the type */
+    omp_set_schedule(omp_sched_static, tuning.chunk);
+}
+
+static NPY_INLINE void
+mpy_loop_tuning_restore(const MpyLoopICVs *saved)
+{
+    omp_set_num_threads(saved->nthreads);
+    omp_set_schedule(saved->kind, saved->chunk);
+}
+
+static NPY_INLINE int
+mpy_loop_chunk(int size)
+{
+    omp_sched_t kind;
+    int chunk;
+
+    omp_get_schedule(&kind, &chunk);
+    return (chunk > size ? chunk : OMP_CHUNKSIZE) / size;
+}
+#pragma omp end declare target
+
+#define MPY_LOOP_CHUNK(size) mpy_loop_chunk((int)(size))
+
+#ifdef _MICARRAY_UMATHMODULE
+
+NPY_NO_EXPORT void
+mpy_loop_tuning_get(PyUFuncObject *ufunc, int type_num,
+                    npy_intp n, int device, MpyLoopTuning *tuning);
+
+NPY_NO_EXPORT PyObject *
+mpy_set_loop_tuning(PyObject *NPY_UNUSED(dummy), PyObject *args, PyObject *kwds);
+
+NPY_NO_EXPORT PyObject *
+mpy_get_loop_tuning(PyObject *NPY_UNUSED(dummy), PyObject *args);
+
+NPY_NO_EXPORT PyObject *
+mpy_clear_loop_tuning(PyObject *NPY_UNUSED(dummy), PyObject *args);
+
+#endif
+
+#endif
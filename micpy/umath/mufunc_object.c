@@ -51,6 +51,7 @@
 #include "mufunc_object.h"
 #include "output_creators.h"
 #include "reduction.h"
+#include "loop_tuning.h"
 
 /* Some useful macros */
 #define CPU_DEVICE (omp_get_initial_device())
@@ -170,6 +171,41 @@ _on_same_device(PyUFuncObject *ufunc, PyMicArrayObject **op)
     return 0;
 }
 
+/*
+ * Pin the operands on their device while the loops use their data
+ * pointers, see multiarray/residency.h. NULL operands are skipped.
+ * Returns -1 with none of them pinned on failure.
+ */
+static int
+_pin_operands(PyMicArrayObject **op, int nop)
+{
+    int i;
+
+    for (i = 0; i < nop; ++i) {
+        if (op[i] != NULL && PyMicArray_Pin(op[i]) < 0) {
+            while (--i >= 0) {
+                if (op[i] != NULL) {
+                    PyMicArray_Unpin(op[i]);
+                }
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void
+_unpin_operands(PyMicArrayObject **op, int nop)
+{
+    int i;
+
+    for (i = 0; i < nop; ++i) {
+        if (op[i] != NULL) {
+            PyMicArray_Unpin(op[i]);
+        }
+    }
+}
+
 /*
  * fpstatus is the ufunc_formatted hardware status
  * errmask is the handling mask specified by the user.
@@ -408,7 +444,7 @@ ufunc_pre_typeresolver(PyUFuncObject *ufunc, PyMicArrayObject **op,
     /* Change array data to buffer address */
     for (i = 0; i < ufunc->nin; ++i) {
         if (PyMicArray_NDIM(op[i]) == 0) {
-            PyMicArray_DATA(op[i]) = &(buf[i*bufsize]);
+            op[i]->data = (char *)&(buf[i*bufsize]);
         }
     }
 }
@@ -420,7 +456,7 @@ ufunc_post_typeresolver(PyUFuncObject *ufunc, PyMicArrayObject **op,
     int i;
     for (i = 0; i < ufunc->nin; ++i) {
         if (PyMicArray_NDIM(op[i]) == 0) {
-            PyMicArray_DATA(op[i]) = ptrs[i];
+            op[i]->data = ptrs[i];
         }
     }
 }
@@ -927,7 +963,9 @@ check_for_trivial_loop(PyUFuncObject *ufunc,
 }
 
 static void
-trivial_two_operand_loop(PyMicArrayObject **op,
+trivial_two_operand_loop(PyUFuncObject *ufunc,
+                    PyArray_Descr **dtypes,
+                    PyMicArrayObject **op,
                     PyUFuncGenericFunction innerloop,
                     void *innerloopdata)
 {
@@ -935,6 +973,7 @@ trivial_two_operand_loop(PyMicArrayObject **op,
     npy_intp stride0, stride1;
     npy_intp count;
     int needs_api, device;
+    MpyLoopTuning tuning;
     MPY_TARGET_MIC PyUFuncGenericFunction offloop = innerloop;
     MPY_TARGET_MIC void (*offdata)(void) = innerloopdata;
 
@@ -950,25 +989,33 @@ trivial_two_operand_loop(PyMicArrayObject **op,
                                               data0, data1,
                                               stride0, stride1);
     NPY_UF_DBG_PRINT1("two operand loop count %d\n", (int)count);
+    mpy_loop_tuning_get(ufunc, dtypes[0]->type_num, count, device, &tuning);
 
     if (!needs_api) {
         NPY_BEGIN_THREADS_THRESHOLDED(count);
     }
 
-#pragma offload target(mic:device) in(offloop, offdata, count,\
-                                      data0, data1,\
-                                      stride0, stride1)
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: offloop, offdata, count,\
+                                          data0, data1,\
+                                          stride0, stride1, tuning)
     {
         char *data[] = {data0, data1};
         npy_intp stride[] = {stride0, stride1};
+        MpyLoopICVs saved;
+
+        mpy_loop_tuning_apply(tuning, count, &saved);
         offloop(data, &count, stride, offdata);
+        mpy_loop_tuning_restore(&saved);
     }
 
     NPY_END_THREADS;
 }
 
 static void
-trivial_three_operand_loop(PyMicArrayObject **op,
+trivial_three_operand_loop(PyUFuncObject *ufunc,
+                    PyArray_Descr **dtypes,
+                    PyMicArrayObject **op,
                     PyUFuncGenericFunction innerloop,
                     void *innerloopdata)
 {
@@ -976,6 +1023,7 @@ trivial_three_operand_loop(PyMicArrayObject **op,
     npy_intp stride0, stride1, stride2;
     npy_intp count;
     int needs_api, device;
+    MpyLoopTuning tuning;
     MPY_TARGET_MIC PyUFuncGenericFunction offloop = innerloop;
     MPY_TARGET_MIC void (*offdata)(void) = innerloopdata;
 
@@ -992,18 +1040,24 @@ trivial_three_operand_loop(PyMicArrayObject **op,
                                                 stride0, stride1, stride2);
 
     NPY_UF_DBG_PRINT1("three operand loop count %d\n", (int)count);
+    mpy_loop_tuning_get(ufunc, dtypes[0]->type_num, count, device, &tuning);
 
     if (!needs_api) {
         NPY_BEGIN_THREADS_THRESHOLDED(count);
     }
 
-#pragma offload target(mic:device) in(offloop, offdata, count,\
-                                      data0, data1, data2,\
-                                      stride0, stride1, stride2)
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: offloop, offdata, count,\
+                                          data0, data1, data2,\
+                                          stride0, stride1, stride2, tuning)
     {
         char *data[] = {data0, data1, data2};
         npy_intp stride[] = {stride0, stride1, stride2};
+        MpyLoopICVs saved;
+
+        mpy_loop_tuning_apply(tuning, count, &saved);
         offloop(data, &count, stride, offdata);
+        mpy_loop_tuning_restore(&saved);
     }
 
     NPY_END_THREADS;
@@ -1034,6 +1088,7 @@ iterator_loop(PyUFuncObject *ufunc,
     npy_intp *stride;
     npy_intp *count_ptr;
     int device;
+    MpyLoopTuning tuning;
 
     PyMicArrayObject **op_it;
     int new_count = 0;
@@ -1145,9 +1200,19 @@ iterator_loop(PyUFuncObject *ufunc,
         /* Execute the loop */
         do {
             //NPY_UF_DBG_PRINT1("iterator loop count %d\n", (int)*count_ptr);
-#pragma omp target device(device) map(to: offloop, offdata, count_ptr[0:1],\
-                                          dataptr[0:nop], stride[0:nop])
-            offloop((char **)dataptr, count_ptr, stride, offdata);
+            mpy_loop_tuning_get(ufunc, dtype[0]->type_num,
+                                *count_ptr, device, &tuning);
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: offloop, offdata, count_ptr[0:1],\
+                                          dataptr[0:nop], stride[0:nop],\
+                                          tuning)
+            {
+                MpyLoopICVs saved;
+
+                mpy_loop_tuning_apply(tuning, count_ptr[0], &saved);
+                offloop((char **)dataptr, count_ptr, stride, offdata);
+                mpy_loop_tuning_restore(&saved);
+            }
         } while (iternext(iter));
 
         NPY_END_THREADS;
@@ -1214,7 +1279,8 @@ execute_legacy_ufunc_loop(PyUFuncObject *ufunc,
                 }
 
                 NPY_UF_DBG_PRINT("trivial 1 input with allocated output\n");
-                trivial_two_operand_loop(op, innerloop, innerloopdata);
+                trivial_two_operand_loop(ufunc, dtypes, op,
+                                         innerloop, innerloopdata);
 
                 return 0;
             }
@@ -1225,7 +1291,8 @@ execute_legacy_ufunc_loop(PyUFuncObject *ufunc,
                                                            PyArray_TRIVIALLY_ITERABLE_OP_NOREAD)) {
 
                 NPY_UF_DBG_PRINT("trivial 1 input\n");
-                trivial_two_operand_loop(op, innerloop, innerloopdata);
+                trivial_two_operand_loop(ufunc, dtypes, op,
+                                         innerloop, innerloopdata);
 
                 return 0;
             }
@@ -1263,7 +1330,8 @@ execute_legacy_ufunc_loop(PyUFuncObject *ufunc,
                 }
 
                 NPY_UF_DBG_PRINT("trivial 2 input with allocated output\n");
-                trivial_three_operand_loop(op, innerloop, innerloopdata);
+                trivial_three_operand_loop(ufunc, dtypes, op,
+                                           innerloop, innerloopdata);
 
                 return 0;
             }
@@ -1276,7 +1344,8 @@ execute_legacy_ufunc_loop(PyUFuncObject *ufunc,
                                                          PyArray_TRIVIALLY_ITERABLE_OP_NOREAD)) {
 
                 NPY_UF_DBG_PRINT("trivial 2 input\n");
-                trivial_three_operand_loop(op, innerloop, innerloopdata);
+                trivial_three_operand_loop(ufunc, dtypes, op,
+                                           innerloop, innerloopdata);
 
                 return 0;
             }
@@ -1485,7 +1554,7 @@ execute_fancy_ufunc_loop(PyUFuncObject *ufunc,
         do {
             NPY_UF_DBG_PRINT1("iterator loop count %d\n", (int)*countptr);
             npy_intp count = *countptr;
-#pragma omp target device(device) \
+#pragma omp target device(mpy_omp_launch(device)) \
             map(to: innerloop, count, innerloopdata,\
                     strides[0:nop_real])
             innerloop(NULL, strides,
@@ -1599,7 +1668,7 @@ PyMUFunc_GeneralizedFunction(PyUFuncObject *ufunc,
     PyArray_Descr *dtypes[NPY_MAXARGS];
 
     /* Use remapped axes for generalized ufunc */
-    int broadcast_ndim, iter_ndim;
+    int broadcast_ndim, iter_ndim, pinned = 0;
     int op_axes_arrays[NPY_MAXARGS][NPY_MAXDIMS];
     int *op_axes[NPY_MAXARGS];
 
@@ -1974,6 +2043,13 @@ PyMUFunc_GeneralizedFunction(PyUFuncObject *ufunc,
         }
     }
 
+    /* The iterator below holds the data pointers until the end */
+    if (_pin_operands(op, nop) < 0) {
+        retval = -1;
+        goto fail;
+    }
+    pinned = 1;
+
     /* Create temporary PyMicArrayObject * array */
     /* TODO cleanup this step */
     /*
@@ -2109,7 +2185,7 @@ PyMUFunc_GeneralizedFunction(PyUFuncObject *ufunc,
         }
         do {
             inner_dimensions[0] = *count_ptr;
-#pragma omp target device(device) \
+#pragma omp target device(mpy_omp_launch(device)) \
             map(to: innerloop, innerloopdata,\
                     inner_dimensions[0:NPY_MAXDIMS+1],\
                     inner_strides[0:nop+core_dim_ixs_size])
@@ -2165,6 +2241,7 @@ PyMUFunc_GeneralizedFunction(PyUFuncObject *ufunc,
 
     PyArray_free(inner_strides);
     NpyIter_Deallocate(iter);
+    _unpin_operands(op, nop);
     /* The caller takes ownership of all the references in op */
     for (i = 0; i < nop; ++i) {
         Py_XDECREF(dtypes[i]);
@@ -2181,6 +2258,9 @@ fail:
     NPY_UF_DBG_PRINT1("Returning failure code %d\n", retval);
     PyArray_free(inner_strides);
     NpyIter_Deallocate(iter);
+    if (pinned) {
+        _unpin_operands(op, nop);
+    }
     for (i = 0; i < nop; ++i) {
         Py_XDECREF(op[i]);
         op[i] = NULL;
@@ -2211,6 +2291,9 @@ PyMUFunc_GenericFunction(PyUFuncObject *ufunc,
     int retval = -1, subok = 0;
     int need_fancy = 0;
 
+    /* The operands pinned while the loops run */
+    PyMicArrayObject *pinned[NPY_MAXARGS + 1];
+
     PyArray_Descr *dtypes[NPY_MAXARGS];
 
     /* These parameters come from extobj= or from a TLS global */
@@ -2337,6 +2420,20 @@ PyMUFunc_GenericFunction(PyUFuncObject *ufunc,
         goto fail;
     }
 
+    /*
+     * Operands may have been evicted by the copies above, the pins bring
+     * them back. The outputs the loops allocate are pinned by their
+     * iterator, or used before any other device allocation.
+     */
+    for (i = 0; i < nop; ++i) {
+        pinned[i] = op[i];
+    }
+    pinned[nop] = wheremask;
+    if (_pin_operands(pinned, nop + 1) < 0) {
+        retval = -1;
+        goto fail;
+    }
+
     /* Start with the floating-point exception flags cleared */
     PyUFunc_clearfperr();
 
@@ -2355,6 +2452,7 @@ PyMUFunc_GenericFunction(PyUFuncObject *ufunc,
                             op, dtypes, order,
                             buffersize, arr_prep, arr_prep_args);
     }
+    _unpin_operands(pinned, nop + 1);
     if (retval < 0) {
         goto fail;
     }
@@ -2585,6 +2683,7 @@ reduce_loop(MpyIter *iter,
     npy_intp dataptrs_copy[3];
     npy_intp strides_copy[3];
     int needs_api, device;
+    MpyLoopTuning tuning;
 
     /* The normal selected inner loop */
     void *loopdata;
@@ -2644,11 +2743,20 @@ reduce_loop(MpyIter *iter,
             strides_copy[1] = strides[1];
             strides_copy[2] = strides[0];
 
-#pragma omp target device(device) map(to: dataptrs_copy, count,\
-                                          strides_copy,\
+            mpy_loop_tuning_get(ufunc, dtypes[0]->type_num,
+                                count, device, &tuning);
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: dataptrs_copy, count,\
+                                          strides_copy, tuning,\
                                           innerloop, innerloopdata)
-            innerloop((char **)dataptrs_copy, &count,
-                        strides_copy, innerloopdata);
+            {
+                MpyLoopICVs saved;
+
+                mpy_loop_tuning_apply(tuning, count, &saved);
+                innerloop((char **)dataptrs_copy, &count,
+                            strides_copy, innerloopdata);
+                mpy_loop_tuning_restore(&saved);
+            }
 
             /* Jump to the faster loop when skipping is done */
             if (skip_first_count == 0) {
@@ -2670,11 +2778,20 @@ reduce_loop(MpyIter *iter,
         strides_copy[1] = strides[1];
         strides_copy[2] = strides[0];
 
-#pragma omp target device(device) map(to: dataptrs_copy, strides_copy,\
+        mpy_loop_tuning_get(ufunc, dtypes[0]->type_num,
+                            *countptr, device, &tuning);
+#pragma omp target device(mpy_omp_launch(device)) \
+                   map(to: dataptrs_copy, strides_copy,\
                                           innerloop, innerloopdata,\
-                                          countptr[0:1])
-        innerloop((char **) dataptrs_copy, countptr,
-                    strides_copy, innerloopdata);
+                                          countptr[0:1], tuning)
+        {
+            MpyLoopICVs saved;
+
+            mpy_loop_tuning_apply(tuning, countptr[0], &saved);
+            innerloop((char **) dataptrs_copy, countptr,
+                        strides_copy, innerloopdata);
+            mpy_loop_tuning_restore(&saved);
+        }
     } while (iternext(iter));
 
 finish_loop:
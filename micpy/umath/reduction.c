@@ -155,7 +155,10 @@ conform_reduce_result(int ndim, npy_bool *axis_flags,
         return NULL;
     }
 
-    /* Allocate the view */
+    /* Allocate the view, its base pins out once set */
+    if (PyMicArray_Pin(out) < 0) {
+        return NULL;
+    }
     dtype = PyMicArray_DESCR(out);
     Py_INCREF(dtype);
 
@@ -168,6 +171,7 @@ conform_reduce_result(int ndim, npy_bool *axis_flags,
                                PyMicArray_DATA(out),
                                PyMicArray_FLAGS(out),
                                NULL);
+    PyMicArray_Unpin(out);
     if (ret == NULL) {
         return NULL;
     }
@@ -36,6 +36,7 @@
 
 #define _MICARRAY_UMATHMODULE
 #include "mufunc_object.h"
+#include "loop_tuning.h"
 //#include "reducion.h"
 
 /*
@@ -141,6 +142,15 @@ intern_strings(void)
 /*static PyTypeObject PyUFunc_Type;*/
 
 static struct PyMethodDef methods[] = {
+    {"_set_loop_tuning",
+        (PyCFunction)mpy_set_loop_tuning,
+        METH_VARARGS | METH_KEYWORDS, NULL},
+    {"_get_loop_tuning",
+        (PyCFunction)mpy_get_loop_tuning,
+        METH_VARARGS, NULL},
+    {"_clear_loop_tuning",
+        (PyCFunction)mpy_clear_loop_tuning,
+        METH_VARARGS, NULL},
     {NULL, NULL, 0, NULL}                /* sentinel */
 };
 
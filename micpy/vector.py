@@ -0,0 +1,140 @@
+"""
+Growable one-dimensional buffer in device memory.
+"""
+import numpy as np
+
+from . import multiarray
+
+__all__ = ['DeviceVector']
+
+
+class DeviceVector(object):
+    """
+    One-dimensional device array that grows as elements are appended.
+
+    The elements live in a device buffer larger than needed, whose
+    capacity doubles when it is full, so appending n elements copies
+    O(n) of them in all. Growing and shrinking the buffer happen on the
+    device, the data never go through the host.
+
+    Parameters
+    ----------
+    dtype : data-type, optional
+        Type of the elements, float64 by default.
+    capacity : int, optional
+        Number of elements to make room for upfront.
+    device : int, optional
+        Device of the buffer, the current device by default.
+
+    Examples
+    --------
+    >>> v = mp.DeviceVector(np.int64)
+    >>> for i in range(5):
+    ...     v.append(i)
+    >>> v.extend(np.arange(5, 10))
+    >>> mp.to_cpu(v.array)
+    array([0, 1, 2, 3, 4, 5, 6, 7, 8, 9])
+    """
+
+    def __init__(self, dtype=float, capacity=0, device=None):
+        if device is None:
+            device = multiarray.device()
+        self.dtype = np.dtype(dtype)
+        self.device = device
+        self._size = 0
+        self._buf = multiarray.empty(max(int(capacity), 1),
+                                     dtype=self.dtype, device=device)
+
+    @property
+    def capacity(self):
+        """Number of elements the buffer holds before it has to grow."""
+        return self._buf.shape[0]
+
+    def __len__(self):
+        return self._size
+
+    def reserve(self, capacity):
+        """Make room for at least `capacity` elements."""
+        if capacity > self.capacity:
+            self._regrow(capacity)
+
+    def _regrow(self, capacity):
+        try:
+            # in place on the device: the data are copied there, and the
+            # resize itself leaves room to grow when needed
+            self._buf.resize(capacity)
+        except ValueError:
+            # views of the buffer are alive, which keep the old one
+            self._move(capacity)
+
+    def _move(self, capacity):
+        buf = multiarray.empty(capacity, dtype=self.dtype, device=self.device)
+        if self._size > 0:
+            multiarray.copyto(multiarray._flat_chunk(buf, 0, self._size),
+                              self.array)
+        self._buf = buf
+
+    def _grow(self, n):
+        if self._size + n > self.capacity:
+            self._regrow(max(self._size + n, 2 * self.capacity))
+
+    def append(self, value):
+        """Append one element."""
+        self._grow(1)
+        multiarray.copyto(
+            multiarray._flat_chunk(self._buf, self._size, self._size + 1),
+            np.asarray(value, dtype=self.dtype).reshape(1))
+        self._size += 1
+
+    def extend(self, values):
+        """
+        Append the elements of `values`, a host or device array, in flat
+        order.
+        """
+        if not isinstance(values, multiarray.ndarray):
+            values = np.asarray(values, dtype=self.dtype)
+        n = values.size
+        if n == 0:
+            return
+        self._grow(n)
+        multiarray.copyto(
+            multiarray._flat_chunk(self._buf, self._size, self._size + n),
+            values.reshape(n))
+        self._size += n
+
+    def pop(self, n=1):
+        """Drop the last `n` elements."""
+        if not 0 <= n <= self._size:
+            raise IndexError("pop %d elements from a vector of %d"
+                             % (n, self._size))
+        self._size -= n
+
+    def clear(self):
+        """Drop all the elements, keeping the buffer."""
+        self._size = 0
+
+    def shrink_to_fit(self):
+        """
+        Shrink the buffer to the elements and give the rest of its device
+        memory back.
+        """
+        if self.capacity > max(self._size, 1):
+            # resize would keep the block until less than a quarter of it
+            # is in use, a new buffer is exactly the size of the elements
+            self._move(max(self._size, 1))
+
+    @property
+    def array(self):
+        """
+        Device array of the elements, a view of the buffer. It stays
+        valid when the vector grows, but then no longer follows it.
+        """
+        return multiarray._flat_chunk(self._buf, 0, self._size)
+
+    def __array__(self, dtype=None):
+        out = multiarray.to_cpu(self.array)
+        return out if dtype is None else out.astype(dtype)
+
+    def __repr__(self):
+        return "DeviceVector(size=%d, capacity=%d, dtype=%s, device=%d)" % (
+            self._size, self.capacity, self.dtype, self.device)
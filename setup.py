@@ -46,7 +46,9 @@ def add_multiarray_ext(config):
             'convert_datatype.c', 'dtype_transfer.c', 'mpymem_overlap.c',
             'nditer_templ.c.src', 'nditer_constr.c', 'nditer_api.c',
             'arraytypes.c.src', 'mpy_lowlevel_strided_loops.c.src',
-            'temp_elide.c' ,'multiarraymodule.c']
+            'temp_elide.c', 'staging.c', 'dlpack.c', 'numa.c',
+            'residency.c', 'ptrmap.c',
+            'multiarraymodule.c']
     multiarray_sources = [join(multiarray_dir, f) for f in multiarray_sources]
 
     #Add numpy/private/mem_overlap.c to sources
@@ -92,7 +94,7 @@ def add_umath_ext(config):
     umath_dir = join('micpy', 'umath')
 
     umath_sources = ['umathmodule.c', 'mufunc_object.c',
-                     'output_creators.c', 'reduction.c',
+                     'output_creators.c', 'reduction.c', 'loop_tuning.c',
                      'funcs.inc.src', 'loops.h.src', 'loops.c.src',
                      'simd.inc.src']
     umath_sources = [join(umath_dir, f) for f in umath_sources]
@@ -122,6 +124,7 @@ def configuration(parent_package='', top_path=None):
     config.add_subpackage('random',
                           subpackage_path=join('micpy', 'random'))
     config.add_extension('sayhello', ['sayhello.c'])
+    config.add_data_dir(('tests', join('micpy', 'tests')))
 
     return config
 